@@ -1,11 +1,134 @@
 #include <stdio.h>
+#include <thread>
 
 #include "AIPlayer.h"
 
-AIPlayer::AIPlayer (Board* brd, BoardGUI* brdgui, int difficulty) {
+AIPlayer::AIPlayer (Board* brd, BoardGUI* brdgui, int difficulty) : ownTable(0) {
   b = brd;
   bgui = brdgui;
   maxDepth = difficulty;
+  maxNodes = 0;
+  maxTimeMs = 0;
+  listener = NULL;
+  multiPV = 1;
+  nnue = NULL;
+  numNodes = 0;
+  stopped = false;
+  abortRequested = false;
+  searchDone = false;
+  completedDepth = 0;
+  lastReportMs = 0;
+  table = &ownTable;
+  mateTableMB = MATE_TABLE_MB;
+}
+
+void AIPlayer::setLimits(int depth, long long nodes, int timeMs) {
+  maxDepth = depth;
+  maxNodes = nodes;
+  maxTimeMs = timeMs;
+}
+
+void AIPlayer::setTranspositionTable(TranspositionTable* table) {
+  this->table = (table != NULL)? table : &ownTable;
+}
+
+void AIPlayer::setSearchListener(SearchListener* searchListener) {
+  listener = searchListener;
+}
+
+long long AIPlayer::getNumNodes() {
+  return numNodes;
+}
+
+int AIPlayer::getCompletedDepth() {
+  return completedDepth;
+}
+
+void AIPlayer::stop() {
+  abortRequested = true;
+}
+
+void AIPlayer::clearStop() {
+  abortRequested = false;
+}
+
+int AIPlayer::findMate(int maxMoves) {
+  if (!mateSolver) mateSolver.reset(new MateSolver(mateTableMB));
+  int result = mateSolver->solveShortest(b, maxMoves, maxNodes, maxTimeMs, &abortRequested);
+  numNodes = mateSolver->getNumNodes();
+  return result;
+}
+
+void AIPlayer::setMateTableSize(int memoryMB) {
+  if (memoryMB == mateTableMB) return;
+  mateTableMB = memoryMB;
+  mateSolver.reset();
+}
+
+std::string AIPlayer::getMateLineSAN() {
+  return mateSolver? mateSolver->getMateLineSAN() : "";
+}
+
+void AIPlayer::setMultiPV(int numLines) {
+  multiPV = (numLines < 1)? 1 : numLines;
+}
+
+int AIPlayer::getNumPVLines() {
+  return pvLines.size();
+}
+
+const AIPlayer::PVLine& AIPlayer::getPVLine(int index) {
+  return pvLines[index];
+}
+
+std::string AIPlayer::getPVLineSAN(int index) {
+  Board board = rootBoard;
+  std::string san;
+  const std::vector<int>& moves = pvLines[index].moves;
+  for (int i = 0; i < moves.size(); i++) {
+    if (i > 0) san += ' ';
+    san += board.getMoveSAN(moves[i]);
+    board.makeMove(moves[i]);
+  }
+  return san;
+}
+
+int AIPlayer::getElapsedMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void AIPlayer::checkLimits() {
+  int elapsedMs = getElapsedMs();
+  if ((maxNodes > 0 && numNodes >= maxNodes) || (maxTimeMs > 0 && elapsedMs >= maxTimeMs) || abortRequested) {
+    stopped = true;
+  }
+  // keep the GUI's node count moving during long depths
+  if (bgui != NULL && elapsedMs - lastReportMs >= REPORT_INTERVAL_MS) {
+    SearchInfo info;
+    fillSearchInfo(info, completedDepth);
+    if (infoQueue.push(info)) GUI::wakeUp();
+    lastReportMs = elapsedMs;
+  }
+}
+
+void AIPlayer::fillSearchInfo(SearchInfo& info, int depth) {
+  info.depth = depth;
+  info.nodes = numNodes;
+  info.timeMs = getElapsedMs();
+  info.nps = (info.timeMs > 0)? numNodes * 1000 / info.timeMs : 0;
+  info.score = 0;
+  info.bestMove = -1;
+  info.pvLength = 0;
+  if (pvLines.empty()) return;
+  info.score = pvLines[0].score;
+  info.bestMove = pvLines[0].moves[0];
+  for (int i = 0; i < pvLines[0].moves.size() && i < SearchInfo::MAX_PV_LENGTH; i++) {
+    info.pv[info.pvLength++] = pvLines[0].moves[i];
+  }
+}
+
+void AIPlayer::setNNUE(NNUE* net) {
+  nnue = net;
 }
 
 bool AIPlayer::isHuman() {
@@ -21,37 +144,142 @@ bool AIPlayer::isBoardDifferent() {
 }
 
 int AIPlayer::decideMove() {
+  // without a GUI, a stop is kept until clearStop, so that a stop sent just before the search isn't lost
+  if (bgui == NULL) return search();
+
+  // With a GUI, search a copy of the board in another thread.
+  // This thread keeps handling the GUI's events, and shows the search reports on the side bar.
+  Board* gameBoard = b;
+  Board searchBoard = *gameBoard;
+  b = &searchBoard;
+  abortRequested = false;
+  searchDone = false;
+  infoQueue.clear();
+  bgui->clearSearchInfo();
+
+  int move = -1;
+  std::thread searchThread([this, &move]() {
+    move = search();
+    searchDone = true;
+    GUI::wakeUp();
+  });
+  while (!searchDone) {
+    // sleep until an event or a report (the search wakes this thread up after each report)
+    // if user quit or return home, stop the search
+    int input = bgui->waitInput();
+    if (input == BoardGUI::INPUT_HOME || GUI::quit) abortRequested = true;
+
+    SearchInfo info;
+    while (infoQueue.pop(info)) {
+      bgui->setSearchInfo(info);
+      bgui->requestRedraw();
+    }
+    bgui->drawFrame();
+  }
+  searchThread.join();
+  b = gameBoard;
+
+  // the report of the last depth
+  SearchInfo info;
+  while (infoQueue.pop(info)) {
+    bgui->setSearchInfo(info);
+    bgui->requestRedraw();
+  }
+  bgui->drawFrame();
+
+  if (abortRequested) return -1;
+  return move;
+}
+
+int AIPlayer::search() {
   //saveBoard(); // uncomment if want to find bugs in board or AI
-  // numNodes = 0; // uncomment to check pruning's effect (see how many nodes the AI evaluates)
+  numNodes = 0;
+  stopped = false;
+  completedDepth = 0;
+  lastReportMs = 0;
+  startTime = std::chrono::steady_clock::now();
+
+  // let the board update the network's accumulator during search (or stop updating it)
+  if (b->getNNUE() != nnue) b->attachNNUE(nnue);
+  if (table == &ownTable && ownTable.getNumEntries() == 0) ownTable.resize(TranspositionTable::DEFAULT_MEMORY_MB);
+  table->newSearch();
 
   int color = b->getPlayer()? -1 : 1;
 
   int bestMove = -1;
-  int alpha = -2 * MATE_VALUE;
-  int beta = 2 * MATE_VALUE;
   int numMoves = b->getNumMoves();
+  pvLines.clear();
+  if (numMoves == 0) return -1;
+  rootBoard = *b;
 
-  // reorder moves
+  // reorder moves, the best move of a previous search first
   int moveOrder[numMoves];
   reorderMoves(moveOrder, numMoves, color);
+  const TranspositionTable::Entry* rootEntry = table->probe(b->getHashKey());
+  if (rootEntry != NULL) moveToFront(moveOrder, numMoves, rootEntry->move);
+  int numLines = (multiPV < numMoves)? multiPV : numMoves;
 
-  // Find the sub-tree with best value
-  // Instead of calling negamax(maxDepth, alpha, beta, color), the first ply moves are search separately
-  // because after evaluating each move, the piled up GUI events need to be handled.
-  for (int m = 0; m < numMoves; m++) {
-    b->makeMove(moveOrder[m]);
-    // get the value of the sub-tree
-    int val = -negamax(maxDepth-1, -beta, -alpha, -color);
-    b->undoMove();
-    // update the best value and cut off values
-    if (val > alpha) {
-      alpha = val;
-      bestMove = moveOrder[m];
-      if (alpha >= beta) break;
+  // Without limits, search maxDepth directly.
+  // With a node or time limit (or someone listening), deepen one ply at a time,
+  // so that a stopped search can still play the best move of the last completed depth.
+  bool deepening = (maxNodes > 0 || maxTimeMs > 0 || listener != NULL || bgui != NULL);
+  for (int depth = deepening? 1 : maxDepth; depth <= maxDepth; depth++) {
+    std::vector<PVLine> depthLines;
+
+    // Find the best line, then the best line among the remaining root moves, and so on.
+    // The moves of the lines already found are kept at the front of moveOrder and excluded from the next searches,
+    // so each search starts with a full window and the score of each line is exact.
+    for (int line = 0; line < numLines; line++) {
+      int alpha = -2 * MATE_VALUE;
+      int beta = 2 * MATE_VALUE;
+      int lineBestIndex = -1; // index of the line's move in moveOrder
+      PVLine pv;
+
+      // Instead of calling negamax(depth, alpha, beta, color, 0), the first ply moves are search separately
+      // because some of them are excluded, and the line of each move is kept.
+      for (int m = line; m < numMoves; m++) {
+        b->makeMove(moveOrder[m]);
+        // get the value of the sub-tree
+        int val = -negamax(depth-1, -beta, -alpha, -color, 1);
+        b->undoMove();
+        if (stopped) break;
+        // update the best value and its line
+        if (val > alpha) {
+          alpha = val;
+          lineBestIndex = m;
+          pv.score = val;
+          pv.moves.assign(1, moveOrder[m]);
+          pv.moves.insert(pv.moves.end(), &pvTable[1][1], &pvTable[1][pvLength[1]]);
+        }
+      }
+      if (stopped) break;
+      extendLine(pv.moves, depth);
+
+      // move the line's move just after the previous lines' moves: excluded from the next lines,
+      // and searched in this order in the next depth
+      int lineMove = moveOrder[lineBestIndex];
+      for (int m = lineBestIndex; m > line; m--) moveOrder[m] = moveOrder[m-1];
+      moveOrder[line] = lineMove;
+      depthLines.push_back(pv);
+    }
+    if (stopped) break; // this depth is incomplete, keep the lines of the previous depth
+
+    pvLines = depthLines;
+    bestMove = pvLines[0].moves[0];
+    completedDepth = depth;
+    table->store(b->getHashKey(), pvLines[0].score, bestMove, depth, TranspositionTable::BOUND_EXACT);
+
+    if (listener != NULL || bgui != NULL) {
+      SearchInfo info;
+      fillSearchInfo(info, depth);
+      if (listener != NULL) listener->onSearchInfo(info);
+      if (bgui != NULL && infoQueue.push(info)) GUI::wakeUp();
     }
-    // handle GUI events: if user quit, immediately
-    if (bgui->getInput() == BoardGUI::INPUT_HOME || GUI::quit) return -1;
   }
+  // stopped before the first depth completed
+  if (bestMove == -1) bestMove = moveOrder[0];
+  //pawnTable.printStats(); // uncomment to see how often pawn structure is reused
+
   // uncomment to check for board or AI bugs.
   //if (isBoardDifferent()) {
     //GUI::quit = true;
@@ -60,17 +288,20 @@ int AIPlayer::decideMove() {
   return bestMove;
 }
 
-int AIPlayer::negamax(int depth, int alpha, int beta, int color) {
-  //numNodes++; // uncomment to check pruning performance
+int AIPlayer::negamax(int depth, int alpha, int beta, int color, int ply) {
+  numNodes++;
+  if ((numNodes & 1023) == 0) checkLimits();
+  if (stopped) return 0; // the result is thrown away
   int numMoves = b->getNumMoves();
+  pvLength[ply] = ply;
 
   //////////////////////////////////////////////////////////////////
   // If reaches cut-off depth or a terminal node (end game node),
   // evaluate the board at that node and return the board's score.
   //////////////////////////////////////////////////////////////////
-  if (depth <= 0 || numMoves == 0) {
-    // get board's score for the player to move (color adjusts the sign of board's score)
-    int score = color * heuristicEval();
+  if (depth <= 0 || numMoves == 0 || ply >= MAX_PLY - 1) {
+    // get board's score for the player to move (resolving captures at the cut-off depth)
+    int score = (numMoves == 0)? color * heuristicEval() : quiesce(alpha, beta, color);
     // try to win early or lose late by adding or subtracting depth.
     if (score > 0) {
       score = score + depth;
@@ -80,6 +311,24 @@ int AIPlayer::negamax(int depth, int alpha, int beta, int color) {
     return score;
   }
 
+  //////////////////////////////////////////////////////////////////
+  // If the position was already searched deep enough, use its score.
+  // Else search its best move first.
+  //////////////////////////////////////////////////////////////////
+  uint64_t key = b->getHashKey();
+  const TranspositionTable::Entry* entry = table->probe(key);
+  int tableMove = -1;
+  if (entry != NULL) {
+    if (entry->depth >= depth) {
+      if (entry->bound == TranspositionTable::BOUND_EXACT
+          || (entry->bound == TranspositionTable::BOUND_LOWER && entry->score >= beta)
+          || (entry->bound == TranspositionTable::BOUND_UPPER && entry->score <= alpha)) {
+        return entry->score;
+      }
+    }
+    tableMove = entry->move;
+  }
+
   //////////////////////////////////////////////////////////////////
   // If node is not a terminal node,
   // evaluate each sub-tree and return the best value
@@ -88,25 +337,110 @@ int AIPlayer::negamax(int depth, int alpha, int beta, int color) {
   // reorder move so that the first few best moves are searched first
   int moveOrder[numMoves];
   reorderMoves(moveOrder, numMoves, color);
+  moveToFront(moveOrder, numMoves, tableMove);
 
+  // near the cut-off depth, don't search captures that lose material (unless escaping a check)
+  bool pruneBadCaptures = (depth <= SEE_PRUNING_DEPTH) && !b->isKingChecked();
+
+  int originalAlpha = alpha;
+  int bestMove = -1;
   for (int m = 0; m < numMoves; m++) {
+    if (pruneBadCaptures && m > 0 && b->isCapture(moveOrder[m]) && b->see(moveOrder[m]) < 0) continue;
     b->makeMove(moveOrder[m]);
-    int val = -negamax(depth-1, -beta, -alpha, -color);
+    int val = -negamax(depth-1, -beta, -alpha, -color, ply+1);
     b->undoMove();
     if (val > alpha) {
       alpha = val;
+      bestMove = moveOrder[m];
+      // this move followed by the best line of the child
+      pvTable[ply][ply] = moveOrder[m];
+      for (int i = ply + 1; i < pvLength[ply+1]; i++) pvTable[ply][i] = pvTable[ply+1][i];
+      pvLength[ply] = pvLength[ply+1];
       if (alpha >= beta) break;
     }
   }
+  if (stopped) return alpha; // incomplete, don't store it
+
+  int bound = (alpha >= beta)? TranspositionTable::BOUND_LOWER
+            : (alpha > originalAlpha)? TranspositionTable::BOUND_EXACT : TranspositionTable::BOUND_UPPER;
+  table->store(key, alpha, bestMove, depth, bound);
   return alpha;
 }
 
+void AIPlayer::extendLine(std::vector<int>& moves, int length) {
+  for (int i = 0; i < moves.size(); i++) b->makeMove(moves[i]);
+  int numMade = moves.size();
+  while (moves.size() < length && moves.size() < MAX_PLY) {
+    const TranspositionTable::Entry* entry = table->probe(b->getHashKey());
+    if (entry == NULL || entry->move < 0 || entry->move >= b->getNumMoves()) break;
+    moves.push_back(entry->move);
+    b->makeMove(entry->move);
+    numMade++;
+  }
+  for (int i = 0; i < numMade; i++) b->undoMove();
+}
+
+void AIPlayer::moveToFront(int* moveOrder, int numMoves, int move) {
+  if (move < 0 || move >= numMoves) return;
+  int m = 0;
+  while (moveOrder[m] != move) m++;
+  for (; m > 0; m--) moveOrder[m] = moveOrder[m-1];
+  moveOrder[0] = move;
+}
+
 const int AIPlayer::NUM_BEST_MOVES = 6;
 
+int AIPlayer::quiesce(int alpha, int beta, int color) {
+  numNodes++;
+  if ((numNodes & 1023) == 0) checkLimits();
+  if (stopped) return 0; // the result is thrown away
+
+  // the player to move can stop capturing (stand pat), so the static score is a lower bound
+  int standPat = color * heuristicEval();
+  int numMoves = b->getNumMoves();
+  if (numMoves == 0 || standPat >= beta) return standPat;
+  if (standPat > alpha) alpha = standPat;
+
+  // captures that don't lose material, the most winning first
+  int captures[numMoves];
+  int gains[numMoves];
+  int numCaptures = 0;
+  for (int m = 0; m < numMoves; m++) {
+    if (!b->isCapture(m)) continue;
+    int gain = b->see(m);
+    if (gain < 0) continue;
+    int n = numCaptures++;
+    while (n > 0 && gains[n-1] < gain) {
+      captures[n] = captures[n-1];
+      gains[n] = gains[n-1];
+      n--;
+    }
+    captures[n] = m;
+    gains[n] = gain;
+  }
+
+  for (int m = 0; m < numCaptures; m++) {
+    b->makeMove(captures[m]);
+    int val = -quiesce(-beta, -alpha, -color);
+    b->undoMove();
+    if (val > alpha) {
+      alpha = val;
+      if (alpha >= beta) break;
+    }
+  }
+  return alpha;
+}
+
 void AIPlayer::reorderMoves(int *moveOrder, int numMoves, int color) {
-  // Find the 1-ply score of each move
+  // Find the 1-ply score of each move.
+  // Captures are scored with the static exchange evaluation instead of making them.
   int score[numMoves];
+  int currentScore = color * heuristicEval();
   for(int m = 0; m < numMoves; m++) {
+    if (b->isCapture(m)) {
+      score[m] = currentScore + b->see(m);
+      continue;
+    }
     b->makeMove(m);
     score[m] = color * heuristicEval();
     b->undoMove();
@@ -237,6 +571,14 @@ int AIPlayer::heuristicEval() {
   //                       Not end board
   //////////////////////////////////////////////////////////////////
 
+  if (nnue != NULL) {
+    // keep the network's score away from mate scores
+    int score = b->evaluateNNUE();
+    if (score > MATE_VALUE / 2) score = MATE_VALUE / 2;
+    if (score < -MATE_VALUE / 2) score = -MATE_VALUE / 2;
+    return score;
+  }
+
   int score = 0; //the score of the board for white
   int material = 0;
   int piece;
@@ -275,5 +617,8 @@ int AIPlayer::heuristicEval() {
     kingSq = b->getKingSquare(Board::BLACK);
     score -= positionValues[6][kingSq];
   }
+
+  // pawn structure
+  score += pawnTable.probe(b);
   return score;
 }
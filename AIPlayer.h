@@ -1,33 +1,229 @@
 /***********************************************************************//**
  * A chess AI. Decide which move to make on a board by.
- * Uses negamax with alpha-beta pruning.
+ * Uses negamax with alpha-beta pruning and a transposition table.
  ***************************************************************************/
 
 #ifndef AIPLAYER_H
 #define AIPLAYER_H
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "Board.h"
 #include "BoardGUI.h"
+#include "MateSolver.h"
+#include "NNUE.h"
+#include "PawnHashTable.h"
 #include "Player.h"
+#include "SearchListener.h"
+#include "SPSCQueue.h"
+#include "TranspositionTable.h"
 
 
 class AIPlayer : public Player {
+  friend class TexelTuner; // reads the evaluation tables as starting values
+
   public:
     /**
      * @param brd: the board to consider.
-     * @param brdgui: the board GUI used to display the board.
+     * @param brdgui: the board GUI used to display the board. NULL when there is no GUI (tools).
      * @param difficulty: the number of moves (half-turn) the AI can look ahead.
      */
     AIPlayer(Board* brd, BoardGUI* brdgui, int difficulty);
     ~AIPlayer() {}
 
     bool isHuman();
+
+    /**
+     * Search the board and return the best move.
+     * With a GUI, the search runs in another thread while this thread keeps the GUI responsive,
+     * and shows the progress of the search on the GUI.
+     * @return the move's number in the board's move list, or -1 if the user quit during the search.
+     */
     int decideMove();
 
+    /**
+     * Switch the static evaluation between heuristicEval's tables and a neural network.
+     * @param net: a loaded network, or NULL to use the tables.
+     */
+    void setNNUE(NNUE* net);
+
+    /**
+     * Limit the search by nodes or time as well as by depth.
+     * With a node or time limit, the search deepens one ply at a time until a limit is reached,
+     * and plays the best move of the last completed depth.
+     * @param depth: the maximum number of half-turns to look ahead.
+     * @param nodes: the maximum number of nodes, 0 for no limit.
+     * @param timeMs: the maximum thinking time in milliseconds, 0 for no limit.
+     */
+    void setLimits(int depth, long long nodes, int timeMs);
+
+    /**
+     * Receive a SearchInfo after each completed depth. The search then always deepens one ply at a time.
+     * @param searchListener: the listener, or NULL to stop reporting.
+     */
+    void setSearchListener(SearchListener* searchListener);
+
+    /**
+     * @return the number of nodes searched by the last call to decideMove.
+     */
+    long long getNumNodes();
+
+    /**
+     * @return the last depth completed by the last call to decideMove, 0 if none.
+     */
+    int getCompletedDepth();
+
+    /**
+     * Stop the search of decideMove, from another thread. Without a GUI, decideMove then
+     * returns the best move of the last completed depth, and the stop lasts until clearStop:
+     * a stop that comes before the search starts stops it too.
+     * With a GUI, a stop before the search starts is ignored.
+     */
+    void stop();
+
+    /**
+     * Cancel a stop, before starting a search without a GUI (see stop).
+     */
+    void clearStop();
+
+    /**
+     * A line found by the search: a root move, followed by the best replies.
+     */
+    struct PVLine {
+      int score; /**< The score of the line, in the perspective of the player to move */
+      std::vector<int> moves; /**< Move numbers, each in the move list of the board after the previous moves */
+    };
+
+    /**
+     * Search the best numLines root moves with exact scores instead of only the best one.
+     * Each line is found by searching the root again without the moves of the previous lines,
+     * so the lines share move ordering and deepening with the first one.
+     * @param numLines: the number of lines, 1 for a normal search.
+     */
+    void setMultiPV(int numLines);
+
+    /**
+     * @return the number of lines found by the last call to decideMove.
+     */
+    int getNumPVLines();
+
+    /**
+     * @param index: 0 for the best line, up to getNumPVLines() - 1.
+     * @return a line found by the last call to decideMove, from its last completed depth.
+     */
+    const PVLine& getPVLine(int index);
+
+    /**
+     * @param index: 0 for the best line, up to getNumPVLines() - 1.
+     * @return the moves of the line in SAN, separated by spaces.
+     */
+    std::string getPVLineSAN(int index);
+
+    /**
+     * Use a transposition table owned by the caller, e.g. to keep it from game to game or to save it.
+     * Without it, the AI has its own table, kept from move to move while the AI lives.
+     * @param table: the table, or NULL to go back to the AI's own table.
+     */
+    void setTranspositionTable(TranspositionTable* table);
+
+    /**
+     * Mate-search mode: look for a forced mate by the player to move with a proof-number search
+     * (MateSolver) instead of the alpha-beta search. It runs in the calling thread, even with a GUI.
+     * The node and time limits of setLimits apply, and stop stops it as it stops decideMove without a GUI.
+     * The line found is one of the shortest mates, unless a limit stopped the search for shorter ones
+     * (MateSolver::solveShortest).
+     * @param maxMoves: only look for mates in at most this many moves, 0 for no limit.
+     * @return one of MateSolver::Results, UNKNOWN if a limit was reached or the search was stopped.
+     */
+    int findMate(int maxMoves);
+
+    /**
+     * @return the mating line found by the last call to findMate in SAN, separated by spaces. Empty if no mate was found.
+     */
+    std::string getMateLineSAN();
+
+    /**
+     * Set the size of findMate's transposition table (MATE_TABLE_MB by default).
+     * The table is allocated again on the next call to findMate.
+     */
+    void setMateTableSize(int memoryMB);
+
+    static const int MATE_TABLE_MB = 16; /**< The default size of findMate's transposition table */
+
   private:
     Board* b; /**< The board that the AI is playing on */
     BoardGUI* bgui; /**< The GUI used to display the board. Need this to keep GUI responsive while AI is thinking. */
     int maxDepth; /**< Number of half-moves AI can look ahead */
+    long long maxNodes; /**< Maximum number of nodes per search, 0 for no limit */
+    int maxTimeMs; /**< Maximum thinking time per search in milliseconds, 0 for no limit */
+    SearchListener* listener; /**< Receives the result of each completed depth, can be NULL */
+    int multiPV; /**< Number of best root moves to search with exact scores */
+
+    std::chrono::steady_clock::time_point startTime; /**< When the current search started */
+    bool stopped; /**< Set when a limit is reached, the search then unwinds without using the results */
+
+    /**
+     * Search b (the whole search, in the calling thread).
+     * @return the best move, -1 if there is no legal move.
+     */
+    int search();
+
+    /***************************************************************************
+     * Search thread (with a GUI)
+     ***************************************************************************/
+
+    std::atomic<bool> abortRequested; /**< Set by the GUI thread (user quit) or by stop to stop the search */
+    std::atomic<bool> searchDone; /**< Set by the search thread when search returns */
+
+    /**
+     * Search reports sent from the search thread to the GUI thread.
+     * The search never waits on the GUI: a report is dropped if the queue is full.
+     */
+    SPSCQueue<SearchInfo, 32> infoQueue;
+
+    int completedDepth; /**< The last completed depth of the current search */
+    int lastReportMs; /**< When the last report was sent, in milliseconds since the search started */
+    static const int REPORT_INTERVAL_MS = 200; /**< Reports are sent at least this often during a depth */
+
+    /**
+     * Fill a report with the current node count and time, and the best line of the last completed depth.
+     * @param depth: the depth to report.
+     */
+    void fillSearchInfo(SearchInfo& info, int depth);
+
+    /***************************************************************************
+     * Principal variations
+     ***************************************************************************/
+
+    /**
+     * The maximum number of half-turns in a principal variation.
+     * Deeper nodes are evaluated as if the cut-off depth was reached.
+     */
+    static const int MAX_PLY = 64;
+
+    /**
+     * Triangular array of principal variations: the row of a ply holds the best line found
+     * from that ply, from column ply to pvLength[ply] - 1. Rows are overwritten as the search goes.
+     */
+    int pvTable[MAX_PLY][MAX_PLY];
+    int pvLength[MAX_PLY];
+
+    std::vector<PVLine> pvLines; /**< The lines of the last completed depth, the best first */
+    Board rootBoard; /**< The searched board, to write the lines in SAN after the move is played */
+
+    /**
+     * Set the stopped flag if the node or time limit is reached.
+     */
+    void checkLimits();
+
+    /**
+     * @return milliseconds since the current search started.
+     */
+    int getElapsedMs();
 
     /***************************************************************************
      * Values used in board evaluation
@@ -57,25 +253,79 @@ class AIPlayer : public Player {
      */
     static const int LATE_GAME_MATERIAL;
 
+    /**
+     * Cache of pawn structure scores (passed, doubled, isolated and backward pawns).
+     */
+    PawnHashTable pawnTable;
+
+    /**
+     * The transposition table used by the search: ownTable, or a table set by setTranspositionTable.
+     * ownTable is only allocated if it is used.
+     */
+    TranspositionTable* table;
+    TranspositionTable ownTable;
+
+    /**
+     * The solver of findMate, allocated on its first call and kept with its table.
+     */
+    std::unique_ptr<MateSolver> mateSolver;
+    int mateTableMB; /**< The size of mateSolver's table */
+
+    /**
+     * The network used instead of the tables when not NULL.
+     * Its accumulator is kept up to date by the board.
+     */
+    NNUE* nnue;
+
     /***************************************************************************
      * Search and Evaluation methods
      ***************************************************************************/
 
     /**
      * Search a move tree and return its value. Has alpha-beta pruning with move ordering.
+     * The best line from this node is left in pvTable[ply].
      * @param color: 1 if the next player to move is white,
      * and -1 if the next player to move is black.
+     * @param ply: the number of half-turns from the searched board.
      */
-    int negamax(int depth, int alpha, int beta, int color);
+    int negamax(int depth, int alpha, int beta, int color, int ply);
+
+    /**
+     * Search captures only, until the position is quiet, so that the cut-off depth
+     * doesn't stop in the middle of an exchange. Captures losing material (by static exchange evaluation) are skipped.
+     * @param color: 1 if the next player to move is white,
+     * and -1 if the next player to move is black.
+     * @return the score of the board for the player to move.
+     */
+    int quiesce(int alpha, int beta, int color);
+
+    /**
+     * Captures losing material are not searched when the remaining depth is at most this value.
+     */
+    static const int SEE_PRUNING_DEPTH = 2;
 
     /**
      * Reorder the moves so that the best moves after 1 ply are searched first.
+     * Captures are scored by static exchange evaluation.
      * @param moveOrder: an empty array
      * @param numMoves: the size of moveOrder array
      * @param color: 1 if the next player to move is black, else -1.
      */
     void reorderMoves(int* moveOrder, int numMoves, int color);
 
+    /**
+     * Complete a line cut short by a transposition table cut-off, with the best moves stored in the table.
+     * @param moves: the line from the searched board, move numbers.
+     * @param length: the length to reach (the searched depth).
+     */
+    void extendLine(std::vector<int>& moves, int length);
+
+    /**
+     * Move a move to the front of a move order, keeping the order of the others.
+     * @param move: the move number, nothing is done if it is not between 0 and numMoves - 1.
+     */
+    void moveToFront(int* moveOrder, int numMoves, int move);
+
     /**
      * Static evaluation of the board. A positive score means white has an advantage.
      * @param depth: the depth of the current board. 0 is the deepest board.
@@ -87,7 +337,7 @@ class AIPlayer : public Player {
      * Debug
      ***************************************************************************/
 
-    int numNodes; /**< Number of moves made during search. Used to check pruning. */
+    long long numNodes; /**< Number of nodes searched. Used for node limits and to check pruning. */
     Board bSave; /**< Saved board for debugging */
     /**
      * Save the current board's state to bSave
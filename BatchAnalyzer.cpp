@@ -0,0 +1,132 @@
+#include "BatchAnalyzer.h"
+
+#include <chrono>
+#include <thread>
+
+#include "TranspositionTable.h"
+
+static int getThreadCount(int numThreads) {
+  if (numThreads <= 0) numThreads = std::thread::hardware_concurrency();
+  return (numThreads < 1)? 1 : numThreads;
+}
+
+BatchAnalyzer::BatchAnalyzer(int numThreads)
+    : numThreads(getThreadCount(numThreads)), queues(this->numThreads) {
+  maxDepth = 6;
+  maxNodes = 0;
+  maxTimeMs = 0;
+  fens = NULL;
+  listener = NULL;
+  nextResult = 0;
+}
+
+void BatchAnalyzer::setLimits(int depth, long long nodes, int timeMs) {
+  maxDepth = depth;
+  maxNodes = nodes;
+  maxTimeMs = timeMs;
+}
+
+void BatchAnalyzer::analyze(const std::vector<std::string>& fens, Listener* listener) {
+  this->fens = &fens;
+  this->listener = listener;
+  results.assign(fens.size(), Result());
+  isReady.assign(fens.size(), false);
+  nextResult = 0;
+  for (int i = 0; i < fens.size(); i++) {
+    queues[i % numThreads].positions.push_back(i);
+  }
+
+  int numWorkers = (fens.size() < numThreads)? fens.size() : numThreads;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < numWorkers; t++) {
+    threads.push_back(std::thread(&BatchAnalyzer::work, this, t));
+  }
+  for (int t = 0; t < numWorkers; t++) {
+    threads[t].join();
+  }
+  results.clear();
+  isReady.clear();
+  this->fens = NULL;
+  this->listener = NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                                 Workers
+////////////////////////////////////////////////////////////////////////////
+
+void BatchAnalyzer::work(int worker) {
+  Board b;
+  AIPlayer ai(&b, NULL, maxDepth);
+  ai.setLimits(maxDepth, maxNodes, maxTimeMs);
+  TranspositionTable table;
+  ai.setTranspositionTable(&table);
+  Result result;
+  for (int i = takePosition(worker); i != -1; i = takePosition(worker)) {
+    analyzePosition(i, b, ai, table, result);
+    addResult(result);
+  }
+}
+
+int BatchAnalyzer::takePosition(int worker) {
+  {
+    std::lock_guard<std::mutex> lock(queues[worker].mutex);
+    std::deque<int>& own = queues[worker].positions;
+    if (!own.empty()) {
+      int i = own.front();
+      own.pop_front();
+      return i;
+    }
+  }
+  // take the position that the other worker would search last
+  for (int n = 1; n < numThreads; n++) {
+    WorkQueue& other = queues[(worker + n) % numThreads];
+    std::lock_guard<std::mutex> lock(other.mutex);
+    if (!other.positions.empty()) {
+      int i = other.positions.back();
+      other.positions.pop_back();
+      return i;
+    }
+  }
+  return -1;
+}
+
+void BatchAnalyzer::analyzePosition(int index, Board& b, AIPlayer& ai, TranspositionTable& table, Result& result) {
+  result.index = index;
+  result.bestMove.clear();
+  result.pv.clear();
+  result.score = 0;
+  result.depth = 0;
+  result.nodes = 0;
+  result.timeMs = 0;
+  result.valid = b.loadFEN((*fens)[index]);
+  if (!result.valid) return;
+
+  table.clear();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  int move = ai.decideMove();
+  result.timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  result.nodes = ai.getNumNodes();
+  if (move == -1) return;
+  result.bestMove = b.getMoveSAN(move);
+  result.depth = ai.getCompletedDepth();
+  if (ai.getNumPVLines() > 0) {
+    result.score = ai.getPVLine(0).score;
+    result.pv = ai.getPVLineSAN(0);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                                 Results
+////////////////////////////////////////////////////////////////////////////
+
+void BatchAnalyzer::addResult(Result& result) {
+  int index = result.index;
+  std::lock_guard<std::mutex> lock(resultMutex);
+  std::swap(results[index], result);
+  isReady[index] = true;
+  while (nextResult < results.size() && isReady[nextResult]) {
+    if (listener != NULL) listener->onResult(results[nextResult]);
+    results[nextResult] = Result(); // free its strings
+    nextResult++;
+  }
+}
@@ -0,0 +1,125 @@
+/***********************************************************************//**
+ * Analyses a list of positions on all cores, e.g. the positions of games to review.
+ *
+ * Each worker thread has its own Board, AIPlayer and transposition table.
+ * The positions are dealt to the workers in turn (position i to worker i % threads),
+ * and each worker searches its own positions from the first. A worker that has none
+ * left takes the last position of another worker, so that a few long searches
+ * don't leave the other cores idle at the end of the batch.
+ *
+ * The results are given to a listener in the order of the positions, as soon as
+ * the previous ones are done: a result that is ready early waits for them.
+ * Dealing the positions in turn keeps these waiting results few.
+ * The table is cleared before each position, so with depth and node limits a
+ * result doesn't depend on the number of threads or on which worker searched it.
+ ***************************************************************************/
+
+#ifndef BATCHANALYZER_H
+#define BATCHANALYZER_H
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "AIPlayer.h"
+#include "Board.h"
+
+class BatchAnalyzer {
+  public:
+    /**
+     * The analysis of one position.
+     */
+    struct Result {
+      int index; /**< The position's number in the list */
+      bool valid; /**< false if the FEN is invalid (the other fields are then empty) */
+      std::string bestMove; /**< In SAN, empty if the position has no legal move */
+      int score; /**< In centipawns, in the perspective of the player to move */
+      int depth; /**< The last completed depth */
+      std::string pv; /**< The principal variation in SAN, starting with the best move */
+      long long nodes;
+      int timeMs;
+    };
+
+    /**
+     * Receives the results of analyze.
+     */
+    class Listener {
+      public:
+        virtual ~Listener() {}
+
+        /**
+         * Called once per position, in the order of the positions.
+         * Called by the worker threads, but never by two threads at the same time.
+         */
+        virtual void onResult(const Result& result) = 0;
+    };
+
+    /**
+     * @param numThreads: the number of positions searched at the same time. 0 to use all cores.
+     */
+    BatchAnalyzer(int numThreads = 0);
+    ~BatchAnalyzer() {}
+
+    /**
+     * Set the limits of each position's search (see AIPlayer::setLimits).
+     * @param depth: the maximum number of half-turns to look ahead.
+     * @param nodes: the maximum number of nodes, 0 for no limit.
+     * @param timeMs: the maximum thinking time in milliseconds, 0 for no limit.
+     */
+    void setLimits(int depth, long long nodes, int timeMs);
+
+    /**
+     * Analyse positions and give their results to the listener. Returns when all are given.
+     * @param fens: the positions.
+     */
+    void analyze(const std::vector<std::string>& fens, Listener* listener);
+
+    int getNumThreads() { return numThreads; }
+
+  private:
+    /**
+     * The positions left to a worker, by number. The worker takes from the front,
+     * the other workers from the back.
+     */
+    struct WorkQueue {
+      std::mutex mutex;
+      std::deque<int> positions;
+    };
+
+    int numThreads;
+    int maxDepth;
+    long long maxNodes;
+    int maxTimeMs;
+
+    const std::vector<std::string>* fens;
+    Listener* listener;
+    std::vector<WorkQueue> queues;
+
+    std::mutex resultMutex; /**< Protects results, isReady and nextResult, and orders the calls of the listener */
+    std::vector<Result> results; /**< The results waiting for the previous ones */
+    std::vector<bool> isReady;
+    int nextResult; /**< The number of the next result to give to the listener */
+
+    /**
+     * Search positions, its own then the other workers', until none is left.
+     */
+    void work(int worker);
+
+    /**
+     * @return the number of the next position for a worker, or -1 if none is left.
+     */
+    int takePosition(int worker);
+
+    /**
+     * Search one position with a worker's board and AI.
+     */
+    void analyzePosition(int index, Board& b, AIPlayer& ai, TranspositionTable& table, Result& result);
+
+    /**
+     * Store a result (its fields are moved), and give the listener the results that no longer wait for a previous one.
+     */
+    void addResult(Result& result);
+};
+
+#endif // BATCHANALYZER_H
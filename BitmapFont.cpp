@@ -0,0 +1,91 @@
+#include "BitmapFont.h"
+
+#include <string.h>
+
+BitmapFont::BitmapFont(int scale) {
+  this->scale = scale;
+}
+
+int BitmapFont::getCharWidth() {
+  return (GLYPH_WIDTH + 1) * scale;
+}
+
+int BitmapFont::getLineHeight() {
+  return (GLYPH_HEIGHT + 3) * scale;
+}
+
+void BitmapFont::drawText(SDL_Renderer* renderer, int x, int y, const std::string& text) {
+  pixels.clear();
+  for (int i = 0; i < text.size(); i++) {
+    const char* found = (text[i] == '\0')? NULL : strchr(CHARACTERS, text[i]);
+    if (found == NULL) continue;
+    const uint8_t* glyph = GLYPHS[found - CHARACTERS];
+    int left = x + i * getCharWidth();
+    for (int row = 0; row < GLYPH_HEIGHT; row++) {
+      for (int col = 0; col < GLYPH_WIDTH; col++) {
+        if ((glyph[row] >> (GLYPH_WIDTH - 1 - col)) & 1) {
+          SDL_Rect pixel = {left + col * scale, y + row * scale, scale, scale};
+          pixels.push_back(pixel);
+        }
+      }
+    }
+  }
+  if (!pixels.empty()) SDL_RenderFillRects(renderer, &pixels[0], pixels.size());
+}
+
+const char BitmapFont::CHARACTERS[] = " +-#=.:/0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghx";
+const uint8_t BitmapFont::GLYPHS[][BitmapFont::GLYPH_HEIGHT] = {
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // space
+  {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00}, // +
+  {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}, // -
+  {0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A}, // #
+  {0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00}, // =
+  {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}, // .
+  {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}, // :
+  {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}, // /
+  {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, // 0
+  {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, // 1
+  {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, // 2
+  {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, // 3
+  {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, // 4
+  {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, // 5
+  {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, // 6
+  {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, // 7
+  {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, // 8
+  {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, // 9
+  {0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // A
+  {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}, // B
+  {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}, // C
+  {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C}, // D
+  {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}, // E
+  {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}, // F
+  {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}, // G
+  {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // H
+  {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}, // I
+  {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C}, // J
+  {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}, // K
+  {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}, // L
+  {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}, // M
+  {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}, // N
+  {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // O
+  {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}, // P
+  {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}, // Q
+  {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}, // R
+  {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}, // S
+  {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, // T
+  {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // U
+  {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}, // V
+  {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}, // W
+  {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}, // X
+  {0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04}, // Y
+  {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}, // Z
+  {0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F}, // a
+  {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E}, // b
+  {0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E}, // c
+  {0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F}, // d
+  {0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E}, // e
+  {0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08}, // f
+  {0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E}, // g
+  {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11}, // h
+  {0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11}, // x
+};
@@ -0,0 +1,55 @@
+/***********************************************************************//**
+ * A small built-in font, drawn with filled rectangles.
+ * Covers what the search panel prints: digits, capital letters, the files and
+ * capture sign of algebraic notation (a -> h, x), and + - # = . : /
+ * Needs no font file and no extra SDL library.
+ ***************************************************************************/
+
+#ifndef BITMAPFONT_H
+#define BITMAPFONT_H
+
+#include <SDL2/SDL.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class BitmapFont {
+  public:
+    static const int GLYPH_WIDTH = 5; /**< Width of a glyph in font pixels */
+    static const int GLYPH_HEIGHT = 7; /**< Height of a glyph in font pixels */
+
+    /**
+     * @param scale: the size of a font pixel on screen.
+     */
+    BitmapFont(int scale = 2);
+    ~BitmapFont() {}
+
+    /**
+     * Draw a line of text with the renderer's current draw color.
+     * Characters that the font doesn't have are drawn as spaces.
+     * @param x, y: the top left corner of the text.
+     */
+    void drawText(SDL_Renderer* renderer, int x, int y, const std::string& text);
+
+    /**
+     * @return the horizontal distance between 2 characters on screen.
+     */
+    int getCharWidth();
+
+    /**
+     * @return the vertical distance between 2 lines on screen.
+     */
+    int getLineHeight();
+
+  private:
+    static const char CHARACTERS[]; /**< The characters of the font, in the order of GLYPHS */
+    /**
+     * One row of bits per glyph line, the highest of the 5 bits is the left column.
+     */
+    static const uint8_t GLYPHS[][GLYPH_HEIGHT];
+
+    int scale;
+    std::vector<SDL_Rect> pixels; /**< Reused between calls, all pixels of a text are drawn in one call */
+};
+
+#endif // BITMAPFONT_H
@@ -1,16 +1,16 @@
 #include "Board.h"
+#include "BoardTables.h"
 
+#include <ctype.h>
+#include <string.h>
 #include <stdio.h> // TO DO: remove after debug
 
-
-const int Board::dir[8][2] = { {0, 1}, {0, -1}, {1, 0}, {-1, 0},
-                               {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
-const int Board::dirKnight[8][2] = { {1, 2}, {1, -2}, {-1, 2}, {-1, -2},
-                                     {2, 1}, {2, -1}, {-2, 1}, {-2, -1} };
+using namespace BoardTables;
 
 void Board::initBoard() {
   player = WHITE; // white player go first
   chosenSquare = -1; // no chosen square yet
+  startEnPassantFile = -1; // not loaded from a FEN
 
   // variables to keep track of board
   kingSquares[WHITE] = 4;
@@ -60,9 +60,115 @@ void Board::initBoard() {
     board[1][j] = WP;
     board[6][j] = BP;
   }
+  computeKeys();
+  if (nnue != NULL) refreshAccumulator();
   updateMoveList();
 }
 
+bool Board::loadFEN(std::string fen) {
+  // split into fields: pieces, player, castling, en passant (the counters are not used)
+  std::string fields[4];
+  int numFields = 0;
+  for (int i = 0; i < fen.size() && numFields < 4; i++) {
+    if (fen[i] == ' ') {
+      if (!fields[numFields].empty()) numFields++;
+    } else {
+      fields[numFields] += fen[i];
+    }
+  }
+  if (numFields < 4 && !fields[numFields].empty()) numFields++;
+  if (numFields < 2) {
+    initBoard();
+    return false;
+  }
+
+  // Pieces, from the 8th row down to the 1st row
+  int r = ROWS - 1, c = 0;
+  int numKings[2] = {0, 0};
+  for (int i = 0; i < fields[0].size(); i++) {
+    char ch = fields[0][i];
+    if (ch == '/') {
+      if (c != COLS || r == 0) break;
+      r--;
+      c = 0;
+    } else if (ch >= '1' && ch <= '8') {
+      for (int k = 0; k < ch - '0' && c < COLS; k++) board[r][c++] = EMPTY;
+    } else {
+      int piece;
+      switch (ch) {
+        case 'P': piece = WP; break;
+        case 'N': piece = WN; break;
+        case 'B': piece = WB; break;
+        case 'R': piece = WR; break;
+        case 'Q': piece = WQ; break;
+        case 'K': piece = WK; break;
+        case 'p': piece = BP; break;
+        case 'n': piece = BN; break;
+        case 'b': piece = BB; break;
+        case 'r': piece = BR; break;
+        case 'q': piece = BQ; break;
+        case 'k': piece = BK; break;
+        default: piece = -2; // invalid character
+      }
+      if (piece == -2 || c >= COLS) {
+        r = -1;
+        break;
+      }
+      if (piece == WK || piece == BK) {
+        int color = (piece == WK)? WHITE : BLACK;
+        kingSquares[color] = r * COLS + c;
+        numKings[color]++;
+      }
+      board[r][c++] = piece;
+    }
+  }
+  if (r != 0 || c != COLS || numKings[WHITE] != 1 || numKings[BLACK] != 1
+      || (fields[1] != "w" && fields[1] != "b")) {
+    initBoard();
+    return false;
+  }
+  player = (fields[1] == "w")? WHITE : BLACK;
+
+  // Castling: a right is only kept if the king and rook are on their starting squares
+  for (int i = 0; i < 6; i++) castlingFirstMove[i] = -1;
+  const char* rightChars = "QKqk"; // white left, white right, black left, black right
+  for (int color = WHITE; color <= BLACK; color++) {
+    int row = color? 7 : 0;
+    if (board[row][4] != (color? BK : WK)) continue;
+    for (int side = 0; side < 2; side++) {
+      int rookCol = side? 7 : 0;
+      if (fields[2].find(rightChars[2*color + side]) != std::string::npos
+          && board[row][rookCol] == (color? BR : WR)) {
+        castlingFirstMove[color] = 0;
+        castlingFirstMove[color + 2 + 2*side] = 0;
+      }
+    }
+  }
+
+  promotionSquare = -1;
+  chosenSquare = -1;
+  checkingPieces[0] = -1;
+  checkingPieces[1] = -1;
+  pinPieces.clear();
+  moveList.clear();
+  history.clear();
+
+  // En passant: only kept if the pawn that double jumped is there
+  startEnPassantFile = -1;
+  if (fields[3].size() == 2 && fields[3][0] >= 'a' && fields[3][0] <= 'h') {
+    int col = fields[3][0] - 'a';
+    int jumpedRow = player? 3 : 4; // the row of the pawn that just double jumped
+    if (fields[3][1] == (player? '3' : '6') && board[jumpedRow][col] == (player? WP : BP)) {
+      startEnPassantFile = col;
+    }
+  }
+
+  computeKeys();
+  if (nnue != NULL) refreshAccumulator();
+  updateMoveList();
+  return true;
+}
+
 int Board::getPiece(int square) {
   return board[square/COLS][square%COLS];
 }
@@ -102,6 +208,14 @@ std::vector<int> Board::getHistory() {
   return history;
 }
 
+uint64_t Board::getHashKey() {
+  return hashKey;
+}
+
+uint64_t Board::getPawnKey() {
+  return pawnKey;
+}
+
 int Board::getGameLength() {
   return history.size() / MOVE_LENGTH_HISTORY;
 }
@@ -115,19 +229,38 @@ int Board:: getKingSquare(int color) {
 }
 
 void Board::getMovesFromSquare(std::vector<int>& squareMoves, const int startSquare) {
-  // iterate through the moveList vector to find all the moves starting at chosenSquare
-  // All those moves SHOULD be next to each other
-  bool foundStartSquare = false;
-  for (int i = 0; i < moveList.size(); i+= MOVE_LENGTH_MOVE_LIST) {
-    if(moveList[i] == startSquare) {
-      foundStartSquare = true; //
-      squareMoves.push_back(moveList[i+1]);
-    } else if (foundStartSquare) {
-      break;
-    }
+  View moves = getMovesFrom(startSquare);
+  for (int i = 0; i < moves.size(); i += MOVE_LENGTH_MOVE_LIST) {
+    squareMoves.push_back(moves[i+1]);
   }
 }
 
+Board::View Board::getMoveListView() {
+  return View(moveList.data(), moveList.size());
+}
+
+Board::View Board::getHistoryView() {
+  return View(history.data(), history.size());
+}
+
+Board::View Board::getMovesFrom(int square) {
+  return View(moveList.data() + firstMoveFrom[square] * MOVE_LENGTH_MOVE_LIST,
+              numMovesFrom[square] * MOVE_LENGTH_MOVE_LIST);
+}
+
+int Board::getFirstMoveFrom(int square) {
+  return firstMoveFrom[square];
+}
+
+int Board::findMove(int square1, int square2) {
+  if (square1 < 0 || square1 >= NUM_SQUARES) return -1;
+  int first = firstMoveFrom[square1];
+  for (int m = first; m < first + numMovesFrom[square1]; m++) {
+    if (moveList[m * MOVE_LENGTH_MOVE_LIST + 1] == square2) return m;
+  }
+  return -1;
+}
+
 bool Board::isKingChecked() {
   return checkingPieces[0] != -1;
 }
@@ -136,6 +269,14 @@ void Board::makeMove(int moveIndex) {
   // cannot make a whole move is the previous move has not finished
   if (promotionSquare != -1) return;
 
+  if (player == WHITE) makeMoveFor<WHITE>(moveIndex);
+  else makeMoveFor<BLACK>(moveIndex);
+}
+
+template<Board::Colors Us>
+void Board::makeMoveFor(int moveIndex) {
+  const Colors Them = (Us == WHITE)? BLACK : WHITE;
+
   //Each move use 3 indexes, so the nth move is at index 3n.
   moveIndex *= MOVE_LENGTH_MOVE_LIST;
   int x1 = moveList[moveIndex] / COLS;
@@ -143,6 +284,8 @@ void Board::makeMove(int moveIndex) {
   int x2 = moveList[moveIndex + 1] / COLS;
   int y2 = moveList[moveIndex + 1] % COLS;
   int moveType = moveList[moveIndex + 2];
+  int oldRights = getCastlingRights();
+  int oldEnPassant = getEnPassantFile();
 
   // save move to history
   history.push_back(moveList[moveIndex]); //start square
@@ -151,35 +294,35 @@ void Board::makeMove(int moveIndex) {
   history.push_back(moveType); //move type
 
   // move piece from square 1 to square 2
-  board[x2][y2] = board[x1][y1];
-  board[x1][y1] = EMPTY;
+  setSquare(x2, y2, board[x1][y1]);
+  setSquare(x1, y1, EMPTY);
 
   switch (moveType) {
     case MOVE_NORMAL: break;
     case MOVE_PAWN_DOUBLE_JUMP: break;
     case MOVE_PAWN_EN_PASSANT:
-      board[x1][y2] = EMPTY;
+      setSquare(x1, y2, EMPTY);
       break;
     case MOVE_CASTLING:
       if (y2 == 2) {//left castling
-        board[x2][3] = board[x2][0];
-        board[x2][0] = -1;
+        setSquare(x2, 3, board[x2][0]);
+        setSquare(x2, 0, EMPTY);
       } else {//right castling
-        board[x2][5] = board[x2][7];
-        board[x2][7] = -1;
+        setSquare(x2, 5, board[x2][7]);
+        setSquare(x2, 7, EMPTY);
       }
       break;
     case MOVE_PROMOTION_QUEEN:
-      board[x2][y2] = player? BQ : WQ;
+      setSquare(x2, y2, Us? BQ : WQ);
       break;
     case MOVE_PROMOTION_ROOK:
-      board[x2][y2] = player? BR : WR;
+      setSquare(x2, y2, Us? BR : WR);
       break;
     case MOVE_PROMOTION_KNIGHT:
-      board[x2][y2] = player? BN : WN;
+      setSquare(x2, y2, Us? BN : WN);
       break;
     case MOVE_PROMOTION_BISHOP:
-      board[x2][y2] = player? BB : WB;
+      setSquare(x2, y2, Us? BB : WB);
       break;
   }
 
@@ -188,35 +331,18 @@ void Board::makeMove(int moveIndex) {
   ////////////////////////////////////////////////////////
 
   // Update square of king if king moves
-  if (moveList[moveIndex] == kingSquares[player]) kingSquares[player] = moveList[moveIndex+1];
+  if (moveList[moveIndex] == kingSquares[Us]) kingSquares[Us] = moveList[moveIndex+1];
 
-  // Update castling flags if king or rook move for the first time
-  switch (moveList[moveIndex]) {
-    case 0: //left white rook moved
-      if (!castlingFirstMove[2]) castlingFirstMove[2] = history.size();
-      break;
-    case 4: //white king moved
-      if (!castlingFirstMove[0]) castlingFirstMove[0] = history.size();
-      break;
-    case 7: //right white rook moved
-      if (!castlingFirstMove[4]) castlingFirstMove[4] = history.size();
-      break;
-    case 56: //left black rook moved
-      if (!castlingFirstMove[3]) castlingFirstMove[3] = history.size();
-      break;
-    case 60: //black king moved
-      if (!castlingFirstMove[1]) castlingFirstMove[1] = history.size();
-      break;
-    case 63: //right black rook moved
-      if (!castlingFirstMove[5]) castlingFirstMove[5] = history.size();
-      break;
-  }
+  // Update castling flags if king or rook move for the first time (or a rook is captured)
+  updateCastlingFlags(moveList[moveIndex], moveList[moveIndex+1]);
 
   /*
    * Change player and update move list
    */
-  player = 1 - player;
-  updateMoveList();
+  updateStateKey(oldRights, oldEnPassant);
+  player = Them;
+  hashKey ^= zobristBlackToMove;
+  generateMoves<Them>();
 }
 
 void Board::chooseSquare(int square) {
@@ -240,20 +366,17 @@ void Board::makeMove(int square1,int square2){
   // cannot make move if the last move is not completed
   if (promotionSquare != -1) return;
 
-  int moveType = -1;
-  for (int i = 0; i < moveList.size(); i += MOVE_LENGTH_MOVE_LIST) {
-    if (moveList[i] == square1 && moveList[i+1] == square2) {
-      moveType = moveList[i+2];
-      break;
-    }
-  }
+  int moveIndex = findMove(square1, square2);
   // move not legal
-  if (moveType == -1) return;
+  if (moveIndex == -1) return;
+  int moveType = moveList[moveIndex * MOVE_LENGTH_MOVE_LIST + 2];
 
   int x1 = square1 / COLS;
   int y1 = square1 % COLS;
   int x2 = square2 / COLS;
   int y2 = square2 % COLS;
+  int oldRights = getCastlingRights();
+  int oldEnPassant = getEnPassantFile();
 
   // Save move to history
   history.push_back(square1);
@@ -262,25 +385,27 @@ void Board::makeMove(int square1,int square2){
   history.push_back(moveType);
 
   //Make the move
-  board[x2][y2] = board[x1][y1];
-  board[x1][y1] = EMPTY;
+  setSquare(x2, y2, board[x1][y1]);
+  setSquare(x1, y1, EMPTY);
   switch (moveType) {
     case MOVE_NORMAL: break;
     case MOVE_PAWN_DOUBLE_JUMP: break;
     case MOVE_PAWN_EN_PASSANT:
-      board[x1][y2] = EMPTY;
+      setSquare(x1, y2, EMPTY);
       break;
     case MOVE_CASTLING:
       if (y2 == 2) { //left castling
-        board[x2][3] = board[x2][0];
-        board[x2][0] = -1;
+        setSquare(x2, 3, board[x2][0]);
+        setSquare(x2, 0, EMPTY);
       } else { //right castling
-        board[x2][5] = board[x2][7];
-        board[x2][7] = -1;
+        setSquare(x2, 5, board[x2][7]);
+        setSquare(x2, 7, EMPTY);
       }
       break;
     default: // has promotion
       promotionSquare = square2;
+      updateCastlingFlags(square1, square2);
+      updateStateKey(oldRights, oldEnPassant);
       return;
   }
   //////////////////////////////////////////////////////
@@ -291,47 +416,49 @@ void Board::makeMove(int square1,int square2){
   if (square1 == kingSquares[player]) {
     kingSquares[player] = square2;
   }
-  // If king or rook move, update castling flags
-  switch (square1) {
-    case 0:
-      if (!castlingFirstMove[2]) castlingFirstMove[2] = history.size();
-      break;
-    case 4:
-      if (!castlingFirstMove[0]) castlingFirstMove[0] = history.size();
-      break;
-    case 7:
-      if (!castlingFirstMove[4]) castlingFirstMove[4] = history.size();
-      break;
-    case 56:
-      if (!castlingFirstMove[3]) castlingFirstMove[3] = history.size();
-      break;
-    case 60:
-      if (!castlingFirstMove[1]) castlingFirstMove[1] = history.size();
-      break;
-    case 63:
-      if (!castlingFirstMove[5]) castlingFirstMove[5] = history.size();
-      break;
-  }
+  // If king or rook move (or a rook is captured), update castling flags
+  updateCastlingFlags(square1, square2);
 
   // Change player and update move list
+  updateStateKey(oldRights, oldEnPassant);
   player = 1 - player;
+  hashKey ^= zobristBlackToMove;
   updateMoveList();
 }
 
+void Board::updateCastlingFlags(int square1, int square2) {
+  // the flag index of the king or rook that starts in each corner / king square
+  for (int k = 0; k < 2; k++) {
+    int flag = -1;
+    switch (k? square2 : square1) {
+      case 0:  flag = 2; break; //left white rook
+      case 4:  flag = 0; break; //white king
+      case 7:  flag = 4; break; //right white rook
+      case 56: flag = 3; break; //left black rook
+      case 60: flag = 1; break; //black king
+      case 63: flag = 5; break; //right black rook
+    }
+    if (flag != -1 && !castlingFirstMove[flag]) castlingFirstMove[flag] = history.size();
+  }
+}
+
 bool Board::hasPromotion() {
   return promotionSquare != -1;
 }
 
 void Board::promote(int promotionType) {
+  int r = promotionSquare / COLS;
+  int c = promotionSquare % COLS;
   switch (promotionType) {
-    case MOVE_PROMOTION_QUEEN : board[promotionSquare/COLS][promotionSquare%COLS] = player? BQ:WQ; break;
-    case MOVE_PROMOTION_ROOK  : board[promotionSquare/COLS][promotionSquare%COLS] = player? BR:WR; break;
-    case MOVE_PROMOTION_BISHOP: board[promotionSquare/COLS][promotionSquare%COLS] = player? BB:WB; break;
-    case MOVE_PROMOTION_KNIGHT: board[promotionSquare/COLS][promotionSquare%COLS] = player? BN:WN; break;
+    case MOVE_PROMOTION_QUEEN : setSquare(r, c, player? BQ:WQ); break;
+    case MOVE_PROMOTION_ROOK  : setSquare(r, c, player? BR:WR); break;
+    case MOVE_PROMOTION_BISHOP: setSquare(r, c, player? BB:WB); break;
+    case MOVE_PROMOTION_KNIGHT: setSquare(r, c, player? BN:WN); break;
     default: return;
   }
   promotionSquare = -1;
   player = 1 - player;
+  hashKey ^= zobristBlackToMove;
   updateMoveList();
 }
 
@@ -339,8 +466,15 @@ void Board::undoMove() {
   promotionSquare = -1;
   chosenSquare = -1;
 
+  if (history.empty()) return;
+  // the player who made the last move
+  if (player == WHITE) undoMoveFor<BLACK>();
+  else undoMoveFor<WHITE>();
+}
+
+template<Board::Colors Us>
+void Board::undoMoveFor() {
   int i = history.size();
-  if (i <= 0) return;
 
   int square1 = history[i-4];
   int square2 = history[i-3];
@@ -350,13 +484,16 @@ void Board::undoMove() {
   int x2 = square2 / COLS;
   int y2 = square2 % COLS;
   int moveType = history[i-1];
+  int oldRights = getCastlingRights();
+  int oldEnPassant = getEnPassantFile();
 
   // Undo player
-  player = 1 - player;
+  player = Us;
+  hashKey ^= zobristBlackToMove;
 
   // Undo move
-  board[x1][y1] = board[x2][y2];
-  board[x2][y2] = history[i-2]; //restore captured piece
+  setSquare(x1, y1, board[x2][y2]);
+  setSquare(x2, y2, history[i-2]); //restore captured piece
 
   // delete history of the move
   history.pop_back();
@@ -369,34 +506,32 @@ void Board::undoMove() {
     case MOVE_NORMAL:
       break;
     case MOVE_PAWN_DOUBLE_JUMP:
-      updateMoveList();
-      return;
+      break;
     case MOVE_PAWN_EN_PASSANT:
-      board[x1][y2] = player? WP : BP;
-      updateMoveList();
-      return;
+      setSquare(x1, y2, Us? WP : BP);
+      break;
     case MOVE_CASTLING:
       if (y2 == 2) { //left castling
-        board[x2][0] = board[x2][3];
-        board[x2][3] = EMPTY;
+        setSquare(x2, 0, board[x2][3]);
+        setSquare(x2, 3, EMPTY);
       } else { //right castling
-        board[x2][7] = board[x2][5];
-        board[x2][5] = EMPTY;
+        setSquare(x2, 7, board[x2][5]);
+        setSquare(x2, 5, EMPTY);
       }
       break;
     default: //promotion
-      board[x1][y1] = player? BP : WP;
-      updateMoveList();
-      return;
+      setSquare(x1, y1, Us? BP : WP);
+      break;
   }
 
   // Undo variables to keep track of board
   // King square
-  if (kingSquares[player] == square2) kingSquares[player] = square1;
+  if (kingSquares[Us] == square2) kingSquares[Us] = square1;
   for (i = 0; i < 6; i++) {
-    if (castlingFirstMove[i] > history.size()) castlingFirstMove[i] = 0;
+    if (castlingFirstMove[i] > (int) history.size()) castlingFirstMove[i] = 0;
   }
-  updateMoveList();
+  updateStateKey(oldRights, oldEnPassant);
+  generateMoves<Us>();
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -404,29 +539,48 @@ void Board::undoMove() {
 ////////////////////////////////////////////////////////////////////////////
 
 void Board::updateMoveList() {
+  // dispatch once, so that the generators are compiled for each color without branching on the player
+  if (player == WHITE) generateMoves<WHITE>();
+  else generateMoves<BLACK>();
+}
+
+template<Board::Colors Us>
+void Board::generateMoves() {
   moveList.clear();
-  findPinAndCheck();
+  findPinAndCheck<Us>();
 
   // loop through all squares, and update current player's pieces in those squares
   for (int i = 0; i < ROWS; i++) {
     for (int j = 0; j < COLS; j++) {
       // if square is empty, or has opponent's piece, do not update
-      if (board[i][j] == EMPTY || (player == (board[i][j] > MAX_BLACK_TYPE))) continue;
+      if (board[i][j] == EMPTY || (Us == (board[i][j] > MAX_BLACK_TYPE))) continue;
 
       // if square has friendly piece, update
       int pType = board[i][j] % NUM_PIECE_TYPES; // remove color factor
       switch (pType) {
-        case BP: updatePawnMoves(i, j); break;
+        case BP: updatePawnMoves<Us>(i, j); break;
         case BR:
         case BB:
-        case BQ: updateRayMoves(i, j); break;
-        case BN: updateKnightMoves(i, j); break;
-        case BK: updateKingMoves(i, j);
+        case BQ: updateRayMoves<Us>(i, j); break;
+        case BN: updateKnightMoves<Us>(i, j); break;
+        case BK: updateKingMoves<Us>(i, j);
       }
     }
   }
+
+  // index the moves by starting square (the moves of a square are generated together)
+  for (int s = 0; s < NUM_SQUARES; s++) {
+    firstMoveFrom[s] = 0;
+    numMovesFrom[s] = 0;
+  }
+  for (int m = 0; m * MOVE_LENGTH_MOVE_LIST < moveList.size(); m++) {
+    int s = moveList[m * MOVE_LENGTH_MOVE_LIST];
+    if (numMovesFrom[s] == 0) firstMoveFrom[s] = m;
+    numMovesFrom[s]++;
+  }
 }
 
+template<Board::Colors Us>
 void Board::findPinAndCheck() {
   // To find all pins and checks, this method do the following:
   // From the current player's king squares:
@@ -436,11 +590,7 @@ void Board::findPinAndCheck() {
   // Save the opponent pieces found in pinPieces and checkingPieces.
 
   // Position of King
-  int r = kingSquares[player] / COLS;
-  int c = kingSquares[player] % COLS;
-
-  // Position of the square we are checking
-  int i,j;
+  int kingSquare = kingSquares[Us];
 
   // Clear checking pieces and pin pieces
   checkingPieces[0] = -1;
@@ -451,27 +601,24 @@ void Board::findPinAndCheck() {
   // Check 8 basic direction to see if there are ray pieces
   for(int d = 0; d < 8; d++) {
     int pinnedSquare = -1;
-    i = r;
-    j = c;
-    while(true) {
+    int s = kingSquare; // the square we are checking
+    for (int k = 0; k < TABLES.squaresToEdge[kingSquare][d]; k++) {
       // advance 1 square in direction of d
-      i += dir[d][0];
-      j += dir[d][1];
-      // if out of bound
-      if (i < 0 || i >= ROWS || j < 0 || j >= COLS) break;
+      s += DIR_OFFSET[d];
+      int piece = board[s/COLS][s%COLS];
       // if empty square, advance 1 more square
-      if (board[i][j] == EMPTY) continue;
+      if (piece == EMPTY) continue;
 
       if (pinnedSquare == -1) { // encounter the first piece in ray
-        if (player == (board[i][j] < MIN_WHITE_TYPE)) {
+        if (Us == (piece < MIN_WHITE_TYPE)) {
           // if the 1st piece is a friendly piece
           // it might be a pinned piece
-          pinnedSquare = i * ROWS + j;
+          pinnedSquare = s;
         }
         else {
           // if the 1st piece is am opponent's piece
           // check if it's a suitable ray piece
-          int curPieceType = board[i][j] % NUM_PIECE_TYPES; // do not care about color
+          int curPieceType = piece % NUM_PIECE_TYPES; // do not care about color
           if ( curPieceType == BQ
                ||(d <= MAX_CARDINAL_DIR && curPieceType == BR)
                || (d >= MIN_DIAGONAL_DIR && curPieceType == BB) ) {
@@ -479,21 +626,21 @@ void Board::findPinAndCheck() {
             // if the piece is checking King, add it to checkingPieces array
             // if this is the first checking piece, put it in index 0
             // else put it in index 1.
-            checkingPieces[checkIndex] = i * COLS + j;
+            checkingPieces[checkIndex] = s;
             checkIndex++;
           }
           break; //already found an opponent's piece in this ray, so look into another direction.
         }
       } else {// encounter the second piece in ray (the first piece is a friendly piece)
-        if ( player == (board[i][j] > MAX_BLACK_TYPE) ) {
+        if ( Us == (piece > MAX_BLACK_TYPE) ) {
           // if the 2nd piece is opponent's piece, it is a possible pinning piece
-          int curPieceType = board[i][j] % NUM_PIECE_TYPES; // do not care about color
+          int curPieceType = piece % NUM_PIECE_TYPES; // do not care about color
           if ( curPieceType == BQ
                || (d <= MAX_CARDINAL_DIR && curPieceType == BR)
                || (d >= MIN_DIAGONAL_DIR && curPieceType == BB) ) {
             // if it's opponent's ray piece, it is a pinning piece
             pinPieces.push_back(pinnedSquare);
-            pinPieces.push_back(i* 8 + j);
+            pinPieces.push_back(s);
           }
         }
         break; //already found 2 pieces in this ray, look into other directions
@@ -504,69 +651,66 @@ void Board::findPinAndCheck() {
   // if king is double checked, we have found all possible checks and pins
   if (checkIndex > 1) return;
 
-  // Check 8 knight's direction to see if there are opponent's knight
-  for (int d = 0; d < 8; d++) {
-    i = r + dirKnight[d][0];
-    j = c + dirKnight[d][1];
-    // if out of bound, check other directions
-    if ( i < 0 || i >= ROWS || j < 0 || j >= COLS) continue;
-
-    if (board[i][j] == (player? WN : BN) ) { // if has opponent's knight
-      checkingPieces[checkIndex] = i * 8 + j;
+  // Check the knight squares around the king to see if there are opponent's knight
+  uint64_t knights = TABLES.knightAttacks[kingSquare];
+  while (knights) {
+    int s = popLowestSquare(knights);
+    if (board[s/COLS][s%COLS] == (Us? WN : BN) ) { // if has opponent's knight
+      checkingPieces[checkIndex] = s;
       checkIndex++;
       // if there are 2 checking pieces, that's max
       if (checkIndex > 1) return;
     }
   }
 
-  // Check 2 squares diagonally to the left and right to see if there are opponent pawns
-  i = player? (r - 1) : (r + 1); //For black king, check the lower row for white pawn.
-                                 //For white king, check the upper row for black pawn.
-  j = c - 1; // The left column
-  if (i >= 0 && i < ROWS && j >= 0 && j < COLS) {
-    if (board[i][j] == (player? WP:BP)) {
+  // Check 2 squares diagonally ahead of the king to see if there are opponent pawns
+  // (the squares a pawn of the king's color would attack)
+  uint64_t pawns = TABLES.pawnAttacks[Us][kingSquare];
+  while (pawns) {
+    int s = popLowestSquare(pawns);
+    if (board[s/COLS][s%COLS] == (Us? WP:BP)) {
       // has an opponent's pawn
-      checkingPieces[checkIndex] = i * 8 + j;
+      checkingPieces[checkIndex] = s;
       checkIndex++;
       if (checkIndex > 1) return; //no more possible check
     }
   }
-  j = c + 1; // The right column
-  if (i >= 0 && i < ROWS && j >= 0 && j < COLS) {
-    if (board[i][j] == (player? WP:BP)) {
-      // has an opponent's pawn
-      checkingPieces[checkIndex] = i * 8 + j;
-    }
-  }
 }
 
+template<Board::Colors Us>
 void Board::updateKingMoves(int r, int c) {
-  // the square we are checking
-  int i, j;
+  int kingSquare = kingSquares[Us];
 
   //
   // 8 squares around king
   //
 
-  for (int d = 0; d < 8; d++) {
-    i = r + dir[d][0];
-    j = c + dir[d][1];
-    // out of bound
-    if (i < 0 || i >= ROWS || j < 0 || j >= COLS) continue;
+  uint64_t targets = TABLES.kingAttacks[kingSquare];
+  while (targets) {
+    // the square we are checking
+    int s = popLowestSquare(targets);
+    int i = s / COLS;
+    int j = s % COLS;
     // square has a friendly piece
-    if ((board[i][j] != EMPTY) && (player == (board[i][j] < MIN_WHITE_TYPE))) continue;
+    if ((board[i][j] != EMPTY) && (Us == (board[i][j] < MIN_WHITE_TYPE))) continue;
     // square is controlled by opponent
-    if (isSquareControlled(i, j)) continue;
+    if (isSquareControlled<Us>(i, j)) continue;
 
     // if the king is between the considered square and opponent's ray piece, king cannot move to that square
-    if (checkingPieces[0] != -1
-        && isInRay(checkingPieces[0], kingSquares[player], i * COLS + j) ) continue;
-    if (checkingPieces[1] != -1
-        && isInRay(checkingPieces[1], kingSquares[player], i * COLS + j) ) continue;
+    // (a checking pawn does not attack along its diagonal, so the king may step away from it)
+    bool behindKing = false;
+    for (int n = 0; n < 2; n++) {
+      int checker = checkingPieces[n];
+      if (checker == -1 || !isRayPiece(checker) || s == checker) continue;
+      if ((TABLES.line[checker][kingSquare] >> s & 1) && !(TABLES.between[checker][kingSquare] >> s & 1)) {
+        behindKing = true;
+      }
+    }
+    if (behindKing) continue;
 
     // If passes all tests above, the square is a legal king move. Add to moveList
-    moveList.push_back(kingSquares[player]); //starting square
-    moveList.push_back(i * COLS + j); //ending square
+    moveList.push_back(kingSquare); //starting square
+    moveList.push_back(s); //ending square
     moveList.push_back(MOVE_NORMAL); // move type
   }
 
@@ -574,28 +718,29 @@ void Board::updateKingMoves(int r, int c) {
   // Castling
   //
 
-  if (!castlingFirstMove[player] && checkingPieces[0] == -1) {//king has not moved and is not checked
+  if (!castlingFirstMove[Us] && checkingPieces[0] == -1) {//king has not moved and is not checked
     // if left rook has not moved,
     // and the squares left of king are empty and not controlled by the opponent,
     // can castling left
-    if ( !castlingFirstMove[player + 2] && (board[r][1] == EMPTY) && (board[r][2] == EMPTY) && (board[r][3] == EMPTY)
-         && !isSquareControlled(r, 2) && !isSquareControlled(r, 3) ) {
-      moveList.push_back(kingSquares[player]); //starting square
+    if ( !castlingFirstMove[Us + 2] && (board[r][1] == EMPTY) && (board[r][2] == EMPTY) && (board[r][3] == EMPTY)
+         && !isSquareControlled<Us>(r, 2) && !isSquareControlled<Us>(r, 3) ) {
+      moveList.push_back(kingSquare); //starting square
       moveList.push_back(r * COLS + 2); //ending square
       moveList.push_back(MOVE_CASTLING); // move type
     }
     // if right rook has not moved,
     // and the 2 squares right of king are empty and not controlled by the opponent,
     // can castling right
-    if ( !castlingFirstMove[player + 4] && (board[r][5] == -1) && (board[r][6] == -1)
-         && !isSquareControlled(r, 5) && !isSquareControlled(r, 6) ) {
-      moveList.push_back(kingSquares[player]); //starting square
+    if ( !castlingFirstMove[Us + 4] && (board[r][5] == -1) && (board[r][6] == -1)
+         && !isSquareControlled<Us>(r, 5) && !isSquareControlled<Us>(r, 6) ) {
+      moveList.push_back(kingSquare); //starting square
       moveList.push_back(r * COLS + 6); //ending square
       moveList.push_back(MOVE_CASTLING); // move type
     }
   }
 }
 
+template<Board::Colors Us>
 void Board::updateRayMoves(int r, int c) {
   // Find out whether the king is checked or this ray piece is pinned
   // If there are 2 pieces that are either checking kings or pinning this piece,
@@ -622,8 +767,6 @@ void Board::updateRayMoves(int r, int c) {
   // If there is a piece checking king or pinning ray,
   // this piece can only move between the checking piece and the king
 
-  int i,j; // the square we are considering
-
   // choose directions (queen: 8 dirs, rook: first 4 dirs, bishop: 4 last dirs)
   int minDir, maxDir;
   switch(board[r][c]) {
@@ -634,26 +777,23 @@ void Board::updateRayMoves(int r, int c) {
     case WQ: case BQ:
       minDir = 0; maxDir = 8; break;
   }
-  // Look into all directions
+  // Look into all directions (until the edge of the board)
   for(int d = minDir; d < maxDir; d++) {
-    i = r;
-    j = c;
-    while(true) {
+    int s = raySquare; // the square we are considering
+    for (int k = 0; k < TABLES.squaresToEdge[raySquare][d]; k++) {
       // advance 1 square in the direction d
-      i += dir[d][0];
-      j += dir[d][1];
+      s += DIR_OFFSET[d];
+      int piece = board[s/COLS][s%COLS];
 
-      // if out of bound, look in another direction
-      if (i < 0 || i >= ROWS || j < 0 || j >= COLS) break;
       // if square has friendly piece, look in another direction
-      if ((board[i][j] != EMPTY) && (player == (board[i][j] < MIN_WHITE_TYPE))) break;
+      if ((piece != EMPTY) && (Us == (piece < MIN_WHITE_TYPE))) break;
 
       // if moving causes king danger:
       // + if current square is empty, advance 1 more square
       // + if current square has piece, check other directions
       if ( (checkingSquare != -1)
-           && !isInRay(checkingSquare, i * COLS + j, kingSquares[player]) ) {
-        if (board[i][j] == EMPTY) continue;
+           && !isInRay(checkingSquare, s, kingSquares[Us]) ) {
+        if (piece == EMPTY) continue;
         break;
       }
       // At this point:
@@ -661,14 +801,15 @@ void Board::updateRayMoves(int r, int c) {
       // + Square is empty or has opponent's piece
       // This square a legal move. Add this move.
       moveList.push_back(raySquare);
-      moveList.push_back(i * COLS + j);
+      moveList.push_back(s);
       moveList.push_back(MOVE_NORMAL);
       // If square is not empty, look at other directions
-      if (board[i][j] != EMPTY) break;
+      if (piece != EMPTY) break;
     }
   }
 }
 
+template<Board::Colors Us>
 void Board::updateKnightMoves(int r, int c) {
   // Find out whether the king is checked or the knight is pinned
   // If there are 2 pieces that are checking king or this knight is pinned,
@@ -685,25 +826,23 @@ void Board::updateKnightMoves(int r, int c) {
   // Update knight's move
   // If there is a piece checking king, knight can only move between the checking piece and the king
 
-  int i,j; // The square we are considering
+  //Look into the knight squares
+  uint64_t targets = TABLES.knightAttacks[knightSquare];
+  while (targets) {
+    int s = popLowestSquare(targets); // The square we are considering
+    // if moving causes king danger (not going between king and the checking piece), check other squares
+    if ((checkingPieces[0] != -1) && !isInRay(checkingPieces[0], s, kingSquares[Us])) continue;
 
-  //Look into 8 knight directions
-  for (int d = 0; d < 8; d++) {
-    i = r + dirKnight[d][0];
-    j = c + dirKnight[d][1];
-    // if out of bound, check other directions
-    if ( i < 0 || i >= ROWS || j < 0 || j >= COLS) continue;
-    // if moving causes king danger (not going between king and the checking piece), check other directions
-    if ((checkingPieces[0] != -1) && !isInRay(checkingPieces[0], i * COLS + j, kingSquares[player])) continue;
-
-    if( board[i][j] == EMPTY || (player == (board[i][j] > MAX_BLACK_TYPE)) ) {//if square empty or has opponent, legal move
+    int piece = board[s/COLS][s%COLS];
+    if( piece == EMPTY || (Us == (piece > MAX_BLACK_TYPE)) ) {//if square empty or has opponent, legal move
       moveList.push_back(knightSquare);
-      moveList.push_back(i * 8 + j);
+      moveList.push_back(s);
       moveList.push_back(MOVE_NORMAL);
     }
   }
 }
 
+template<Board::Colors Us>
 void Board::updatePawnMoves(int r, int c) {
   // find out whether the king is checked or the pawn is pinned
   // if there are 2 pieces that are either checking king or pinning pawn,
@@ -728,12 +867,12 @@ void Board::updatePawnMoves(int r, int c) {
   // If there is a piece checking king or pinning pawn, pawn can only move between the checking piece and the kings
 
   int i,j; // the square we are considering
-  int moveForward = player? -1: 1; // white pawn moves up, black pawn moves down
+  int moveForward = Us? -1: 1; // white pawn moves up, black pawn moves down
 
-  bool canPromote = (r == (player? 1 : 6)); // is in the correct row for promotion
-  bool canDoubleJump = (r == (player? 6 : 1)); // is in the correct row for double jump
-  bool canEnPassant = (r == (player? 3 : 4))
-                      && (history.size() != 0) && (history[history.size()-1] == MOVE_PAWN_DOUBLE_JUMP); // is in the correct row for en passant, and the last move is a double jump
+  bool canPromote = (r == (Us? 1 : 6)); // is in the correct row for promotion
+  bool canDoubleJump = (r == (Us? 6 : 1)); // is in the correct row for double jump
+  int enPassantFile = (r == (Us? 3 : 4))? getEnPassantFile() : -1; // is in the correct row for en passant, and the last move is a double jump
+  bool canEnPassant = (enPassantFile != -1);
 
   //
   // Move straight
@@ -744,7 +883,7 @@ void Board::updatePawnMoves(int r, int c) {
   j = c;
 
   if (board[i][j] == EMPTY // empty square in front
-      && ((checkingSquare == -1) || isInRay(checkingSquare, i * COLS + j, kingSquares[player]))) {// no king danger if move there
+      && ((checkingSquare == -1) || isInRay(checkingSquare, i * COLS + j, kingSquares[Us]))) {// no king danger if move there
     // this pawn can jump 1 square forward
     if (canPromote) {
       // if can promote, add 4 moves (promote to queen, rook, knight, or bishop)
@@ -775,7 +914,7 @@ void Board::updatePawnMoves(int r, int c) {
   i += moveForward;
    //if in the correct row and the 1st square ahead is empty, and the 2nd square ahead is empty, can jump 2 squares ahead
   if (canDoubleJump && board[i][j] == EMPTY
-      && ((checkingSquare == -1) || isInRay(checkingSquare, i * COLS + j, kingSquares[player]))) {// no king danger if moves
+      && ((checkingSquare == -1) || isInRay(checkingSquare, i * COLS + j, kingSquares[Us]))) {// no king danger if moves
     moveList.push_back(pawnSquare);
     moveList.push_back(i * COLS + j);
     moveList.push_back(MOVE_PAWN_DOUBLE_JUMP);
@@ -784,17 +923,21 @@ void Board::updatePawnMoves(int r, int c) {
   //
   // Capture diagonally and en passant
   //
-  i = r + moveForward;
-  // check through the left and right column
-  for (j = c - 1; j <= c+1; j += 2) {
-    if (j < 0 || j >= COLS) continue; //out of bound
-
-    if ((checkingSquare == -1) || isInRay(checkingSquare, i * COLS + j, kingSquares[player])) {//no king danger if moves
-      if (canEnPassant && (j == history[history.size()-3] % COLS)) {// if in the correct row and correct col, can en passant
-        moveList.push_back(pawnSquare);
-        moveList.push_back(i * COLS + j);
-        moveList.push_back(MOVE_PAWN_EN_PASSANT);
-      } else if (board[i][j] != EMPTY && (player == (board[i][j] > MAX_BLACK_TYPE))) { // if has opponent, can capture
+  // check through the squares diagonally ahead (left and right column)
+  uint64_t targets = TABLES.pawnAttacks[Us][pawnSquare];
+  while (targets) {
+    int s = popLowestSquare(targets);
+    i = s / COLS;
+    j = s % COLS;
+
+    if ((checkingSquare == -1) || isInRay(checkingSquare, i * COLS + j, kingSquares[Us])) {//no king danger if moves
+      if (canEnPassant && (j == enPassantFile)) {// if in the correct row and correct col, can en passant
+        if (!isEnPassantPinned<Us>(r, c, j)) {
+          moveList.push_back(pawnSquare);
+          moveList.push_back(i * COLS + j);
+          moveList.push_back(MOVE_PAWN_EN_PASSANT);
+        }
+      } else if (board[i][j] != EMPTY && (Us == (board[i][j] > MAX_BLACK_TYPE))) { // if has opponent, can capture
         if (canPromote) {
           // if can promote by capturing diagonally
           int endSquare = i * COLS + j;
@@ -822,8 +965,8 @@ void Board::updatePawnMoves(int r, int c) {
       // can still remove the checking pawn and thus remove the check
 
       if (canEnPassant //last move is a double jump, and this pawn is in the correct row for en passant
-          && (history[history.size() - 3] == checkingSquare) //the double jumped pawn is the checking piece
-          && (j == history[history.size()-3] % COLS)) { // this pawn is in the correct col
+          && (r * COLS + enPassantFile == checkingSquare) //the double jumped pawn (next to this pawn) is the checking piece
+          && (j == enPassantFile)) { // this pawn is in the correct col
         moveList.push_back(pawnSquare);
         moveList.push_back(i * COLS + j);
         moveList.push_back(MOVE_PAWN_EN_PASSANT);
@@ -832,88 +975,449 @@ void Board::updatePawnMoves(int r, int c) {
   }
 }
 
+template<Board::Colors Us>
 bool Board::isSquareControlled(int r, int c) {
-  int i,j;
+  int square = r * COLS + c;
 
   //
-  // Check 8 knight's move
+  // Check the knight squares
   //
-  for (int d = 0; d < 8; d++) {
-    i = r + dirKnight[d][0];
-    j = c + dirKnight[d][1];
-    // if out of bound, check other directions
-    if ( i < 0 || i >= ROWS || j < 0 || j >= COLS) continue;
+  uint64_t knights = TABLES.knightAttacks[square];
+  while (knights) {
+    int s = popLowestSquare(knights);
     // has opponent's knight
-    if (board[i][j] == (player? WN : BN)) return true;
+    if (board[s/COLS][s%COLS] == (Us? WN : BN)) return true;
   }
 
   //
   // Check 8 ray directions
   //
   for(int d = 0; d < 8; d++) {
-    i = r;
-    j = c;
-    while(true) {
+    int s = square;
+    for (int k = 0; k < TABLES.squaresToEdge[square][d]; k++) {
       // advance 1 square in the direction d
-      i += dir[d][0];
-      j += dir[d][1];
-      // if out of bound
-      if (i < 0 || i > 7 || j < 0 || j > 7) break;
+      s += DIR_OFFSET[d];
+      int piece = board[s/COLS][s%COLS];
       // if empty square, advance 1 more square
-      if (board[i][j] == -1) continue;
+      if (piece == EMPTY) continue;
       // if it is opponent's piece
-      if (player == (board[i][j] > MAX_BLACK_TYPE)) {
+      if (Us == (piece > MAX_BLACK_TYPE)) {
         // if it's opponent's ray piece
-        int curPiece = board[i][j] % NUM_PIECE_TYPES; //remove color factor
-        if (curPiece == BQ || (d < 4 && curPiece == BR) || (d > 3 && curPiece == BB)) return true;
+        int curPiece = piece % NUM_PIECE_TYPES; //remove color factor
+        if (curPiece == BQ || (d <= MAX_CARDINAL_DIR && curPiece == BR) || (d >= MIN_DIAGONAL_DIR && curPiece == BB)) return true;
       }
       break;
     }
   }
 
   //
-  // Check pawn's control
+  // Check pawn's control (the squares a pawn of the current player would attack)
   //
-  i = player? (r - 1) : (r + 1);
-  j = c - 1; // left column
-  if (i >= 0 && i < ROWS && j >= 0 && j < COLS) {
-    if (board[i][j] == (player? WP : BP)) return true;
-  }
-  j = c + 1; // right column
-  if (i >= 0 && i < ROWS && j >= 0 && j < COLS)
-  {
-    if (board[i][j] == (player? WP : BP)) return true;
+  uint64_t pawns = TABLES.pawnAttacks[Us][square];
+  while (pawns) {
+    int s = popLowestSquare(pawns);
+    if (board[s/COLS][s%COLS] == (Us? WP : BP)) return true;
   }
 
   //
   // Check king's control
   //
-  for (int d = 0; d < 8; d++) {
-    i = r + dir[d][0];
-    j = c + dir[d][1];
-    if (i >= 0 && i < ROWS && j >= 0 && j < COLS) {
-      if (board[i][j] == (player? WK : BK)) return true;
-    }
+  uint64_t kings = TABLES.kingAttacks[square];
+  while (kings) {
+    int s = popLowestSquare(kings);
+    if (board[s/COLS][s%COLS] == (Us? WK : BK)) return true;
   }
 
   // if pass all tests, square is not controlled by opponent
   return false;
 }
 
+////////////////////////////////////////////////////////////////////////////
+//                              Zobrist keys
+////////////////////////////////////////////////////////////////////////////
+
+uint64_t Board::zobristPieces[NUM_COLORED_TYPES][NUM_SQUARES];
+uint64_t Board::zobristBlackToMove;
+uint64_t Board::zobristCastling[16];
+uint64_t Board::zobristEnPassant[COLS];
+bool Board::zobristInitialized = Board::initZobrist();
+
+bool Board::initZobrist() {
+  // xorshift64* generator with a fixed seed, so that keys are the same in every run
+  uint64_t seed = 1070372;
+  uint64_t* tables[4] = { &zobristPieces[0][0], &zobristBlackToMove, zobristCastling, zobristEnPassant };
+  int sizes[4] = { NUM_COLORED_TYPES * NUM_SQUARES, 1, 16, COLS };
+  for (int t = 0; t < 4; t++) {
+    for (int i = 0; i < sizes[t]; i++) {
+      seed ^= seed >> 12;
+      seed ^= seed << 25;
+      seed ^= seed >> 27;
+      tables[t][i] = seed * 2685821657736338717ULL;
+    }
+  }
+  return true;
+}
+
+void Board::setSquare(int r, int c, int piece) {
+  int square = r * COLS + c;
+  int oldPiece = board[r][c];
+  if (oldPiece != EMPTY) {
+    hashKey ^= zobristPieces[oldPiece][square];
+    if (oldPiece == WP || oldPiece == BP) pawnKey ^= zobristPieces[oldPiece][square];
+    if (nnue != NULL) nnue->removePiece(accumulator, oldPiece, square);
+  }
+  board[r][c] = piece;
+  if (piece != EMPTY) {
+    hashKey ^= zobristPieces[piece][square];
+    if (piece == WP || piece == BP) pawnKey ^= zobristPieces[piece][square];
+    if (nnue != NULL) nnue->addPiece(accumulator, piece, square);
+  }
+}
+
+void Board::computeKeys() {
+  hashKey = 0;
+  pawnKey = 0;
+  for (int s = 0; s < NUM_SQUARES; s++) {
+    int piece = board[s/COLS][s%COLS];
+    if (piece == EMPTY) continue;
+    hashKey ^= zobristPieces[piece][s];
+    if (piece == WP || piece == BP) pawnKey ^= zobristPieces[piece][s];
+  }
+  if (player == BLACK) hashKey ^= zobristBlackToMove;
+  hashKey ^= zobristCastling[getCastlingRights()];
+  int enPassant = getEnPassantFile();
+  if (enPassant != -1) hashKey ^= zobristEnPassant[enPassant];
+}
+
+int Board::getCastlingRights() {
+  int rights = 0;
+  for (int color = WHITE; color <= BLACK; color++) {
+    if (castlingFirstMove[color]) continue; // king has moved
+    if (!castlingFirstMove[color + 2]) rights |= 1 << (2 * color);     // left rook
+    if (!castlingFirstMove[color + 4]) rights |= 1 << (2 * color + 1); // right rook
+  }
+  return rights;
+}
+
+int Board::getEnPassantFile() {
+  int i = history.size();
+  if (i == 0) return startEnPassantFile;
+  if (history[i-1] != MOVE_PAWN_DOUBLE_JUMP) return -1;
+  return history[i-3] % COLS;
+}
+
+void Board::updateStateKey(int oldRights, int oldEnPassant) {
+  int newRights = getCastlingRights();
+  if (newRights != oldRights) hashKey ^= zobristCastling[oldRights] ^ zobristCastling[newRights];
+  int newEnPassant = getEnPassantFile();
+  if (newEnPassant != oldEnPassant) {
+    if (oldEnPassant != -1) hashKey ^= zobristEnPassant[oldEnPassant];
+    if (newEnPassant != -1) hashKey ^= zobristEnPassant[newEnPassant];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                           Neural evaluation
+////////////////////////////////////////////////////////////////////////////
+
+void Board::attachNNUE(NNUE* net) {
+  nnue = net;
+  if (nnue != NULL) refreshAccumulator();
+}
+
+NNUE* Board::getNNUE() {
+  return nnue;
+}
+
+int Board::evaluateNNUE() {
+  int score = nnue->evaluate(accumulator, player);
+  return player? -score : score;
+}
+
+void Board::refreshAccumulator() {
+  nnue->resetAccumulator(accumulator);
+  for (int s = 0; s < NUM_SQUARES; s++) {
+    int piece = board[s/COLS][s%COLS];
+    if (piece != EMPTY) nnue->addPiece(accumulator, piece, s);
+  }
+}
+
+bool Board::isRayPiece(int square) {
+  int pType = board[square/COLS][square%COLS] % NUM_PIECE_TYPES;
+  return pType == BQ || pType == BR || pType == BB;
+}
+
+template<Board::Colors Us>
+bool Board::isEnPassantPinned(int r, int c, int capturedCol) {
+  // Only a king on the same row can be exposed:
+  // en passant removes 2 pawns from that row at once, which findPinAndCheck does not see as a pin.
+  int kingSquare = kingSquares[Us];
+  if (kingSquare / COLS != r) return false;
+
+  // walk from the king past the 2 pawns, and look for an opponent's rook or queen
+  int d = (c > kingSquare % COLS)? 0 : 1; // right or left
+  int s = kingSquare;
+  for (int k = 0; k < TABLES.squaresToEdge[kingSquare][d]; k++) {
+    s += DIR_OFFSET[d];
+    int j = s % COLS;
+    if (j == c || j == capturedCol || board[r][j] == EMPTY) continue;
+    return (board[r][j] == (Us? WR : BR)) || (board[r][j] == (Us? WQ : BQ));
+  }
+  return false;
+}
+
 bool Board::isInRay(int s1, int s2, int s3) {
-  int x1 = s1 / COLS;
-  int y1 = s1 % COLS;
-  int x2 = s2 / COLS;
-  int y2 = s2 % COLS;
-  int x3 = s3 / COLS;
-  int y3 = s3 % COLS;
-
-  return ((x1 - x2) * (y1 - y3) == (x1 - x3) * (y1 - y2)) // 3 squares are in a line
-         && ((x2 >= x1 && x2 <= x3) || (x2 <= x1 && x2 >= x3)) // square 2's row is in the middle of square 1 and square 2
-         && ((y2 >= y1 && y2 <= y3) || (y2 <= y1 && y2 >= y3)); // square 2's col is in the middle of square 1 and square 2
+  return s2 == s1 || s2 == s3 || (TABLES.between[s1][s3] >> s2 & 1);
 }
 
 
+////////////////////////////////////////////////////////////////////////////
+//                        Static exchange evaluation
+////////////////////////////////////////////////////////////////////////////
+
+// Q, K, R, N, B, P. The king is worth more than everything else, so it only captures last.
+const int Board::SEE_VALUES[NUM_PIECE_TYPES] = {900, 20000, 500, 320, 330, 100};
+
+bool Board::isCapture(int moveIndex) {
+  int i = moveIndex * MOVE_LENGTH_MOVE_LIST;
+  int to = moveList[i+1];
+  return board[to/COLS][to%COLS] != EMPTY || moveList[i+2] == MOVE_PAWN_EN_PASSANT;
+}
+
+int Board::see(int moveIndex) {
+  int i = moveIndex * MOVE_LENGTH_MOVE_LIST;
+  int from = moveList[i];
+  int to = moveList[i+1];
+  int moveType = moveList[i+2];
+  if (moveType == MOVE_CASTLING) return 0;
+
+  // gain[d]: the material won by the player making the d-th capture, if the exchange stops after it
+  int gain[32];
+  int d = 0;
+  uint64_t removed = 1ULL << from;
+  int captured = board[to/COLS][to%COLS];
+  if (moveType == MOVE_PAWN_EN_PASSANT) {
+    captured = BP;
+    removed |= 1ULL << (from / COLS * COLS + to % COLS);
+  }
+  gain[0] = (captured == EMPTY)? 0 : SEE_VALUES[captured % NUM_PIECE_TYPES];
+  int onSquare = SEE_VALUES[board[from/COLS][from%COLS] % NUM_PIECE_TYPES]; // value of the piece on the ending square
+  if (moveType >= MOVE_PROMOTION_QUEEN) {
+    static const int promoted[4] = {BQ, BR, BN, BB};
+    onSquare = SEE_VALUES[promoted[moveType - MOVE_PROMOTION_QUEEN]];
+    gain[0] += onSquare - SEE_VALUES[BP];
+  }
+
+  int color = 1 - player;
+  while (d < 31) {
+    int attacker = getLeastValuableAttacker(to, color, removed);
+    if (attacker == -1) break;
+    d++;
+    gain[d] = onSquare - gain[d-1];
+    onSquare = SEE_VALUES[board[attacker/COLS][attacker%COLS] % NUM_PIECE_TYPES];
+    removed |= 1ULL << attacker;
+    color = 1 - color;
+  }
+  // each player may stop capturing when it is better for them
+  while (d > 0) {
+    if (gain[d] > -gain[d-1]) gain[d-1] = -gain[d];
+    d--;
+  }
+  return gain[0];
+}
+
+int Board::getLeastValuableAttacker(int square, int color, uint64_t removed) {
+  int best = -1;
+  int bestValue = SEE_VALUES[BK] + 1;
+
+  // pawns (a pawn of this color attacks the square from where a pawn of the other color would attack)
+  uint64_t pawns = TABLES.pawnAttacks[1 - color][square] & ~removed;
+  int pawn = (color == WHITE)? WP : BP;
+  while (pawns) {
+    int s = popLowestSquare(pawns);
+    if (board[s/COLS][s%COLS] == pawn) return s;
+  }
+
+  // knights
+  uint64_t knights = TABLES.knightAttacks[square] & ~removed;
+  int knight = (color == WHITE)? WN : BN;
+  while (knights) {
+    int s = popLowestSquare(knights);
+    if (board[s/COLS][s%COLS] == knight) return s;
+  }
+
+  // sliders and king: the first piece on each ray, skipping removed pieces (x-rays)
+  for (int d = 0; d < 8; d++) {
+    int s = square;
+    for (int dist = 1; dist <= TABLES.squaresToEdge[square][d]; dist++) {
+      s += DIR_OFFSET[d];
+      int piece = board[s/COLS][s%COLS];
+      if (piece == EMPTY || (removed >> s & 1)) continue;
+      if ((piece < MIN_WHITE_TYPE) == (color == BLACK)) {
+        int type = piece % NUM_PIECE_TYPES;
+        bool attacks = (type == BQ) || (type == BR && d <= MAX_CARDINAL_DIR) || (type == BB && d >= MIN_DIAGONAL_DIR)
+                       || (type == BK && dist == 1);
+        if (attacks && SEE_VALUES[type] < bestValue) {
+          bestValue = SEE_VALUES[type];
+          best = s;
+        }
+      }
+      break;
+    }
+  }
+  return best;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                               Notation
+////////////////////////////////////////////////////////////////////////////
+
+// letters of the uncolored piece types (piece % NUM_PIECE_TYPES), pawns have none in SAN
+static const char PIECE_LETTERS[] = "QKRNBP";
+// letters of the promotion types, from MOVE_PROMOTION_QUEEN
+static const char PROMOTION_LETTERS[] = "QRNB";
+
+std::string Board::getMoveSAN(int moveIndex) {
+  char san[SAN_BUFFER_SIZE];
+  return std::string(san, writeMoveSAN(moveIndex, san));
+}
+
+int Board::writeMoveSAN(int moveIndex, char* san) {
+  san[0] = '\0';
+  if (promotionSquare != -1 || moveIndex < 0 || moveIndex >= getNumMoves()) return 0;
+
+  int i = moveIndex * MOVE_LENGTH_MOVE_LIST;
+  int from = moveList[i];
+  int to = moveList[i+1];
+  int moveType = moveList[i+2];
+  int piece = board[from/COLS][from%COLS] % NUM_PIECE_TYPES;
+
+  int length = 0;
+  if (moveType == MOVE_CASTLING) {
+    const char* castling = (to % COLS == 2)? "O-O-O" : "O-O";
+    while (*castling != '\0') san[length++] = *castling++;
+  } else {
+    bool capture = board[to/COLS][to%COLS] != EMPTY || moveType == MOVE_PAWN_EN_PASSANT;
+    if (piece == BP) {
+      if (capture) san[length++] = 'a' + from % COLS;
+    } else {
+      san[length++] = PIECE_LETTERS[piece];
+      // add the starting file and/or row if another piece of the same type can go to the same square
+      bool ambiguous = false, sameCol = false, sameRow = false;
+      for (int j = 0; j < moveList.size(); j += MOVE_LENGTH_MOVE_LIST) {
+        int other = moveList[j];
+        if (moveList[j+1] != to || other == from) continue;
+        if (board[other/COLS][other%COLS] % NUM_PIECE_TYPES != piece) continue;
+        ambiguous = true;
+        if (other % COLS == from % COLS) sameCol = true;
+        if (other / COLS == from / COLS) sameRow = true;
+      }
+      if (ambiguous && (!sameCol || sameRow)) san[length++] = 'a' + from % COLS;
+      if (ambiguous && sameCol) san[length++] = '1' + from / COLS;
+    }
+    if (capture) san[length++] = 'x';
+    san[length++] = 'a' + to % COLS;
+    san[length++] = '1' + to / COLS;
+    if (moveType >= MOVE_PROMOTION_QUEEN) {
+      san[length++] = '=';
+      san[length++] = PROMOTION_LETTERS[moveType - MOVE_PROMOTION_QUEEN];
+    }
+  }
+
+  // check or check mate
+  int oldChosenSquare = chosenSquare;
+  makeMove(moveIndex);
+  if (isKingChecked()) san[length++] = (getNumMoves() == 0)? '#' : '+';
+  undoMove();
+  chosenSquare = oldChosenSquare;
+  san[length] = '\0';
+  return length;
+}
+
+int Board::findMoveSAN(std::string san) {
+  return findMoveSAN(san.c_str(), san.size());
+}
+
+// index of c in letters (a string literal), -1 if c is not one of them
+static int letterIndex(const char* letters, char c) {
+  for (int i = 0; letters[i] != '\0'; i++) {
+    if (letters[i] == c) return i;
+  }
+  return -1;
+}
+
+int Board::findMoveSAN(const char* san, int length) {
+  // remove suffixes
+  while (length > 0 && letterIndex("+#!?", san[length-1]) != -1) length--;
+
+  // castling: the king's destination column
+  int castlingCol = -1;
+  if (length == 3 && (strncmp(san, "O-O", 3) == 0 || strncmp(san, "0-0", 3) == 0)) castlingCol = 6;
+  if (length == 5 && (strncmp(san, "O-O-O", 5) == 0 || strncmp(san, "0-0-0", 5) == 0)) castlingCol = 2;
+  if (castlingCol != -1) {
+    for (int j = 0; j < moveList.size(); j += MOVE_LENGTH_MOVE_LIST) {
+      if (moveList[j+2] == MOVE_CASTLING && moveList[j+1] % COLS == castlingCol) return j / MOVE_LENGTH_MOVE_LIST;
+    }
+    return -1;
+  }
+
+  // piece letter (uppercase only, a lowercase 'b' is a file)
+  int piece = BP;
+  int pos = 0;
+  if (length > 0 && san[0] != 'P' && letterIndex(PIECE_LETTERS, san[0]) != -1) {
+    piece = letterIndex(PIECE_LETTERS, san[0]);
+    pos = 1;
+  } else if (length > 0 && san[0] == 'P') {
+    pos = 1;
+  }
+
+  // promotion, with or without '='
+  int promotionType = -1;
+  if (length >= 2 && letterIndex(PROMOTION_LETTERS, toupper(san[length-1])) != -1
+      && (san[length-2] == '=' || isdigit(san[length-2]))) {
+    promotionType = MOVE_PROMOTION_QUEEN + letterIndex(PROMOTION_LETTERS, toupper(san[length-1]));
+    length -= (san[length-2] == '=')? 2 : 1;
+  }
+
+  // the rest: optional starting file and row, then the destination square
+  char squares[4];
+  int numSquares = 0;
+  for (int k = pos; k < length; k++) {
+    if (san[k] == 'x' || san[k] == '-' || san[k] == ':') continue;
+    if (!(san[k] >= 'a' && san[k] <= 'h') && !(san[k] >= '1' && san[k] <= '8')) return -1;
+    if (numSquares == 4) return -1;
+    squares[numSquares++] = san[k];
+  }
+  if (numSquares < 2) return -1;
+  char toCol = squares[numSquares-2];
+  char toRow = squares[numSquares-1];
+  if (toCol < 'a' || toCol > 'h' || toRow < '1' || toRow > '8') return -1;
+  int to = (toRow - '1') * COLS + (toCol - 'a');
+  int fromCol = -1, fromRow = -1;
+  for (int k = 0; k + 2 < numSquares; k++) {
+    if (squares[k] >= 'a' && squares[k] <= 'h') fromCol = squares[k] - 'a';
+    else fromRow = squares[k] - '1';
+  }
+
+  int found = -1;
+  for (int j = 0; j < moveList.size(); j += MOVE_LENGTH_MOVE_LIST) {
+    int from = moveList[j];
+    int moveType = moveList[j+2];
+    if (moveList[j+1] != to || moveType == MOVE_CASTLING) continue;
+    if (board[from/COLS][from%COLS] % NUM_PIECE_TYPES != piece) continue;
+    if (fromCol != -1 && from % COLS != fromCol) continue;
+    if (fromRow != -1 && from / COLS != fromRow) continue;
+    if (moveType >= MOVE_PROMOTION_QUEEN) {
+      if (moveType != promotionType) continue;
+    } else if (promotionType != -1) {
+      continue;
+    }
+    if (found != -1) return -1; // ambiguous
+    found = j / MOVE_LENGTH_MOVE_LIST;
+  }
+  return found;
+}
+
 ////////////////////////////////////////////////////////////////////////////
 //                                Debug
 ////////////////////////////////////////////////////////////////////////////
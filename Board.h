@@ -12,18 +12,30 @@
 #ifndef BOARD_H
 #define BOARD_H
 
+#include <stdint.h>
+#include <string>
 #include <vector>
 
+#include "NNUE.h"
+
 class Board
 {
 public:
-  Board() {};
+  Board() { nnue = NULL; };
 
   /**
    * Refresh the board to standard starting position.
    */
   void initBoard();
 
+  /**
+   * Set up the board from a FEN string. The halfmove and fullmove counters are ignored.
+   * The history starts empty: the game can't be undone past the FEN's position.
+   * @param fen: the position in Forsyth-Edwards Notation.
+   * @return true if the FEN is valid. If false, the board is set to the starting position.
+   */
+  bool loadFEN(std::string fen);
+
   /***************************************************************************
    *                       Constants used in Board
    ***************************************************************************/
@@ -68,6 +80,24 @@ public:
     MOVE_PROMOTION_BISHOP
   };
 
+  /**
+   * A read-only view of consecutive ints owned by the board (no copy).
+   * Only valid until the board changes (a move is made or undone, or a position is loaded).
+   */
+  class View {
+  public:
+    View(const int* first, int length) : data(first), length(length) {}
+    const int* begin() const { return data; }
+    const int* end() const { return data + length; }
+    int size() const { return length; }
+    bool empty() const { return length == 0; }
+    int operator[](int i) const { return data[i]; }
+
+  private:
+    const int* data;
+    int length;
+  };
+
   /***************************************************************************
    *                            Getter Methods
    ***************************************************************************/
@@ -103,6 +133,31 @@ public:
    */
   std::vector<int> getMoveList();
 
+  /**
+   * @return a view of the move list, MOVE_LENGTH_MOVE_LIST ints per move (without copying it).
+   */
+  View getMoveListView();
+
+  /**
+   * Get the moves starting from a square, using an index built with the move list.
+   * @param square: the starting square (0 -> 63)
+   * @return a view of the part of the move list with these moves (MOVE_LENGTH_MOVE_LIST ints per move).
+   * The first move of the view is move number getFirstMoveFrom(square) in the move list.
+   */
+  View getMovesFrom(int square);
+
+  /**
+   * @return the move number of the first move starting from a square (moves from a square are consecutive).
+   */
+  int getFirstMoveFrom(int square);
+
+  /**
+   * Find a move from its starting and ending square, without scanning the whole move list.
+   * @return the move number in move list, -1 if there is no such move.
+   * For a promotion, the queen promotion is returned (the other promotions follow it).
+   */
+  int findMove(int square1, int square2);
+
   /**
    * Get current king's position.
    * @param color: WHITE or BLACK
@@ -132,6 +187,11 @@ public:
    */
   std::vector<int> getHistory();
 
+  /**
+   * @return a view of the history, MOVE_LENGTH_HISTORY ints per move (without copying it).
+   */
+  View getHistoryView();
+
   /**
    * Get the number of moves (or half-turn) made since game start
    */
@@ -144,6 +204,111 @@ public:
    */
   int getWinner();
 
+  /**
+   * Get the Zobrist key of the current position.
+   * The key covers all pieces, the player to move, castling rights and the en passant file.
+   * It is updated incrementally when moves are made and undone.
+   */
+  uint64_t getHashKey();
+
+  /**
+   * Get the Zobrist key of the pawns only (both colors).
+   * Pawn structure changes rarely, so this key is used to cache pawn evaluation.
+   */
+  uint64_t getPawnKey();
+
+  /**
+   * Get the castling rights as a 4 bit mask.
+   * Bit 0/1: white left/right rook, bit 2/3: black left/right rook.
+   */
+  int getCastlingRights();
+
+  /**
+   * @return the file of the pawn that double jumped in the last move, -1 if the last move is not a double jump.
+   * Before the first move, the en passant file of the FEN the board was loaded from.
+   */
+  int getEnPassantFile();
+
+  /***************************************************************************
+   *                           Neural evaluation
+   ***************************************************************************/
+
+  /**
+   * Attach a neural network to the board.
+   * The network's accumulator is refreshed now, then updated incrementally by every move and undo.
+   * @param net: a loaded network, or NULL to stop updating the accumulator.
+   */
+  void attachNNUE(NNUE* net);
+
+  /**
+   * @return the attached network, NULL if there is none.
+   */
+  NNUE* getNNUE();
+
+  /**
+   * Evaluate the board with the attached network. Must only be called when a network is attached.
+   * @return the score of the board (in white's perspective)
+   */
+  int evaluateNNUE();
+
+  /***************************************************************************
+   *                        Static exchange evaluation
+   ***************************************************************************/
+
+  /**
+   * @param moveIndex: the move number according to move list (starting from 0)
+   * @return true if the move captures a piece (including en passant).
+   */
+  bool isCapture(int moveIndex);
+
+  /**
+   * Static exchange evaluation: the material won by the player to move when making a move,
+   * assuming both players then keep capturing on its ending square with their least valuable piece
+   * (and may stop whenever it is better for them). Pieces behind the capturing pieces
+   * (x-rays) join in as the squares in front of them are emptied. Pins are ignored.
+   * @param moveIndex: the move number according to move list (starting from 0)
+   * @return the material balance of the exchange in centipawns (0 for a quiet move that cannot be captured).
+   */
+  int see(int moveIndex);
+
+  /***************************************************************************
+   *                               Notation
+   ***************************************************************************/
+
+  /**
+   * Get a move in Standard Algebraic Notation (e.g. "Nbd2", "exd6", "e8=Q+", "O-O-O#").
+   * The check suffix is found by making and undoing the move.
+   * @param moveIndex: the move number according to move list (starting from 0)
+   * @return the move in SAN, empty if the move does not exist or a promotion is pending.
+   */
+  std::string getMoveSAN(int moveIndex);
+
+  static const int SAN_BUFFER_SIZE = 8; /**< Enough for the longest SAN (e.g. "Qh4xe1+", "exd8=Q#") and its '\0' */
+
+  /**
+   * Write a move in Standard Algebraic Notation into a buffer, without allocating (see getMoveSAN).
+   * @param moveIndex: the move number according to move list (starting from 0)
+   * @param san: a buffer of at least SAN_BUFFER_SIZE chars, receives the null-terminated move.
+   * @return the length of the move, 0 if the move does not exist or a promotion is pending.
+   */
+  int writeMoveSAN(int moveIndex, char* san);
+
+  /**
+   * Find a move written in Standard Algebraic Notation.
+   * Accepts "0-0" for castling, a redundant disambiguation or "x",
+   * a promotion with or without "=", and ignores the suffixes "+", "#", "!", "?".
+   * @param san: the move in SAN.
+   * @return the move number in move list, -1 if there is no such move or it is ambiguous.
+   */
+  int findMoveSAN(std::string san);
+
+  /**
+   * Find a move written in Standard Algebraic Notation, without allocating (see findMoveSAN).
+   * @param san: the move's first char, not necessarily null-terminated.
+   * @param length: the number of chars of the move.
+   */
+  int findMoveSAN(const char* san, int length);
+
   /***************************************************************************
    *                         Move making and undoing
    ***************************************************************************/
@@ -242,6 +407,7 @@ private:
    * Keep track of when the kings and rooks first move. Used for castling.
    * Order: king, left rook, right rook. The even flags are for white, and the odds are for black.
    * Value: 0 if the piece has not moved, otherwise the size of the history when the piece first moved.
+   * -1 if the piece had already moved before the position was loaded from a FEN.
    */
   int castlingFirstMove[6];
 
@@ -251,6 +417,13 @@ private:
    */
   std::vector<int> moveList;
 
+  /**
+   * Index of the move list by starting square: the number of the first move starting from each square,
+   * and the number of moves starting from it. Updated with the move list.
+   */
+  int firstMoveFrom[NUM_SQUARES];
+  int numMovesFrom[NUM_SQUARES];
+
   /**
    * The history of the game.
    * Each move uses 4 ints: starting square (0->63), ending square(0->63),
@@ -258,6 +431,11 @@ private:
    */
   std::vector<int> history;
 
+  /**
+   * The en passant file of the position loaded by loadFEN (-1 if none), used while the history is empty.
+   */
+  int startEnPassantFile;
+
   /**
    * The square chosen by current player.
    * Used to display chosen piece on screen.
@@ -271,6 +449,75 @@ private:
    */
   int promotionSquare;
 
+  /***************************************************************************
+   *                        Static exchange evaluation
+   ***************************************************************************/
+
+  static const int SEE_VALUES[NUM_PIECE_TYPES]; /**< Value of each uncolored piece type in exchanges */
+
+  /**
+   * Find the least valuable piece of a player attacking a square, ignoring the removed pieces.
+   * @param removed: a bit for each square whose piece has already been used in the exchange.
+   * @return the square of the attacker, -1 if there is none.
+   */
+  int getLeastValuableAttacker(int square, int color, uint64_t removed);
+
+  /***************************************************************************
+   *                              Zobrist keys
+   ***************************************************************************/
+
+  uint64_t hashKey; /**< Zobrist key of the whole position */
+  uint64_t pawnKey; /**< Zobrist key of the pawns */
+
+  static uint64_t zobristPieces[NUM_COLORED_TYPES][NUM_SQUARES]; /**< Random keys for each piece on each square */
+  static uint64_t zobristBlackToMove; /**< Xor-ed into the key when black is to move */
+  static uint64_t zobristCastling[16]; /**< Random keys for each combination of castling rights */
+  static uint64_t zobristEnPassant[COLS]; /**< Random keys for the file of a pawn that just double jumped */
+  static bool zobristInitialized; /**< Set when the random keys are generated (before main) */
+
+  /**
+   * Fill the Zobrist tables with pseudo-random numbers from a fixed seed.
+   * @return true, so that it can initialize zobristInitialized.
+   */
+  static bool initZobrist();
+
+  /**
+   * Put a piece on a square, and update the Zobrist keys accordingly.
+   * Every change of the board array goes through here.
+   * @param r, c: the row and column of the square (0 -> 7).
+   * @param piece: the new content of the square (Board::EMPTY to clear it).
+   */
+  void setSquare(int r, int c, int piece);
+
+  /**
+   * Compute hashKey and pawnKey from scratch.
+   */
+  void computeKeys();
+
+  /**
+   * Update hashKey after castling rights or en passant file have changed.
+   * @param oldRights, oldEnPassant: the castling rights and en passant file before the change.
+   */
+  void updateStateKey(int oldRights, int oldEnPassant);
+
+  /***************************************************************************
+   *                           Neural evaluation
+   ***************************************************************************/
+
+  NNUE* nnue; /**< The attached network, NULL if none */
+  NNUE::Accumulator accumulator; /**< The network's hidden layer for the current board */
+
+  /**
+   * Compute the accumulator from scratch.
+   */
+  void refreshAccumulator();
+
+  /**
+   * Set the castling flag of a king or rook that moves for the first time, or of a rook that is captured.
+   * @param square1, square2: the starting and ending square of the move.
+   */
+  void updateCastlingFlags(int square1, int square2);
+
   /***************************************************************************
    *                         Legal move generation
    ***************************************************************************/
@@ -289,68 +536,94 @@ private:
   std::vector<int> pinPieces;
 
   /**
-   * 8 basic directions.
-   * The first 4 are cardinal (vertical and horizontal). The last 4 are diagonal.
+   * Generate the list of available move.
+   * Should be called after making a move.
+   * Calls generateMoves for the current player.
+   */
+  void updateMoveList();
+
+  /*
+   * The methods below are templates on the player to move (Us),
+   * so that all color-dependent values are constants in the compiled code.
+   * They are chosen once per move (in updateMoveList, makeMove and undoMove).
+   * The effect on branch misses has not been measured yet: run movegen_bench against
+   * the previous Board on a machine with hardware counters.
    */
-  static const int dir[8][2];
-  static const int MAX_CARDINAL_DIR = 3; /**< The greatest value of a cardinal direction */
-  static const int MIN_DIAGONAL_DIR = 4; /**< The smallest value of a diagonal direction */
 
   /**
-   * 8 knight's directions (L shaped moves)
+   * Generate the list of available move for player Us (the current player).
    */
-  static const int dirKnight[8][2];
+  template<Colors Us> void generateMoves();
 
   /**
-   * Generate the list of available move.
-   * Should be called after making a move.
+   * Make a move of player Us (the current player). See makeMove.
    */
-  void updateMoveList();
+  template<Colors Us> void makeMoveFor(int moveIndex);
+
+  /**
+   * Undo the last move, made by player Us. See undoMove.
+   */
+  template<Colors Us> void undoMoveFor();
 
   /**
    * Check if king is checked by opponent, and if any piece is pinned.
    * Should be called before updating individual piece's moves.
    */
-  void findPinAndCheck();
+  template<Colors Us> void findPinAndCheck();
 
   /**
    * Add all available king moves (including castling) to move list.
    * @param r, c: the row and column of the king (0 -> 7).
    */
-  void updateKingMoves(int r, int c);
+  template<Colors Us> void updateKingMoves(int r, int c);
 
   /**
    * Add all available moves of a ray piece to move list.
    * @param r, c: the row and column of the ray piece (0 -> 7).
    */
-  void updateRayMoves(int r, int c);
+  template<Colors Us> void updateRayMoves(int r, int c);
 
   /**
    * Add all available moves of a knight to move list.
    * @param r, c: the row and column of the knight (0 -> 7).
    */
-  void updateKnightMoves(int r, int c);
+  template<Colors Us> void updateKnightMoves(int r, int c);
 
   /**
    * Add all available moves of a pawn to move list.
    * @param r, c: the row and column of the pawn (0 -> 7).
    */
-  void updatePawnMoves(int r, int c);
+  template<Colors Us> void updatePawnMoves(int r, int c);
 
   /**
-   * Check if a square is controlled by the opponent.
+   * Check if a square is controlled by the opponent of player Us.
    * @param r, c: the row and column of the square (0 -> 7).
    * @return true if square is controlled.
    */
-  bool isSquareControlled(int r, int c);
+  template<Colors Us> bool isSquareControlled(int r, int c);
 
   /**
-   * Check if 3 squares are in a line, in the given order.
+   * Check if 3 squares are in a line, in the given order (using the between table of BoardTables.h).
    * Use to check for legal move when king is checked, or a piece is pinned.
    * @param s1, s2, s3: 3 squares.
    * @return true if square 2 is between square 1 and square 3 in a line (square 2 can be square 1 or square 3).
    */
   bool isInRay(int s1, int s2, int s3);
+
+  /**
+   * @param square: a square with a piece (0 -> 63).
+   * @return true if the piece is a queen, rook or bishop.
+   */
+  bool isRayPiece(int square);
+
+  /**
+   * Check if an en passant capture would leave the king in check along the row,
+   * because both the capturing and the captured pawn leave that row.
+   * @param r, c: the row and column of the capturing pawn (0 -> 7).
+   * @param capturedCol: the column of the captured pawn.
+   * @return true if the en passant capture is illegal.
+   */
+  template<Colors Us> bool isEnPassantPinned(int r, int c, int capturedCol);
 };
 
 #endif // BOARD_H
@@ -3,8 +3,12 @@
 #include <stdio.h>
 
 
-BoardGUI::BoardGUI(Board* brd, SDL_Renderer* renderer) {
+BoardGUI::BoardGUI(Board* brd, SDL_Renderer* renderer, ResourceManager& resources) {
   this->b = brd;
+  this->renderer = renderer;
+  staticLayer = NULL;
+  staticLayerValid = false;
+  layerTargetResets = 0;
 
   ////////////////////////////////////////////////////////////////////////////
   //   Set an array of boxes so that GUI can return clicks on these boxes
@@ -30,22 +34,22 @@ BoardGUI::BoardGUI(Board* brd, SDL_Renderer* renderer) {
   /////////////////////////////////////////////////////////////////////////////
   //                 Load media and initialize position
   /////////////////////////////////////////////////////////////////////////////
-  boardImg.loadFromFile(renderer, "img/boardGUI/board.jpg");
-  piecesSprite.loadFromFile(renderer, "img/boardGUI/pieces.png");
-  piecesSprite.setBlendMode(SDL_BLENDMODE_BLEND); // piece can be made transparent
-  moveArrow.loadFromFile(renderer, "img/boardGUI/arrow.png");
+  resources.load(&boardImg, "img/boardGUI/board.jpg");
+  resources.load(&piecesSprite, "img/boardGUI/pieces.png");
+  // piece can be made transparent: the atlases are created with SDL_BLENDMODE_BLEND
+  resources.load(&moveArrow, "img/boardGUI/arrow.png");
 
-  undoButton.loadFromFile(renderer, "img/boardGUI/undoButton.png");
-  homeButton.loadFromFile(renderer, "img/boardGUI/homeButton.png");
+  resources.load(&undoButton, "img/boardGUI/undoButton.png");
+  resources.load(&homeButton, "img/boardGUI/homeButton.png");
 
-  playerTxt.loadFromFile(renderer, "img/boardGUI/Player.png");
-  comTxt.loadFromFile(renderer, "img/boardGUI/COM.png");
-  promoteTxt.loadFromFile(renderer, "img/boardGUI/promotionTxt.png");
+  resources.load(&playerTxt, "img/boardGUI/Player.png");
+  resources.load(&comTxt, "img/boardGUI/COM.png");
+  resources.load(&promoteTxt, "img/boardGUI/promotionTxt.png");
 
-  colorSymbols[0].loadFromFile(renderer, "img/boardGUI/whiteSymbol.png");
-  colorSymbols[1].loadFromFile(renderer, "img/boardGUI/blackSymbol.png");
+  resources.load(&colorSymbols[0], "img/boardGUI/whiteSymbol.png");
+  resources.load(&colorSymbols[1], "img/boardGUI/blackSymbol.png");
 
-  crosshair.loadFromFile(renderer, "img/boardGUI/crosshair.png");
+  resources.load(&crosshair, "img/boardGUI/crosshair.png");
 
   //position of piece's image on sprite sheet
   for(int i = 0; i < 12; i++) {
@@ -67,22 +71,18 @@ BoardGUI::BoardGUI(Board* brd, SDL_Renderer* renderer) {
   promotePieceRects[1] = {617, 403, 50, 50};
   promotePieceRects[2] = {617, 465, 50, 50};
   promotePieceRects[3] = {617, 528, 50, 50};
+  searchPanelRect = {608, 290, 184, 290};
 
   /////////////////////////////////////////////////////////////////////////////
   //                              Load audio
   /////////////////////////////////////////////////////////////////////////////
-  bgm = Mix_LoadMUS("sound/bgm.mp3");
-  if (!bgm) {
-    printf("Failed to load music. SDL_Mix error: %s\n", Mix_GetError());
-  }
-
-  moveSFX = Mix_LoadWAV("sound/chess move.wav");
-  if (!moveSFX) {
-    printf("Failed to load music. SDL_Mix error: %s\n", Mix_GetError());
-  }
+  resources.loadMusic(&bgm, "sound/bgm.mp3");
+  resources.loadSound(&moveSFX, "sound/chess move.wav");
 }
 
-BoardGUI::~BoardGUI() {};
+BoardGUI::~BoardGUI() {
+  if (staticLayer != NULL) SDL_DestroyTexture(staticLayer);
+}
 
 void BoardGUI::updateMovePointers() {
   availableMoves.clear();
@@ -90,18 +90,138 @@ void BoardGUI::updateMovePointers() {
   if (chosenSquare >= 0 && chosenSquare < Board::NUM_SQUARES) {
     b->getMovesFromSquare(availableMoves, chosenSquare);
   }
+  if (!availableMoves.empty() && !arrowHeight.isRunning(SDL_GetTicks())) {
+    arrowHeight.start(ARROW_LOW, ARROW_HIGH, ARROW_BOUNCE_MS, SDL_GetTicks(), Tween::LINEAR, Tween::PING_PONG);
+  }
 }
 
 void BoardGUI::setPlayer(int color) {
   humanSide = color;
+  searchTxt.clear();
+  staticLayerValid = false;
+}
+
+void BoardGUI::clearSearchInfo() {
+  searchTxt.clear();
+  staticLayerValid = false;
+}
+
+std::string BoardGUI::formatCount(long long count) {
+  char buffer[32];
+  if (count >= 10000000) {
+    snprintf(buffer, sizeof(buffer), "%lldM", count / 1000000);
+  } else if (count >= 10000) {
+    snprintf(buffer, sizeof(buffer), "%lldK", count / 1000);
+  } else {
+    snprintf(buffer, sizeof(buffer), "%lld", count);
+  }
+  return buffer;
+}
+
+void BoardGUI::setSearchInfo(const SearchInfo& info) {
+  char buffer[64];
+  searchTxt.clear();
+  snprintf(buffer, sizeof(buffer), "DEPTH %i", info.depth);
+  searchTxt.push_back(buffer);
+  snprintf(buffer, sizeof(buffer), "SCORE %+.2f", info.score / 100.0);
+  searchTxt.push_back(buffer);
+  searchTxt.push_back("NODES " + formatCount(info.nodes));
+  searchTxt.push_back("NPS   " + formatCount(info.nps));
+  searchTxt.push_back("");
+
+  // the best line in algebraic notation, wrapped to the width of the panel
+  int maxChars = (searchPanelRect.w - 2 * SEARCH_PANEL_MARGIN) / font.getCharWidth();
+  Board board = *b;
+  std::string line;
+  for (int i = 0; i < info.pvLength; i++) {
+    if (info.pv[i] < 0 || info.pv[i] >= board.getNumMoves()) break;
+    std::string san = board.getMoveSAN(info.pv[i]);
+    board.makeMove(info.pv[i]);
+    if (!line.empty() && line.size() + 1 + san.size() > maxChars) {
+      searchTxt.push_back(line);
+      line.clear();
+    }
+    if (!line.empty()) line += ' ';
+    line += san;
+  }
+  if (!line.empty()) searchTxt.push_back(line);
+  staticLayerValid = false;
+}
+
+bool BoardGUI::isAnimating() {
+  return !availableMoves.empty();
+}
+
+void BoardGUI::drawFrame(SDL_Renderer* renderer) {
+  // the render target may have been lost with the window's content
+  if (exposed) staticLayerValid = false;
+  GUI::drawFrame(renderer);
+}
+
+void BoardGUI::drawFrame() {
+  drawFrame(renderer);
 }
 
 void BoardGUI::draw(SDL_Renderer* renderer) {
+  if (updateStaticLayer(renderer)) {
+    SDL_RenderCopy(renderer, staticLayer, NULL, NULL);
+  } else {
+    // no render target (not supported by the renderer): draw the layer directly
+    drawStaticLayer(renderer);
+  }
+
+  // Draw move pointers
+  for (int i = 0; i < availableMoves.size(); i++) {
+    int arrowX = boardSquares[availableMoves[i]].x;
+    int arrowY = boardSquares[availableMoves[i]].y;
+    arrowY -= arrowHeight.getValue(scheduler.getFrameTicks());
+    moveArrow.render(sprites, arrowX, arrowY);
+  }
+  sprites.flush(renderer);
+
+  SDL_RenderPresent(renderer);
+}
+
+bool BoardGUI::updateStaticLayer(SDL_Renderer* renderer) {
+  if (staticLayer == NULL) {
+    if (!SDL_RenderTargetSupported(renderer)) return false;
+    int width, height;
+    if (SDL_GetRendererOutputSize(renderer, &width, &height) != 0) return false;
+    staticLayer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+    if (staticLayer == NULL) {
+      printf("Failed to create the board's render target. SDL error: %s\n", SDL_GetError());
+      return false;
+    }
+    staticLayerValid = false;
+  }
+
+  // the layer only depends on the pieces (including the chosen one), the player to move and the side bar's state
+  bool changed = !staticLayerValid || layerTargetResets != numTargetResets || layerPlayer != b->getPlayer() || layerPromotion != b->hasPromotion();
+  for (int i = 0; i < Board::NUM_SQUARES; i++) {
+    int piece = b->getPieceGUI(i);
+    if (layerPieces[i] != piece) {
+      layerPieces[i] = piece;
+      changed = true;
+    }
+  }
+  if (!changed) return true;
+  layerPlayer = b->getPlayer();
+  layerPromotion = b->hasPromotion();
+  layerTargetResets = numTargetResets;
+
+  SDL_SetRenderTarget(renderer, staticLayer);
+  drawStaticLayer(renderer);
+  SDL_SetRenderTarget(renderer, NULL);
+  staticLayerValid = true;
+  return true;
+}
+
+void BoardGUI::drawStaticLayer(SDL_Renderer* renderer) {
   // Clear screen
   SDL_RenderClear( renderer );
 
   // Draw chessboard
-  boardImg.render(renderer, 0, 0);
+  boardImg.render(sprites, 0, 0);
 
   // Draw click boxes
   //SDL_SetRenderDrawColor( renderer, 0x00, 0x00, 0x00, 0x00 );
@@ -113,13 +233,11 @@ void BoardGUI::draw(SDL_Renderer* renderer) {
     if (piece == Board::EMPTY) continue;
     if (piece < Board::NUM_COLORED_TYPES) {
       // if piece is not chosen, draw as normal
-      piecesSprite.render(renderer, &pieceClips[piece], &boardSquares[i]);
+      piecesSprite.render(sprites, &pieceClips[piece], &boardSquares[i], ALPHA_NORMAL);
     } else {
       // if piece is chosen, draw it half transparent
       piece -= Board::NUM_COLORED_TYPES;
-      piecesSprite.setTransparency(ALPHA_FADED);
-      piecesSprite.render(renderer, &pieceClips[piece], &boardSquares[i]);
-      piecesSprite.setTransparency(ALPHA_NORMAL);
+      piecesSprite.render(sprites, &pieceClips[piece], &boardSquares[i], ALPHA_FADED);
     }
   }
 
@@ -127,41 +245,44 @@ void BoardGUI::draw(SDL_Renderer* renderer) {
   if (b->isKingChecked()) {
     int kingSquare = b->getKingSquare(b->getPlayer());
     SDL_Rect rect = {boardSquares[kingSquare].x - 10, boardSquares[kingSquare].y - 10, 80, 80};
-    crosshair.render(renderer, NULL, &rect);
+    crosshair.render(sprites, NULL, &rect);
   }
 
   // Draw side Bar
-  undoButton.render(renderer, NULL, &undoRect);
-  homeButton.render(renderer, NULL, &homeRect);
+  undoButton.render(sprites, NULL, &undoRect);
+  homeButton.render(sprites, NULL, &homeRect);
   if (humanSide == Board::BOTH_COLOR || humanSide == b->getPlayer()) {
-    playerTxt.render(renderer, NULL, &playerTxtRect);
+    playerTxt.render(sprites, NULL, &playerTxtRect);
   } else {
-    comTxt.render(renderer, NULL, &playerTxtRect);
+    comTxt.render(sprites, NULL, &playerTxtRect);
   }
-  colorSymbols[b->getPlayer()].render(renderer, NULL, &colorSymbolRect);
-
-  // Draw move pointers
-  for (int i = 0; i < availableMoves.size(); i++) {
-    int arrowX = boardSquares[availableMoves[i]].x;
-    int arrowY = boardSquares[availableMoves[i]].y;
-    arrowY -= arrowHeight;
-    moveArrow.render(renderer, arrowX, arrowY);
-  }
-  arrowHeight += arrowSpeed;
-  if (arrowHeight > ARROW_HIGH || arrowHeight < ARROW_LOW) arrowSpeed = -arrowSpeed;
+  colorSymbols[b->getPlayer()].render(sprites, NULL, &colorSymbolRect);
 
   // Draw promotion panel
   if (b->hasPromotion()) {
     // Draw promotion options
-    promoteTxt.render(renderer, NULL, &promoteTxtRect);
+    promoteTxt.render(sprites, NULL, &promoteTxtRect);
     int color = b->getPlayer()? 0 : 6;
-    piecesSprite.render(renderer, &pieceClips[Board::BQ + color], &promotePieceRects[0]);
-    piecesSprite.render(renderer, &pieceClips[Board::BR + color], &promotePieceRects[1]);
-    piecesSprite.render(renderer, &pieceClips[Board::BB + color], &promotePieceRects[2]);
-    piecesSprite.render(renderer, &pieceClips[Board::BN + color], &promotePieceRects[3]);
+    piecesSprite.render(sprites, &pieceClips[Board::BQ + color], &promotePieceRects[0]);
+    piecesSprite.render(sprites, &pieceClips[Board::BR + color], &promotePieceRects[1]);
+    piecesSprite.render(sprites, &pieceClips[Board::BB + color], &promotePieceRects[2]);
+    piecesSprite.render(sprites, &pieceClips[Board::BN + color], &promotePieceRects[3]);
   }
+  // all images in one or a few draw calls (one per atlas), before the search panel is drawn over them
+  sprites.flush(renderer);
 
-  SDL_RenderPresent(renderer);
+  if (!b->hasPromotion() && !searchTxt.empty()) {
+    // Draw the AI's search report
+    SDL_SetRenderDrawColor(renderer, 0x20, 0x20, 0x20, 0xFF);
+    SDL_RenderFillRect(renderer, &searchPanelRect);
+    SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF);
+    int x = searchPanelRect.x + SEARCH_PANEL_MARGIN;
+    int y = searchPanelRect.y + SEARCH_PANEL_MARGIN;
+    for (int i = 0; i < searchTxt.size() && y + font.getLineHeight() <= searchPanelRect.y + searchPanelRect.h; i++) {
+      font.drawText(renderer, x, y, searchTxt[i]);
+      y += font.getLineHeight();
+    }
+  }
 }
 
 void BoardGUI::playMoveSFX() {
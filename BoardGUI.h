@@ -8,10 +8,17 @@
 #define BOARDGUI_H
 
 #include <SDL2/SDL_mixer.h>
+#include <string>
+#include <vector>
 
+#include "BitmapFont.h"
 #include "Board.h"
 #include "GUI.h"
+#include "ResourceManager.h"
+#include "SearchListener.h"
+#include "SpriteBatch.h"
 #include "TextureWrapper.h"
+#include "Tween.h"
 
 
 class BoardGUI : public GUI {
@@ -36,11 +43,12 @@ class BoardGUI : public GUI {
      ***************************************************************************/
 
     /**
-     * Load all the images needed for displaying to SDL_Texture
+     * Load all the images needed for displaying
      * @param brd: the pointer to the board that this GUI will be drawing.
      * @param renderer: an SDL_Renderer
+     * @param resources: loads the images and sounds (usable after resources.build()).
      */
-    BoardGUI(Board* brd, SDL_Renderer* renderer);
+    BoardGUI(Board* brd, SDL_Renderer* renderer, ResourceManager& resources);
 
     ~BoardGUI();
 
@@ -50,6 +58,21 @@ class BoardGUI : public GUI {
      */
     void draw(SDL_Renderer* renderer);
 
+    /**
+     * The move pointers are the only animation.
+     */
+    bool isAnimating();
+
+    /**
+     * Draw the chessboard if a frame is due (see GUI::drawFrame).
+     */
+    void drawFrame(SDL_Renderer* renderer);
+
+    /**
+     * Draw the chessboard with the renderer given to the constructor, if a frame is due.
+     */
+    void drawFrame();
+
     void playMusic();
     void stopMusic();
     void playMoveSFX();
@@ -66,10 +89,23 @@ class BoardGUI : public GUI {
      */
     void updateMovePointers();
 
+    /**
+     * Show a report of the AI's search on the side bar (depth, score, nodes, nodes per second and best line).
+     * Must be called while the board is at the searched position.
+     * @param info: the report, its moves are in the board's current move list.
+     */
+    void setSearchInfo(const SearchInfo& info);
+
+    /**
+     * Remove the search report from the side bar.
+     */
+    void clearSearchInfo();
+
     void destroyMedia();
 
   private:
     Board* b; /**< Contains the board's state and logic */
+    SDL_Renderer* renderer; /**< The renderer given to the constructor, used by drawFrame */
 
     /****************************************************************************
      *                           Images used in drawing
@@ -82,6 +118,7 @@ class BoardGUI : public GUI {
     TextureWrapper moveArrow;
     TextureWrapper colorSymbols[2];
     TextureWrapper crosshair;
+    SpriteBatch sprites; /**< Collects the images of a frame, to draw them in a few calls */
 
     const Uint8 ALPHA_FADED = 100; /**< The alpha value to draw faded chess pieces */
     const Uint8 ALPHA_NORMAL = 255; /**<The alpha value to draw normal chess pieces */
@@ -98,14 +135,53 @@ class BoardGUI : public GUI {
 
     int humanSide; /**< The side that is human player (WHITE, BLACK, or BOTH_COLOR) */
 
+    /****************************************************************************
+     *                            AI search panel
+     ****************************************************************************/
+    BitmapFont font;
+    SDL_Rect searchPanelRect; /**< Drawn in place of the promotion panel */
+    std::vector<std::string> searchTxt; /**< The lines of the panel, empty when there is nothing to show */
+    const int SEARCH_PANEL_MARGIN = 8;
+
+    /**
+     * @return a count with at most 4 digits and a K or M suffix.
+     */
+    static std::string formatCount(long long count);
+
     /****************************************************************************
      *                          Move pointer animation
      ****************************************************************************/
     std::vector<int> availableMoves;
     const int ARROW_HIGH = 20;
     const int ARROW_LOW = 10;
-    float arrowSpeed = 0.015;
-    float arrowHeight = ARROW_LOW;
+    const Uint32 ARROW_BOUNCE_MS = 500; /**< Time for the arrows to go from low to high */
+    Tween arrowHeight; /**< Bounces between ARROW_LOW and ARROW_HIGH while a piece is chosen */
+
+    /****************************************************************************
+     *                       Cached board and side bar
+     ****************************************************************************/
+
+    /**
+     * Everything but the move pointers, drawn into a render target.
+     * Frames where only the pointers move copy this texture instead of drawing each image again.
+     */
+    SDL_Texture* staticLayer;
+    bool staticLayerValid; /**< False when the layer must be drawn again (side bar changed, window exposed) */
+    int layerPieces[Board::NUM_SQUARES]; /**< getPieceGUI of each square when the layer was drawn */
+    int layerPlayer; /**< The player to move when the layer was drawn */
+    bool layerPromotion; /**< Whether the promotion panel was drawn */
+    int layerTargetResets; /**< numTargetResets when the layer was drawn: it is lost after a reset */
+
+    /**
+     * Draw the static layer into its render target if the board or side bar changed.
+     * @return false if render targets are not available, then the layer must be drawn directly.
+     */
+    bool updateStaticLayer(SDL_Renderer* renderer);
+
+    /**
+     * Draw the board, pieces and side bar (everything but the move pointers) on the current target.
+     */
+    void drawStaticLayer(SDL_Renderer* renderer);
 
     /****************************************************************************
      *                             Audio
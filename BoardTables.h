@@ -0,0 +1,154 @@
+/***********************************************************************//**
+ * Geometry and attack tables of the chessboard, generated at compile time.
+ * Squares are numbered 0 -> 63 (row * 8 + column), row 0 is white's first row.
+ * Masks have one bit per square (bit n is square n).
+ * Only included by Board.cpp.
+ ***************************************************************************/
+
+#ifndef BOARDTABLES_H
+#define BOARDTABLES_H
+
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace BoardTables {
+
+/**
+ * 8 basic directions, as row and column steps, and as square offsets.
+ * The first 4 are cardinal (vertical and horizontal). The last 4 are diagonal.
+ */
+constexpr int DIR_ROW[8] = {0, 0, 1, -1, 1, 1, -1, -1};
+constexpr int DIR_COL[8] = {1, -1, 0, 0, 1, -1, 1, -1};
+constexpr int DIR_OFFSET[8] = {1, -1, 8, -8, 9, 7, -7, -9};
+constexpr int MAX_CARDINAL_DIR = 3; /**< The greatest value of a cardinal direction */
+constexpr int MIN_DIAGONAL_DIR = 4; /**< The smallest value of a diagonal direction */
+
+/**
+ * 8 knight's directions (L shaped moves)
+ */
+constexpr int KNIGHT_ROW[8] = {1, 1, -1, -1, 2, 2, -2, -2};
+constexpr int KNIGHT_COL[8] = {2, -2, 2, -2, 1, -1, 1, -1};
+
+struct Tables {
+  uint64_t knightAttacks[64]; /**< Squares a knight attacks from each square */
+  uint64_t kingAttacks[64]; /**< Squares a king attacks from each square */
+  uint64_t pawnAttacks[2][64]; /**< Squares a pawn of each color (white, black) attacks from each square */
+  uint64_t between[64][64]; /**< Squares strictly between 2 squares on a row, column or diagonal, else 0 */
+  uint64_t line[64][64]; /**< The whole row, column or diagonal through 2 squares (both included), else 0 */
+  int squaresToEdge[64][8]; /**< Number of squares from each square to the edge in each direction */
+};
+
+constexpr bool isOnBoard(int r, int c) {
+  return r >= 0 && r < 8 && c >= 0 && c < 8;
+}
+
+constexpr uint64_t squareBit(int r, int c) {
+  return isOnBoard(r, c)? 1ULL << (r * 8 + c) : 0;
+}
+
+constexpr Tables generateTables() {
+  Tables t{};
+  for (int s = 0; s < 64; s++) {
+    int r = s / 8;
+    int c = s % 8;
+    for (int d = 0; d < 8; d++) {
+      t.knightAttacks[s] |= squareBit(r + KNIGHT_ROW[d], c + KNIGHT_COL[d]);
+      t.kingAttacks[s] |= squareBit(r + DIR_ROW[d], c + DIR_COL[d]);
+
+      int length = 0;
+      while (isOnBoard(r + DIR_ROW[d] * (length + 1), c + DIR_COL[d] * (length + 1))) length++;
+      t.squaresToEdge[s][d] = length;
+    }
+    t.pawnAttacks[0][s] = squareBit(r + 1, c - 1) | squareBit(r + 1, c + 1);
+    t.pawnAttacks[1][s] = squareBit(r - 1, c - 1) | squareBit(r - 1, c + 1);
+
+    for (int d = 0; d < 8; d++) {
+      // the whole line of this direction: both rays and the square itself
+      int opposite = 0;
+      while (DIR_ROW[opposite] != -DIR_ROW[d] || DIR_COL[opposite] != -DIR_COL[d]) opposite++;
+      uint64_t fullLine = 1ULL << s;
+      for (int k = 1; k <= t.squaresToEdge[s][d]; k++) fullLine |= 1ULL << (s + DIR_OFFSET[d] * k);
+      for (int k = 1; k <= t.squaresToEdge[s][opposite]; k++) fullLine |= 1ULL << (s + DIR_OFFSET[opposite] * k);
+
+      uint64_t passed = 0;
+      for (int k = 1; k <= t.squaresToEdge[s][d]; k++) {
+        int target = s + DIR_OFFSET[d] * k;
+        t.between[s][target] = passed;
+        t.line[s][target] = fullLine;
+        passed |= 1ULL << target;
+      }
+    }
+  }
+  return t;
+}
+
+constexpr Tables TABLES = generateTables();
+
+/**
+ * Remove the lowest set bit of a mask.
+ * @return the square of that bit. The mask must not be 0.
+ */
+inline int popLowestSquare(uint64_t& mask) {
+#if defined(_MSC_VER)
+  unsigned long square;
+  _BitScanForward64(&square, mask);
+#else
+  int square = __builtin_ctzll(mask);
+#endif
+  mask &= mask - 1;
+  return (int) square;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                            Sanity checks
+////////////////////////////////////////////////////////////////////////////
+
+constexpr int countSquares(uint64_t mask) {
+  int n = 0;
+  for (; mask; mask &= mask - 1) n++;
+  return n;
+}
+
+constexpr bool isSymmetric() {
+  for (int a = 0; a < 64; a++) {
+    for (int b = 0; b < 64; b++) {
+      if (TABLES.between[a][b] != TABLES.between[b][a] || TABLES.line[a][b] != TABLES.line[b][a]) return false;
+      if (((TABLES.knightAttacks[a] >> b) & 1) != ((TABLES.knightAttacks[b] >> a) & 1)) return false;
+      if (((TABLES.kingAttacks[a] >> b) & 1) != ((TABLES.kingAttacks[b] >> a) & 1)) return false;
+    }
+  }
+  return true;
+}
+
+constexpr int totalKnightMoves() {
+  int n = 0;
+  for (int s = 0; s < 64; s++) n += countSquares(TABLES.knightAttacks[s]);
+  return n;
+}
+
+static_assert(TABLES.knightAttacks[0] == (squareBit(1, 2) | squareBit(2, 1)), "knight on a1 attacks b3 and c2");
+static_assert(countSquares(TABLES.knightAttacks[27]) == 8, "knight on d4 attacks 8 squares");
+static_assert(totalKnightMoves() == 336, "a knight has 336 moves over all squares");
+static_assert(countSquares(TABLES.kingAttacks[0]) == 3 && countSquares(TABLES.kingAttacks[28]) == 8,
+              "king attacks 3 squares from a corner, 8 from the center");
+static_assert(TABLES.pawnAttacks[0][12] == (squareBit(2, 3) | squareBit(2, 5)), "white pawn on e2 attacks d3 and f3");
+static_assert(TABLES.pawnAttacks[1][52] == (squareBit(5, 3) | squareBit(5, 5)), "black pawn on e7 attacks d6 and f6");
+static_assert(TABLES.pawnAttacks[0][8] == squareBit(2, 1) && TABLES.pawnAttacks[0][63] == 0,
+              "pawn attacks stay on the board");
+static_assert(countSquares(TABLES.between[0][63]) == 6 && TABLES.between[0][9] == 0,
+              "6 squares between a1 and h8, none between neighbours");
+static_assert(TABLES.between[0][17] == 0 && TABLES.line[0][17] == 0, "a1 and b3 are not on a line");
+static_assert(TABLES.between[4][60] == (TABLES.line[4][60] & ~squareBit(0, 4) & ~squareBit(7, 4)),
+              "between e1 and e8 is the e file without its ends");
+static_assert(TABLES.line[0][18] == TABLES.line[63][9] && countSquares(TABLES.line[0][18]) == 8,
+              "a1, c3, b2 and h8 are on the same diagonal");
+static_assert(TABLES.squaresToEdge[0][0] == 7 && TABLES.squaresToEdge[0][1] == 0 && TABLES.squaresToEdge[27][7] == 3,
+              "squares to the edge");
+static_assert(isSymmetric(), "between, line, knight and king tables are symmetric");
+
+} // namespace BoardTables
+
+#endif // BOARDTABLES_H
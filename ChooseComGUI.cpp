@@ -1,10 +1,10 @@
 #include "ChooseComGUI.h"
 
-ChooseComGUI::ChooseComGUI(SDL_Renderer* renderer){
-  leftSide.loadFromFile(renderer,"img/choosePlayerGUI/whiteCOM.png");
-  rightSide.loadFromFile(renderer,"img/choosePlayerGUI/blackCOM.png");
-  bothSide.loadFromFile(renderer,"img/choosePlayerGUI/both.png");
-  background.loadFromFile(renderer,"img/choosePlayerGUI/background.jpg");
+ChooseComGUI::ChooseComGUI(ResourceManager& resources){
+  resources.load(&leftSide, "img/choosePlayerGUI/whiteCOM.png");
+  resources.load(&rightSide, "img/choosePlayerGUI/blackCOM.png");
+  resources.load(&bothSide, "img/choosePlayerGUI/both.png");
+  resources.load(&background, "img/choosePlayerGUI/background.jpg");
 
   boxes.push_back( Box(102, 354, 282, 409, INPUT_WHITE_EASY) );
   boxes.push_back( Box(102, 422, 282, 480, INPUT_WHITE_MEDIUM) );
@@ -12,45 +12,48 @@ ChooseComGUI::ChooseComGUI(SDL_Renderer* renderer){
   boxes.push_back( Box(506, 110, 686, 168, INPUT_BLACK_EASY) );
   boxes.push_back( Box(506, 179, 686, 237, INPUT_BLACK_MEDIUM) );
   boxes.push_back( Box(506, 247, 686, 305, INPUT_BLACK_HARD) );
+
+  ending = false;
 }
 
 void ChooseComGUI::draw(SDL_Renderer* renderer) {
+  Uint32 now = scheduler.getFrameTicks();
   SDL_RenderClear(renderer);
-  bothSide.render(renderer);
-  SDL_RenderPresent(renderer);
-}
-
-void ChooseComGUI::openingAnimation(SDL_Renderer* renderer)
-{
-  leftSideRect = {-500, 0, 800, 600};
-  rightSideRect = {500, 0, 800, 600};
-  while(true){
-    SDL_RenderClear(renderer);
+  if (!ending && !slide.isRunning(now)) {
+    bothSide.render(renderer);
+  } else {
+    int distance = slide.getValue(now);
+    SDL_Rect leftSideRect = {-distance, 0, 800, 600};
+    SDL_Rect rightSideRect = {distance, 0, 800, 600};
     background.render(renderer);
     leftSide.render(renderer, NULL, &leftSideRect);
     rightSide.render(renderer, NULL, &rightSideRect);
-    SDL_RenderPresent(renderer);
-    leftSideRect.x += MOVING_SPEED;
-    rightSideRect.x -= MOVING_SPEED;
-    if (leftSideRect.x > 0) {
-      break;
-    }
   }
+  SDL_RenderPresent(renderer);
 }
 
-void ChooseComGUI::endingAnimation(SDL_Renderer* renderer){
-  leftSideRect = {0, 0, 800, 600};
-  rightSideRect = {0, 0, 800, 600};
-  while(true){
-    SDL_RenderClear(renderer);
-    background.render(renderer);
-    leftSide.render(renderer, NULL, &leftSideRect);
-    rightSide.render(renderer, NULL, &rightSideRect);
-    SDL_RenderPresent(renderer);
-    leftSideRect.x -= MOVING_SPEED;
-    rightSideRect.x += MOVING_SPEED;
-    if (leftSideRect.x < -500) {
-      break;
-    }
-  }
+void ChooseComGUI::startOpeningAnimation()
+{
+  ending = false;
+  slide.start(SLIDE_DISTANCE, 0, SLIDE_MS, SDL_GetTicks());
+  scheduler.requestFrame();
+}
+
+void ChooseComGUI::startEndingAnimation()
+{
+  ending = true;
+  slide.start(0, SLIDE_DISTANCE, SLIDE_MS, SDL_GetTicks(), Tween::LINEAR);
+  scheduler.requestFrame();
+}
+
+bool ChooseComGUI::isAnimating()
+{
+  return slide.isRunning(SDL_GetTicks());
+}
+
+bool ChooseComGUI::skipAnimation()
+{
+  if (!isAnimating()) return false;
+  slide.finish();
+  return true;
 }
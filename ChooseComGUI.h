@@ -1,7 +1,9 @@
 #ifndef CHOOSECOMGUI_H
 #define CHOOSECOMGUI_H
 #include "GUI.h"
+#include "ResourceManager.h"
 #include "TextureWrapper.h"
+#include "Tween.h"
 
 class ChooseComGUI: public GUI
 {
@@ -18,22 +20,41 @@ class ChooseComGUI: public GUI
 
 
 
-    ChooseComGUI(SDL_Renderer* renderer);
+    /**
+     * @param resources: loads the images (drawable after resources.build()).
+     */
+    ChooseComGUI(ResourceManager& resources);
 
 
+    /**
+     * Draw the choices, or the two halves of the screen sliding during an animation.
+     */
     void draw(SDL_Renderer* renderer);
 
-    void openingAnimation(SDL_Renderer* renderer);
+    /**
+     * Start sliding the two halves in from the sides. Frames are drawn by drawFrame.
+     */
+    void startOpeningAnimation();
 
-    void endingAnimation(SDL_Renderer* renderer);
+    /**
+     * Start sliding the two halves out. Frames are drawn by drawFrame.
+     */
+    void startEndingAnimation();
+
+    bool isAnimating();
 
 
   private:
     TextureWrapper leftSide, rightSide, bothSide;
     TextureWrapper background;
 
-    SDL_Rect leftSideRect, rightSideRect;
-    const float MOVING_SPEED = 4;
+    static const int SLIDE_MS = 500; /**< The duration of the animations */
+    static const int SLIDE_DISTANCE = 500; /**< How far from its place each half starts or ends */
+
+    Tween slide; /**< Distance of the halves from their place */
+    bool ending; /**< True once the ending animation started: the halves stay outside */
+
+    bool skipAnimation();
 
 
 
@@ -0,0 +1,301 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+#include "EPDRunner.h"
+
+EPDRunner::EPDRunner(int numThreads) {
+  this->numThreads = (numThreads > 0)? numThreads : std::thread::hardware_concurrency();
+  if (this->numThreads < 1) this->numThreads = 1;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                            Loading suites
+////////////////////////////////////////////////////////////////////////////
+
+bool EPDRunner::loadSuite(std::string path) {
+  FILE* file = fopen(path.c_str(), "r");
+  if (file == NULL) {
+    printf("Unable to open EPD file %s\n", path.c_str());
+    return false;
+  }
+  Board b;
+  char buffer[1024];
+  int lineNumber = 0;
+  while (fgets(buffer, sizeof(buffer), file) != NULL) {
+    lineNumber++;
+    Entry entry;
+    std::map<std::string, std::vector<std::string> > operations;
+    if (!parseLine(buffer, entry.fen, operations)) continue;
+    if (!b.loadFEN(entry.fen)) {
+      printf("Line %i: invalid position\n", lineNumber);
+      continue;
+    }
+    entry.bestMoves = operations["bm"];
+    entry.avoidMoves = operations["am"];
+    if (!operations["id"].empty()) entry.id = operations["id"][0];
+    if (entry.bestMoves.empty() && entry.avoidMoves.empty()) {
+      printf("Line %i: no bm or am operation\n", lineNumber);
+      continue;
+    }
+    if (entry.id.empty()) {
+      char id[32];
+      sprintf(id, "line%i", lineNumber);
+      entry.id = id;
+    }
+    entry.solved = false;
+    entries.push_back(entry);
+  }
+  fclose(file);
+  printf("Loaded %i positions from %s\n", (int) entries.size(), path.c_str());
+  return !entries.empty();
+}
+
+bool EPDRunner::parseLine(std::string line, std::string& fen, std::map<std::string, std::vector<std::string> >& operations) {
+  // the 4 first fields are the position
+  fen.clear();
+  int pos = 0;
+  for (int field = 0; field < 4; field++) {
+    while (pos < line.size() && isspace(line[pos])) pos++;
+    int start = pos;
+    while (pos < line.size() && !isspace(line[pos])) pos++;
+    if (start == pos) return false;
+    if (field > 0) fen += ' ';
+    fen += line.substr(start, pos - start);
+  }
+  fen += " 0 1";
+
+  // operations are separated by ';' (outside quotes)
+  operations.clear();
+  std::string operation;
+  bool quoted = false;
+  for (int k = pos; k <= line.size(); k++) {
+    if (k < line.size() && line[k] == '"') quoted = !quoted;
+    if (k < line.size() && (quoted || line[k] != ';')) {
+      operation += line[k];
+      continue;
+    }
+    std::vector<std::string> operands = splitOperands(operation);
+    operation.clear();
+    if (operands.empty()) continue;
+    std::string opcode = operands[0];
+    operands.erase(operands.begin());
+    operations[opcode] = operands;
+  }
+  return true;
+}
+
+std::vector<std::string> EPDRunner::splitOperands(std::string text) {
+  std::vector<std::string> operands;
+  std::string current;
+  bool quoted = false;
+  for (int k = 0; k <= text.size(); k++) {
+    if (k < text.size() && text[k] == '"') {
+      quoted = !quoted;
+    } else if (k < text.size() && (quoted || !isspace(text[k]))) {
+      current += text[k];
+    } else if (!current.empty()) {
+      operands.push_back(current);
+      current.clear();
+    }
+  }
+  return operands;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                               Searching
+////////////////////////////////////////////////////////////////////////////
+
+EPDRunner::SolutionTracker::SolutionTracker(Board* brd, Entry* e, const std::vector<int>& best,
+                                            const std::vector<int>& avoid) {
+  b = brd;
+  entry = e;
+  bestMoves = best;
+  avoidMoves = avoid;
+}
+
+void EPDRunner::SolutionTracker::onSearchInfo(const SearchInfo& info) {
+  bool correct = bestMoves.empty();
+  for (int i = 0; i < bestMoves.size(); i++) {
+    if (bestMoves[i] == info.bestMove) correct = true;
+  }
+  for (int i = 0; i < avoidMoves.size(); i++) {
+    if (avoidMoves[i] == info.bestMove) correct = false;
+  }
+
+  if (!correct) {
+    entry->solved = false;
+    entry->solveTimeMs = -1;
+    entry->solveNodes = -1;
+    entry->solveDepth = -1;
+  } else if (!entry->solved) {
+    // the move has been correct from this depth on (so far)
+    entry->solved = true;
+    entry->solveTimeMs = info.timeMs;
+    entry->solveNodes = info.nodes;
+    entry->solveDepth = info.depth;
+  }
+  entry->playedMove = b->getMoveSAN(info.bestMove);
+}
+
+void EPDRunner::run(int maxDepth, long long maxNodes, int maxTimeMs) {
+  std::atomic<int> nextEntry(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < numThreads; t++) {
+    threads.push_back(std::thread(&EPDRunner::searchEntries, this, &nextEntry, maxDepth, maxNodes, maxTimeMs));
+  }
+  for (int t = 0; t < numThreads; t++) {
+    threads[t].join();
+  }
+}
+
+void EPDRunner::searchEntries(std::atomic<int>* nextEntry, int maxDepth, long long maxNodes, int maxTimeMs) {
+  Board b;
+  AIPlayer ai(&b, NULL, maxDepth);
+  TranspositionTable table;
+  ai.setTranspositionTable(&table);
+  ai.setLimits(maxDepth, maxNodes, maxTimeMs);
+  while (true) {
+    int i = (*nextEntry)++;
+    if (i >= (int) entries.size()) break;
+    searchEntry(entries[i], b, ai, table);
+  }
+}
+
+void EPDRunner::searchEntry(Entry& entry, Board& b, AIPlayer& ai, TranspositionTable& table) {
+  entry.solved = false;
+  entry.solveTimeMs = -1;
+  entry.solveNodes = -1;
+  entry.solveDepth = -1;
+  entry.playedMove = "";
+  entry.totalTimeMs = 0;
+  entry.totalNodes = 0;
+
+  b.loadFEN(entry.fen);
+  std::vector<int> best, avoid;
+  for (int i = 0; i < entry.bestMoves.size(); i++) {
+    int move = b.findMoveSAN(entry.bestMoves[i]);
+    if (move == -1) printf("%s: best move %s is not legal\n", entry.id.c_str(), entry.bestMoves[i].c_str());
+    else best.push_back(move);
+  }
+  for (int i = 0; i < entry.avoidMoves.size(); i++) {
+    int move = b.findMoveSAN(entry.avoidMoves[i]);
+    if (move == -1) printf("%s: avoid move %s is not legal\n", entry.id.c_str(), entry.avoidMoves[i].c_str());
+    else avoid.push_back(move);
+  }
+  if (best.empty() && avoid.empty()) return;
+  // none of the best moves are legal: the position cannot be solved
+  if (best.empty() && !entry.bestMoves.empty()) return;
+
+  SolutionTracker tracker(&b, &entry, best, avoid);
+  ai.setSearchListener(&tracker);
+  table.clear();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  ai.decideMove();
+  entry.totalTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  entry.totalNodes = ai.getNumNodes();
+  ai.setSearchListener(NULL);
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                                Results
+////////////////////////////////////////////////////////////////////////////
+
+void EPDRunner::printReport() {
+  int numSolved = 0;
+  long long sumTime = 0, sumNodes = 0;
+  printf("%-16s %-8s %-8s %10s %12s %6s\n", "id", "result", "move", "time(ms)", "nodes", "depth");
+  for (int i = 0; i < entries.size(); i++) {
+    Entry& e = entries[i];
+    printf("%-16s %-8s %-8s %10i %12lld %6i\n", e.id.c_str(), e.solved? "solved" : "FAILED",
+           e.playedMove.c_str(), e.solveTimeMs, e.solveNodes, e.solveDepth);
+    if (e.solved) {
+      numSolved++;
+      sumTime += e.solveTimeMs;
+      sumNodes += e.solveNodes;
+    }
+  }
+  printf("Solved %i / %i", numSolved, (int) entries.size());
+  if (numSolved > 0) {
+    printf(", average time to solution %lld ms, average nodes to solution %lld", sumTime / numSolved, sumNodes / numSolved);
+  }
+  printf("\n");
+}
+
+bool EPDRunner::saveResults(std::string path) {
+  FILE* file = fopen(path.c_str(), "w");
+  if (file == NULL) {
+    printf("Unable to write results to %s\n", path.c_str());
+    return false;
+  }
+  for (int i = 0; i < entries.size(); i++) {
+    Entry& e = entries[i];
+    fprintf(file, "%s\t%i\t%i\t%lld\t%i\t%s\n", e.id.c_str(), e.solved? 1 : 0,
+            e.solveTimeMs, e.solveNodes, e.solveDepth, e.playedMove.empty()? "-" : e.playedMove.c_str());
+  }
+  fclose(file);
+  return true;
+}
+
+bool EPDRunner::compareWithBaseline(std::string path) {
+  FILE* file = fopen(path.c_str(), "r");
+  if (file == NULL) {
+    printf("Unable to open baseline %s\n", path.c_str());
+    return false;
+  }
+  std::map<std::string, Entry> baseline;
+  char line[512], id[256], move[64];
+  int solved;
+  int lineNumber = 0, numInvalid = 0;
+  Entry e;
+  while (fgets(line, sizeof(line), file) != NULL) {
+    lineNumber++;
+    line[strcspn(line, "\r\n")] = '\0';
+    if (line[0] == '\0') continue;
+    // the move is "-" when none was played (older files leave it empty)
+    move[0] = '\0';
+    if (sscanf(line, "%255[^\t]\t%i\t%i\t%lld\t%i\t%63[^\t]", id, &solved,
+               &e.solveTimeMs, &e.solveNodes, &e.solveDepth, move) < 5) {
+      printf("Baseline line %i: invalid, ignored\n", lineNumber);
+      numInvalid++;
+      continue;
+    }
+    e.id = id;
+    e.solved = solved;
+    e.playedMove = (strcmp(move, "-") == 0)? "" : move;
+    baseline[e.id] = e;
+  }
+  fclose(file);
+  if (numInvalid > 0) printf("%i invalid lines in baseline %s\n", numInvalid, path.c_str());
+
+  int numBaselineSolved = 0, numSolved = 0, numBoth = 0;
+  long long baselineTime = 0, time = 0, baselineNodes = 0, nodes = 0;
+  for (int i = 0; i < entries.size(); i++) {
+    Entry& current = entries[i];
+    if (current.solved) numSolved++;
+    std::map<std::string, Entry>::iterator it = baseline.find(current.id);
+    if (it == baseline.end()) continue;
+    Entry& old = it->second;
+    if (old.solved) numBaselineSolved++;
+    if (old.solved && !current.solved) {
+      printf("%-16s lost (baseline %s in %i ms, now plays %s)\n", current.id.c_str(),
+             old.playedMove.c_str(), old.solveTimeMs, current.playedMove.c_str());
+    } else if (!old.solved && current.solved) {
+      printf("%-16s gained (%s in %i ms, baseline played %s)\n", current.id.c_str(),
+             current.playedMove.c_str(), current.solveTimeMs, old.playedMove.c_str());
+    } else if (old.solved && current.solved) {
+      numBoth++;
+      baselineTime += old.solveTimeMs;
+      time += current.solveTimeMs;
+      baselineNodes += old.solveNodes;
+      nodes += current.solveNodes;
+    }
+  }
+  printf("Solved %i (baseline %i)\n", numSolved, numBaselineSolved);
+  if (numBoth > 0) {
+    printf("On the %i positions solved by both: time %lld ms (baseline %lld ms), nodes %lld (baseline %lld)\n",
+           numBoth, time, baselineTime, nodes, baselineNodes);
+  }
+  return true;
+}
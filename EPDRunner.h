@@ -0,0 +1,131 @@
+/***********************************************************************//**
+ * Runs AIPlayer on EPD test suites (e.g. WAC) and measures how fast it
+ * finds the solutions.
+ * Each position has best moves ("bm") and/or moves to avoid ("am").
+ * A position counts as solved when the search's move after its last completed depth
+ * is a best move (and not a move to avoid). Its time and nodes to solution are
+ * taken from the first depth from which the move stayed correct until the end.
+ * Positions are searched in parallel, each thread with its own Board, AIPlayer and transposition table.
+ * The table is cleared before each position, so that with depth and node limits the results
+ * don't depend on the number of threads or on the order of the positions.
+ * Results can be saved, and compared with a saved baseline run.
+ ***************************************************************************/
+
+#ifndef EPDRUNNER_H
+#define EPDRUNNER_H
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "AIPlayer.h"
+#include "Board.h"
+#include "SearchListener.h"
+#include "TranspositionTable.h"
+
+class EPDRunner {
+  public:
+    /**
+     * @param numThreads: the number of positions searched at the same time. 0 to use all cores.
+     * Times are only comparable between runs with the same number of threads (on the same machine).
+     */
+    EPDRunner(int numThreads = 1);
+    ~EPDRunner() {}
+
+    /**
+     * Load a test suite. Each line has the 4 first FEN fields followed by operations,
+     * e.g. 2rr3k/pp3pp1/1nnqbN1p/3pN3/2pP4/2P3Q1/PPB4P/R4RK1 w - - bm Qg6; id "WAC.001";
+     * Lines without a valid position, or without "bm" and "am" moves, are skipped.
+     * @param path: path to the EPD file.
+     * @return true if at least one position was loaded.
+     */
+    bool loadSuite(std::string path);
+
+    /**
+     * Search all positions.
+     * @param maxDepth: the maximum depth of each search.
+     * @param maxNodes: the node limit of each search, 0 for no limit.
+     * @param maxTimeMs: the time limit of each search in milliseconds, 0 for no limit.
+     */
+    void run(int maxDepth, long long maxNodes, int maxTimeMs);
+
+    /**
+     * Print the result of every position and the number of solved positions.
+     */
+    void printReport();
+
+    /**
+     * Save the results, one tab separated line per position:
+     * id, solved (0 or 1), time to solution (ms), nodes to solution, depth of solution, move played.
+     * Unsolved positions have -1 as time, nodes and depth, and the move is - when none was played.
+     * @return true if saved successfully.
+     */
+    bool saveResults(std::string path);
+
+    /**
+     * Compare the results with a file written by saveResults, and print the positions
+     * that became solved or unsolved, and the totals over positions solved by both runs.
+     * @return true if the baseline was read successfully.
+     */
+    bool compareWithBaseline(std::string path);
+
+    /**
+     * Split an EPD line into its position and its operations.
+     * @param fen: receives the 4 first FEN fields, followed by " 0 1".
+     * @param operations: receives the operands of each operation (quotes are removed), by opcode.
+     * @return false if the line has no position (the position itself is not checked).
+     */
+    static bool parseLine(std::string line, std::string& fen, std::map<std::string, std::vector<std::string> >& operations);
+
+  private:
+    struct Entry {
+      std::string id;
+      std::string fen;
+      std::vector<std::string> bestMoves; /**< SAN of the "bm" moves */
+      std::vector<std::string> avoidMoves; /**< SAN of the "am" moves */
+
+      bool solved;
+      int solveTimeMs; /**< -1 if not solved */
+      long long solveNodes; /**< -1 if not solved */
+      int solveDepth; /**< -1 if not solved */
+      std::string playedMove; /**< The move after the last completed depth, in SAN */
+      int totalTimeMs;
+      long long totalNodes;
+    };
+
+    /**
+     * Follows the search of one position, and records from which depth its move is correct.
+     */
+    class SolutionTracker : public SearchListener {
+      public:
+        SolutionTracker(Board* brd, Entry* e, const std::vector<int>& best, const std::vector<int>& avoid);
+        void onSearchInfo(const SearchInfo& info);
+
+      private:
+        Board* b;
+        Entry* entry;
+        std::vector<int> bestMoves; /**< move numbers of the best moves */
+        std::vector<int> avoidMoves; /**< move numbers of the moves to avoid */
+    };
+
+    std::vector<Entry> entries;
+    int numThreads;
+
+    /**
+     * Search entries taken from a shared counter until none is left.
+     */
+    void searchEntries(std::atomic<int>* nextEntry, int maxDepth, long long maxNodes, int maxTimeMs);
+
+    /**
+     * Search one entry with the given board and AI, after clearing the AI's table.
+     */
+    void searchEntry(Entry& entry, Board& b, AIPlayer& ai, TranspositionTable& table);
+
+    /**
+     * Split the text of an EPD operation into its operands (quotes are removed).
+     */
+    static std::vector<std::string> splitOperands(std::string text);
+};
+
+#endif // EPDRUNNER_H
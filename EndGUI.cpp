@@ -1,5 +1,3 @@
-#include <stdio.h>
-
 #include "EndGUI.h"
 
 const int EndGUI::textX = 196;
@@ -7,28 +5,22 @@ const int EndGUI::textY = 105;
 const int EndGUI::buttonX = 252;
 const int EndGUI::buttonY = 450;
 
-EndGUI::EndGUI(SDL_Renderer* renderer)
+EndGUI::EndGUI(ResourceManager& resources)
 {
-  youWinTxt.loadFromFile(renderer, "img/endGUI/youwintxt.png");
-  youLoseTxt.loadFromFile(renderer, "img/endGUI/youlosetxt.png");
-  whiteWinTxt.loadFromFile(renderer, "img/endGUI/whitewintxt.png");
-  blackWinTxt.loadFromFile(renderer, "img/endGUI/blackwintxt.png");
-  drawTxt.loadFromFile(renderer, "img/endGUI/drawtxt.png");
-  menuButton.loadFromFile(renderer, "img/endGUI/backtomenu.png");
-  backgroundWin.loadFromFile(renderer, "img/endGUI/backgroundwin.jpg");
-  backgroundLose.loadFromFile(renderer, "img/endGUI/backgroundlose.jpg");
+  resources.load(&youWinTxt, "img/endGUI/youwintxt.png");
+  resources.load(&youLoseTxt, "img/endGUI/youlosetxt.png");
+  resources.load(&whiteWinTxt, "img/endGUI/whitewintxt.png");
+  resources.load(&blackWinTxt, "img/endGUI/blackwintxt.png");
+  resources.load(&drawTxt, "img/endGUI/drawtxt.png");
+  resources.load(&menuButton, "img/endGUI/backtomenu.png");
+  resources.load(&backgroundWin, "img/endGUI/backgroundwin.jpg");
+  resources.load(&backgroundLose, "img/endGUI/backgroundlose.jpg");
 
   boxes.push_back( Box(buttonX, buttonY, buttonX + 292, buttonY + 94, 1) );
 
   // load audio
-  winSFX = Mix_LoadWAV("sound/victory sound.wav");
-  if (!winSFX) {
-    printf("Egui1 Failed to load music. SDL_Mixer error: %s\n", Mix_GetError());
-  }
-  failSFX = Mix_LoadWAV("sound/fail sound.wav");
-  if (!failSFX) {
-    printf("Egui2 Failed to load music. SDL_Mixer error: %s\n", Mix_GetError());
-  }
+  resources.loadSound(&winSFX, "sound/victory sound.wav");
+  resources.loadSound(&failSFX, "sound/fail sound.wav");
 }
 
 void EndGUI::setPlayer(int p)
@@ -5,11 +5,15 @@
 
 #include "Board.h"
 #include "GUI.h"
+#include "ResourceManager.h"
 #include "TextureWrapper.h"
 
 class EndGUI: public GUI {
   public:
-    EndGUI(SDL_Renderer* renderer);
+    /**
+     * @param resources: loads the images and sounds (usable after resources.build()).
+     */
+    EndGUI(ResourceManager& resources);
 
     void draw(SDL_Renderer* renderer);
 
@@ -0,0 +1,43 @@
+#include "FrameScheduler.h"
+
+FrameScheduler::FrameScheduler(int frameIntervalMs) {
+  this->frameIntervalMs = frameIntervalMs;
+  frameRequested = true; // draw the first frame
+  animating = false;
+  nextFrameTicks = 0;
+  frameTicks = SDL_GetTicks();
+}
+
+void FrameScheduler::requestFrame() {
+  frameRequested = true;
+}
+
+void FrameScheduler::setAnimating(bool animating) {
+  // an animation that starts plays its first frame right away
+  if (animating && !this->animating) nextFrameTicks = SDL_GetTicks();
+  // an animation that stops shows its end, even if the last frame was drawn just before
+  if (!animating && this->animating) frameRequested = true;
+  this->animating = animating;
+}
+
+int FrameScheduler::getWaitTimeout(int idleTimeoutMs) {
+  if (frameRequested) return 0;
+  if (!animating) return idleTimeoutMs;
+  int remaining = (int) (nextFrameTicks - SDL_GetTicks());
+  if (remaining < 0) return 0;
+  return (remaining < idleTimeoutMs)? remaining : idleTimeoutMs;
+}
+
+bool FrameScheduler::beginFrame() {
+  Uint32 now = SDL_GetTicks();
+  bool due = frameRequested || (animating && (int) (now - nextFrameTicks) >= 0);
+  if (!due) return false;
+  frameRequested = false;
+  nextFrameTicks = now + frameIntervalMs;
+  frameTicks = now;
+  return true;
+}
+
+Uint32 FrameScheduler::getFrameTicks() {
+  return frameTicks;
+}
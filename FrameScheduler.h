@@ -0,0 +1,62 @@
+/***********************************************************************//**
+ * Decides when a GUI needs to draw a frame, and how long the main loop
+ * can sleep waiting for events until then.
+ * A frame is drawn when something changed (requestFrame),
+ * and at a fixed rate while an animation is playing. Otherwise nothing is drawn,
+ * and the main loop sleeps in GUI::getInput until an event arrives.
+ * It is also the clock of the animations (getFrameTicks): with a vsync renderer,
+ * SDL_RenderPresent waits for the display, so frames follow the display's refresh.
+ ***************************************************************************/
+
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <SDL2/SDL.h>
+
+class FrameScheduler {
+  public:
+    static const int DEFAULT_FRAME_INTERVAL_MS = 16; /**< About 60 frames per second while animating */
+
+    /**
+     * @param frameIntervalMs: the time between 2 frames while animating.
+     */
+    FrameScheduler(int frameIntervalMs = DEFAULT_FRAME_INTERVAL_MS);
+    ~FrameScheduler() {}
+
+    /**
+     * Draw a frame as soon as possible (the state changed, or the window needs to be repainted).
+     */
+    void requestFrame();
+
+    /**
+     * @param animating: true to draw a frame every frame interval, false to only draw requested frames.
+     * When an animation stops, one more frame is drawn to show its end.
+     */
+    void setAnimating(bool animating);
+
+    /**
+     * @param idleTimeoutMs: returned when no frame is requested and nothing is animating.
+     * @return how long to wait for events before the next frame is due, in milliseconds.
+     */
+    int getWaitTimeout(int idleTimeoutMs);
+
+    /**
+     * Check if a frame is due, and if so, schedule the next animation frame.
+     * @return true if a frame should be drawn now.
+     */
+    bool beginFrame();
+
+    /**
+     * @return when the current frame began (SDL_GetTicks), the time to draw the animations at.
+     */
+    Uint32 getFrameTicks();
+
+  private:
+    int frameIntervalMs;
+    bool frameRequested; /**< A frame is due as soon as possible */
+    bool animating; /**< Frames are due every frameIntervalMs */
+    Uint32 nextFrameTicks; /**< When the next animation frame is due (SDL_GetTicks) */
+    Uint32 frameTicks; /**< When the current frame began (SDL_GetTicks) */
+};
+
+#endif // FRAMESCHEDULER_H
@@ -1,8 +1,10 @@
 #include "GUI.h"
 #include <stdio.h>
+#include <string.h>
 
 GUI::GUI() {
-  //empty constructor
+  exposed = false;
+  clicked = false;
 }
 
 GUI::~GUI() {
@@ -10,6 +12,7 @@ GUI::~GUI() {
 }
 
 bool GUI::quit = false;
+int GUI::numTargetResets = 0;
 
 GUI::Box::Box(int x1, int y1, int x2, int y2, int value) {
   this->x1 = x1;
@@ -24,15 +27,31 @@ bool GUI::Box::contains(int x, int y) {
   return ((x > x1) && (x < x2) && (y > y1) && (y < y2));
 }
 
-int GUI::getInput() {
+void GUI::wakeUp() {
+  SDL_Event e;
+  memset(&e, 0, sizeof(e));
+  e.type = SDL_USEREVENT;
+  SDL_PushEvent(&e);
+}
+
+int GUI::getInput(int timeoutMs) {
   //Get mouse coordinate
   int boxClicked = 0;
+  clicked = false;
   SDL_Event e;
-  while(SDL_PollEvent(&e) != 0) { //iterate through all events in queue
+  // sleep until the first event, then iterate through all events in queue
+  int hasEvent = (timeoutMs > 0)? SDL_WaitEventTimeout(&e, timeoutMs) : SDL_PollEvent(&e);
+  for (; hasEvent != 0; hasEvent = SDL_PollEvent(&e)) {
     if(e.type == SDL_QUIT) { //if user quit, change quit flag and return immediately
       GUI::quit = true;
       return 0;
+    } else if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_EXPOSED) {
+      exposed = true;
+    } else if (e.type == SDL_RENDER_TARGETS_RESET) {
+      exposed = true;
+      numTargetResets++;
     } else if (e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT) { // if user left-clicks
+      clicked = true;
       int mouseX = e.button.x;
       int mouseY = e.button.y;
 
@@ -48,3 +67,25 @@ int GUI::getInput() {
   }
   return boxClicked;
 }
+
+int GUI::waitInput() {
+  scheduler.setAnimating(isAnimating());
+  int input = getInput(scheduler.getWaitTimeout(IDLE_TIMEOUT_MS));
+  if (clicked && skipAnimation()) {
+    scheduler.requestFrame();
+    return 0;
+  }
+  return input;
+}
+
+void GUI::requestRedraw() {
+  scheduler.requestFrame();
+}
+
+void GUI::drawFrame(SDL_Renderer* renderer) {
+  if (exposed) {
+    exposed = false;
+    scheduler.requestFrame();
+  }
+  if (scheduler.beginFrame()) draw(renderer);
+}
@@ -11,6 +11,8 @@
 #include <SDL2/SDL.h>
 #include <vector>
 
+#include "FrameScheduler.h"
+
 class GUI
 {
   protected:
@@ -39,6 +41,17 @@ class GUI
 
     std::vector<Box> boxes; /**< The array of boxes to get input from */
 
+    bool exposed; /**< Set by getInput when the window needs to be repainted */
+    bool clicked; /**< Set by getInput when the user clicked, inside a box or not */
+
+    FrameScheduler scheduler; /**< Decides when to draw, and the time of the animations */
+
+    /**
+     * Called by waitInput when the user clicks, to jump to the end of a playing animation.
+     * @return true if an animation was skipped (the click is not used as input).
+     */
+    virtual bool skipAnimation() { return false; }
+
   public:
     GUI();
     virtual ~GUI();
@@ -48,13 +61,56 @@ class GUI
      */
     static bool quit;
 
+    /**
+     * Number of SDL_RENDER_TARGETS_RESET events received by any GUI: the content of all
+     * target textures was lost (e.g. the Direct3D device was lost), even of GUIs not on screen.
+     */
+    static int numTargetResets;
+
+    /**
+     * Wait time of the main loop when nothing is animating.
+     * Events wake the loop up earlier, so this only bounds how long state changes without an event go unnoticed.
+     */
+    static const int IDLE_TIMEOUT_MS = 1000;
+
     /**
      * Get user's click.
+     * Sleeps until an event arrives or the timeout expires, then handles all queued events.
      * If user quits, set GUI::quit to true.
+     * @param timeoutMs: the maximum time to wait for an event, 0 to return immediately.
      * @return value of the clicked box
      *         0 if there's no click or if user quits
      */
-    int getInput();
+    int getInput(int timeoutMs = 0);
+
+    /**
+     * Wake up the thread waiting in getInput, e.g. when the AI has new results.
+     * Can be called from any thread.
+     */
+    static void wakeUp();
+
+    /**
+     * @return true while the GUI needs a new frame every frame interval.
+     */
+    virtual bool isAnimating() { return false; }
+
+    /**
+     * Wait for the user's input, until the next frame is due.
+     * Sleeps as long as nothing is animating. A click during a skippable animation ends the animation.
+     * @return the input (see getInput), 0 if the wait ended without a click.
+     */
+    int waitInput();
+
+    /**
+     * Draw a frame at the next drawFrame call (the GUI changed).
+     */
+    void requestRedraw();
+
+    /**
+     * Draw the GUI if a frame is due: a redraw was requested, the window was exposed,
+     * or an animation needs its next frame.
+     */
+    virtual void drawFrame(SDL_Renderer* renderer);
 
     /**
      * Draw the GUI on the screen
@@ -0,0 +1,472 @@
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef WSAPOLLFD PollFD;
+#define poll WSAPoll
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+typedef struct pollfd PollFD;
+#define INVALID_SOCKET (-1)
+#endif
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "GameServer.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // SIGPIPE is ignored instead
+#endif
+
+static const int POLL_TIMEOUT_MS = 100; /**< How often run checks whether it was stopped */
+
+/**
+ * Split a command into words.
+ */
+static std::vector<std::string> splitWords(const std::string& line) {
+  std::vector<std::string> words;
+  size_t pos = 0;
+  while (pos < line.size()) {
+    while (pos < line.size() && isspace((unsigned char) line[pos])) pos++;
+    size_t start = pos;
+    while (pos < line.size() && !isspace((unsigned char) line[pos])) pos++;
+    if (pos > start) words.push_back(line.substr(start, pos - start));
+  }
+  return words;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                                 Sessions
+////////////////////////////////////////////////////////////////////////////
+
+GameServer::Session::Session(Socket socket, int tableMB)
+    : table(tableMB), ai(&board, NULL, MAX_DEPTH), remainingMs(0), searching(false), stopRequested(false), closed(false),
+      hasOutput(false), overflowed(false) {
+  this->socket = socket;
+  board.initBoard();
+  ai.setTranspositionTable(&table);
+  ai.setMateTableSize(tableMB);
+}
+
+GameServer::Session::~Session() {
+  closeSocket(socket);
+}
+
+void GameServer::Session::send(const std::string& line) {
+  std::lock_guard<std::mutex> lock(sendMutex);
+  if (overflowed) return;
+  output += line;
+  output += '\n';
+  sendOutput();
+  if (output.size() > MAX_OUTPUT_SIZE) {
+    // the client doesn't read its replies
+    overflowed = true;
+    output.clear();
+    hasOutput = false;
+  }
+}
+
+void GameServer::Session::flush() {
+  std::lock_guard<std::mutex> lock(sendMutex);
+  sendOutput();
+}
+
+void GameServer::Session::sendOutput() {
+  size_t numSent = 0;
+  while (numSent < output.size()) {
+    int n = ::send(socket, output.c_str() + numSent, output.size() - numSent, MSG_NOSIGNAL);
+    if (n <= 0) break; // full (or an error, which the reading thread sees)
+    numSent += n;
+  }
+  output.erase(0, numSent);
+  hasOutput = !output.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                               Connections
+////////////////////////////////////////////////////////////////////////////
+
+GameServer::GameServer(int numThreads, int maxSessions, int timeBudgetMs, int tableMB)
+    : pool(numThreads), numSessions(0), running(false) {
+  this->maxSessions = maxSessions;
+  this->timeBudgetMs = timeBudgetMs;
+  this->tableMB = tableMB;
+  nnue = NULL;
+#ifdef _WIN32
+  WSADATA data;
+  WSAStartup(MAKEWORD(2, 2), &data);
+#else
+  signal(SIGPIPE, SIG_IGN); // a client leaving while a reply is sent
+#endif
+}
+
+GameServer::~GameServer() {
+  for (int i = 0; i < sessions.size(); i++) {
+    sessions[i]->closed = true;
+    sessions[i]->ai.stop();
+  }
+  sessions.clear(); // the sessions still searching are deleted by their search
+  for (int i = 0; i < listeners.size(); i++) {
+    closeSocket(listeners[i]);
+  }
+#ifndef _WIN32
+  if (!unixPath.empty()) unlink(unixPath.c_str());
+#endif
+  // the pool (a member) waits for the searches before the server is gone
+}
+
+void GameServer::setNNUE(NNUE* net) {
+  nnue = net;
+}
+
+void GameServer::setNonBlocking(Socket socket) {
+#ifdef _WIN32
+  u_long mode = 1;
+  ioctlsocket(socket, FIONBIO, &mode);
+#else
+  fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+}
+
+bool GameServer::wouldBlock() {
+#ifdef _WIN32
+  return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+void GameServer::closeSocket(Socket socket) {
+#ifdef _WIN32
+  closesocket(socket);
+#else
+  close(socket);
+#endif
+}
+
+bool GameServer::listenTCP(int port) {
+  Socket listener = socket(AF_INET, SOCK_STREAM, 0);
+  if (listener == INVALID_SOCKET) {
+    printf("Unable to create a socket\n");
+    return false;
+  }
+  int reuse = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*) &reuse, sizeof(reuse));
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // local clients only
+  address.sin_port = htons(port);
+  if (bind(listener, (sockaddr*) &address, sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0) {
+    printf("Unable to listen on port %i\n", port);
+    closeSocket(listener);
+    return false;
+  }
+  listeners.push_back(listener);
+  printf("Listening on 127.0.0.1:%i\n", port);
+  return true;
+}
+
+bool GameServer::listenUnix(std::string path) {
+#ifdef _WIN32
+  printf("Unix domain sockets are not supported, use a TCP port\n");
+  return false;
+#else
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    printf("Socket path too long: %s\n", path.c_str());
+    return false;
+  }
+  strcpy(address.sun_path, path.c_str());
+  Socket listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener == INVALID_SOCKET) {
+    printf("Unable to create a socket\n");
+    return false;
+  }
+  unlink(path.c_str());
+  if (bind(listener, (sockaddr*) &address, sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0) {
+    printf("Unable to listen on %s\n", path.c_str());
+    closeSocket(listener);
+    return false;
+  }
+  listeners.push_back(listener);
+  unixPath = path;
+  printf("Listening on %s\n", path.c_str());
+  return true;
+#endif
+}
+
+void GameServer::stop() {
+  running = false;
+}
+
+void GameServer::run() {
+  running = true;
+  std::vector<PollFD> fds;
+  while (running) {
+    // the listening sockets first, then the sessions in order
+    fds.clear();
+    for (int i = 0; i < listeners.size() + sessions.size(); i++) {
+      PollFD fd;
+      fd.fd = (i < listeners.size())? listeners[i] : sessions[i - listeners.size()]->socket;
+      fd.events = POLLIN;
+      // wait for room in the socket too when replies are queued
+      if (i >= listeners.size() && sessions[i - listeners.size()]->hasOutput) fd.events |= POLLOUT;
+      fd.revents = 0;
+      fds.push_back(fd);
+    }
+    int numReady = poll(fds.data(), fds.size(), POLL_TIMEOUT_MS);
+    if (numReady < 0) continue;
+
+    // closed sessions first, so that their places can be taken by new connections
+    // (also checked without events: a search's reply can overflow a session's output)
+    std::vector<std::shared_ptr<Session> > polled = sessions;
+    for (int i = 0; i < polled.size(); i++) {
+      short revents = fds[listeners.size() + i].revents;
+      if (revents & POLLOUT) polled[i]->flush();
+      bool open = true;
+      if (revents & ~POLLOUT) open = readSession(polled[i]); // input, or an error that recv reports
+      if (open && !polled[i]->overflowed) continue;
+      // closed: stop its search, which keeps the session until it ends
+      polled[i]->closed = true;
+      polled[i]->ai.stop();
+      for (int k = 0; k < sessions.size(); k++) {
+        if (sessions[k] == polled[i]) sessions.erase(sessions.begin() + k);
+      }
+      numSessions = sessions.size();
+    }
+    for (int i = 0; i < listeners.size(); i++) {
+      if (fds[i].revents & POLLIN) acceptSession(listeners[i]);
+    }
+  }
+}
+
+void GameServer::acceptSession(Socket listener) {
+  Socket socket = accept(listener, NULL, NULL);
+  if (socket == INVALID_SOCKET) return;
+  if (sessions.size() >= maxSessions) {
+    const char* reply = "error server full\n";
+    ::send(socket, reply, strlen(reply), MSG_NOSIGNAL);
+    closeSocket(socket);
+    return;
+  }
+  setNonBlocking(socket);
+  std::shared_ptr<Session> session(new Session(socket, tableMB));
+  if (nnue != NULL) session->ai.setNNUE(nnue);
+  session->remainingMs = timeBudgetMs;
+  sessions.push_back(session);
+  numSessions = sessions.size();
+}
+
+bool GameServer::readSession(const std::shared_ptr<Session>& session) {
+  char buffer[4096];
+  int n = recv(session->socket, buffer, sizeof(buffer), 0);
+  if (n < 0 && wouldBlock()) return true;
+  if (n <= 0) return false;
+  std::string& input = session->input;
+  input.append(buffer, n);
+
+  // run the complete lines
+  size_t start = 0, end;
+  while ((end = input.find('\n', start)) != std::string::npos) {
+    std::string line = input.substr(start, end - start);
+    start = end + 1;
+    if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+    if (!runCommand(session, line)) return false;
+  }
+  input.erase(0, start);
+  if (input.size() > MAX_LINE_LENGTH) {
+    session->send("error line too long");
+    return false;
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                                 Commands
+////////////////////////////////////////////////////////////////////////////
+
+bool GameServer::runCommand(const std::shared_ptr<Session>& session, const std::string& line) {
+  std::vector<std::string> words = splitWords(line);
+  if (words.empty()) return true;
+  const std::string& command = words[0];
+
+  if (command == "quit") {
+    session->send("bye");
+    return false;
+  }
+  if (command == "stop") {
+    session->stopRequested = true;
+    session->ai.stop();
+    return true;
+  }
+  if (session->searching) {
+    session->send("error searching");
+    return true;
+  }
+
+  Board& b = session->board;
+  if (command == "new") {
+    newGame(*session, "");
+    session->send("ok");
+  } else if (command == "fen") {
+    size_t pos = line.find("fen") + 3;
+    if (newGame(*session, line.substr(pos))) session->send("ok");
+    else session->send("error invalid FEN");
+  } else if (command == "move") {
+    int move = (words.size() > 1)? b.findMoveSAN(words[1]) : -1;
+    if (move == -1) {
+      session->send("error illegal move");
+      return true;
+    }
+    std::string san = b.getMoveSAN(move);
+    b.makeMove(move);
+    session->send("ok " + san);
+    if (b.getNumMoves() == 0) {
+      int winner = b.getWinner();
+      session->send((winner == Board::WHITE)? "gameover 1-0" : (winner == Board::BLACK)? "gameover 0-1" : "gameover 1/2-1/2");
+    }
+  } else if (command == "go") {
+    startSearch(session, std::vector<std::string>(words.begin() + 1, words.end()));
+  } else if (command == "mate") {
+    startMateSearch(session, std::vector<std::string>(words.begin() + 1, words.end()));
+  } else if (command == "budget") {
+    session->send("budget " + std::to_string(session->remainingMs));
+  } else {
+    session->send("error unknown command " + command);
+  }
+  return true;
+}
+
+bool GameServer::newGame(Session& session, const std::string& fen) {
+  bool valid = true;
+  if (fen.find_first_not_of(" \t") == std::string::npos) session.board.initBoard();
+  else valid = session.board.loadFEN(fen.substr(fen.find_first_not_of(" \t")));
+  session.table.clear();
+  session.remainingMs = timeBudgetMs;
+  return valid;
+}
+
+int GameServer::getTimeShare(Session& session) {
+  int remainingMs = session.remainingMs;
+  if (remainingMs <= 0) return 0;
+  // a share of the budget, so that the game doesn't run out of time
+  int timeMs = remainingMs / MOVES_TO_GO;
+  return (timeMs < 1)? 1 : timeMs;
+}
+
+void GameServer::startSearch(const std::shared_ptr<Session>& session, const std::vector<std::string>& args) {
+  int depth = MAX_DEPTH;
+  long long nodes = 0;
+  int moveTimeMs = 0;
+  for (int i = 0; i + 1 < args.size(); i += 2) {
+    if (args[i] == "depth") depth = atoi(args[i+1].c_str());
+    else if (args[i] == "nodes") nodes = atoll(args[i+1].c_str());
+    else if (args[i] == "movetime") moveTimeMs = atoi(args[i+1].c_str());
+  }
+  if (depth < 1 || depth > MAX_DEPTH) depth = MAX_DEPTH;
+
+  if (session->board.getNumMoves() == 0) {
+    session->send("bestmove none");
+    return;
+  }
+  int timeMs = getTimeShare(*session);
+  if (timeMs == 0) {
+    session->send("error no time left");
+    return;
+  }
+  if (moveTimeMs > 0 && moveTimeMs < timeMs) timeMs = moveTimeMs;
+  session->ai.setLimits(depth, nodes, timeMs);
+
+  session->searching = true;
+  session->stopRequested = false;
+  session->ai.clearStop(); // before the job is queued: a stop sent from now on stops this search
+  std::shared_ptr<Session> shared = session; // the job keeps the session until it ends
+  if (!pool.trySubmit([this, shared]() { search(*shared); })) {
+    session->searching = false;
+    session->send("busy");
+  }
+}
+
+void GameServer::search(Session& session) {
+  if (session.closed) {
+    session.searching = false;
+    return;
+  }
+  // stopped while queued: only search the first depth
+  if (session.stopRequested) session.ai.setLimits(1, 0, 0);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  int move = session.ai.decideMove();
+  int timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  session.remainingMs -= timeMs;
+
+  std::string reply;
+  if (move == -1) {
+    reply = "bestmove none";
+  } else {
+    int score = (session.ai.getNumPVLines() > 0)? session.ai.getPVLine(0).score : 0;
+    reply = "bestmove " + session.board.getMoveSAN(move) + " score " + std::to_string(score)
+            + " depth " + std::to_string(session.ai.getCompletedDepth())
+            + " nodes " + std::to_string(session.ai.getNumNodes()) + " time " + std::to_string(timeMs);
+    if (session.ai.getNumPVLines() > 0) reply += " pv " + session.ai.getPVLineSAN(0);
+  }
+  // the board is the client's again before it reads the reply
+  session.searching = false;
+  session.send(reply);
+}
+
+void GameServer::startMateSearch(const std::shared_ptr<Session>& session, const std::vector<std::string>& args) {
+  int maxMoves = 0;
+  long long nodes = MATE_NODES;
+  for (int i = 0; i + 1 < args.size(); i += 2) {
+    if (args[i] == "moves") maxMoves = atoi(args[i+1].c_str());
+    else if (args[i] == "nodes") nodes = atoll(args[i+1].c_str());
+  }
+  if (maxMoves < 0) maxMoves = 0;
+  if (nodes <= 0 || nodes > MATE_NODES) nodes = MATE_NODES;
+  int timeMs = getTimeShare(*session);
+  if (timeMs == 0) {
+    session->send("error no time left");
+    return;
+  }
+  session->ai.setLimits(MAX_DEPTH, nodes, timeMs);
+
+  session->searching = true;
+  session->stopRequested = false;
+  session->ai.clearStop();
+  std::shared_ptr<Session> shared = session;
+  if (!pool.trySubmit([this, shared, maxMoves]() { searchMate(*shared, maxMoves); })) {
+    session->searching = false;
+    session->send("busy");
+  }
+}
+
+void GameServer::searchMate(Session& session, int maxMoves) {
+  if (session.closed) {
+    session.searching = false;
+    return;
+  }
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  int result = session.ai.findMate(maxMoves);
+  int timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  session.remainingMs -= timeMs;
+  std::string reply;
+  if (result == MateSolver::MATE_FOUND) reply = "mate " + session.ai.getMateLineSAN();
+  else if (result == MateSolver::NO_MATE) reply = "nomate";
+  else reply = "unknown";
+  session.searching = false;
+  session.send(reply);
+}
@@ -0,0 +1,229 @@
+/***********************************************************************//**
+ * Serves many games at the same time over local sockets, without a window.
+ *
+ * Each connection is a session with its own Board, AIPlayer and transposition table.
+ * Clients send one command per line and receive one reply per line:
+ *   new                  start a game from the starting position        -> ok
+ *   fen <FEN>            start a game from a position                   -> ok | error ...
+ *   move <SAN>           play a move                                    -> ok <SAN> [then gameover <result>]
+ *   go [depth N] [nodes N] [movetime MS]
+ *                        search the position (the move is not played)   -> bestmove <SAN> score <cp> depth <d>
+ *                                                                          nodes <n> time <ms> pv <SAN>...
+ *                                                                          | bestmove none | busy
+ *   mate [moves N] [nodes N]
+ *                        look for a forced mate (MateSolver)            -> mate <SAN>... | nomate | unknown
+ *                                                                          | busy
+ *   stop                 end the current search early (its bestmove follows)
+ *   budget               the session's remaining thinking time          -> budget <ms>
+ *   quit                 close the session                              -> bye
+ *
+ * One thread reads all connections (poll) and runs the commands, except the searches:
+ * they are run by a shared pool of a few threads, so that the number of searches
+ * running at the same time doesn't depend on the number of sessions.
+ * When the pool's queue is full, "go" is answered "busy" at once, and the client
+ * retries later. A session has a thinking time budget per game: a search uses at most
+ * 1 / MOVES_TO_GO of what is left, and its time is taken from the budget.
+ * "mate" is run by the pool and limited by the budget like "go", and its nodes are limited to MATE_NODES.
+ * Commands other than stop and quit are refused while the session's search runs.
+ *
+ * Sockets are non-blocking: replies are queued per session and sent as the client reads them,
+ * so a client that doesn't read can't block the reading thread. A session whose unsent replies
+ * exceed MAX_OUTPUT_SIZE is closed.
+ *
+ * The server only listens on the loopback interface (or on a Unix domain socket),
+ * e.g. test it with: nc localhost 7777
+ ***************************************************************************/
+
+#ifndef GAMESERVER_H
+#define GAMESERVER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "AIPlayer.h"
+#include "Board.h"
+#include "NNUE.h"
+#include "ThreadPool.h"
+#include "TranspositionTable.h"
+
+class GameServer {
+  public:
+#ifdef _WIN32
+    typedef uintptr_t Socket; /**< SOCKET */
+#else
+    typedef int Socket; /**< File descriptor */
+#endif
+
+    static const int DEFAULT_PORT = 7777;
+    static const int DEFAULT_MAX_SESSIONS = 64;
+    static const int DEFAULT_TIME_BUDGET_MS = 300000; /**< 5 minutes per game */
+    static const int DEFAULT_TABLE_MB = 4; /**< The transposition table of each session */
+    static const int MOVES_TO_GO = 30; /**< A search uses at most this fraction of the remaining budget */
+    static const int MAX_DEPTH = 64;
+    static const int MAX_LINE_LENGTH = 1024; /**< Longer commands close the session */
+    static const int MAX_OUTPUT_SIZE = 65536; /**< More unsent bytes close the session */
+    static const long long MATE_NODES = 10000000; /**< The node limit of "mate", and its default */
+
+    /**
+     * @param numThreads: the number of searches run at the same time. 0 to use all cores.
+     * @param maxSessions: connections beyond this number are refused.
+     * @param timeBudgetMs: the thinking time of each session per game.
+     * @param tableMB: the size of each session's transposition table (and of its mate search's table).
+     */
+    GameServer(int numThreads = 0, int maxSessions = DEFAULT_MAX_SESSIONS,
+               int timeBudgetMs = DEFAULT_TIME_BUDGET_MS, int tableMB = DEFAULT_TABLE_MB);
+
+    /**
+     * Close the sessions and the listening sockets (after waiting for the searches).
+     */
+    ~GameServer();
+
+    /**
+     * Evaluate with a neural network in all sessions created from now on.
+     * @param net: a loaded network (shared, not copied), or NULL to use the tables.
+     */
+    void setNNUE(NNUE* net);
+
+    /**
+     * Listen for connections on a TCP port of the loopback interface (127.0.0.1).
+     * @return false if the port can't be bound.
+     */
+    bool listenTCP(int port);
+
+    /**
+     * Listen for connections on a Unix domain socket (not on Windows). An existing file at path is replaced.
+     * @return false if the socket can't be created.
+     */
+    bool listenUnix(std::string path);
+
+    /**
+     * Serve the sessions until stop is called. Listen first.
+     */
+    void run();
+
+    /**
+     * Make run return (from another thread or a signal handler).
+     */
+    void stop();
+
+    int getNumSessions() { return numSessions; }
+
+  private:
+    /**
+     * A connection and its game.
+     */
+    struct Session {
+      Socket socket;
+      std::string input; /**< Received text not ending with a new line yet */
+      Board board;
+      TranspositionTable table;
+      AIPlayer ai;
+      std::atomic<int> remainingMs; /**< The thinking time left in the game */
+
+      std::atomic<bool> searching; /**< Set from "go" until the search's reply is ready (the board is the search's) */
+      std::atomic<bool> stopRequested; /**< Set by "stop" */
+      std::atomic<bool> closed; /**< Set when the client is gone */
+      std::mutex sendMutex; /**< Lines are sent by the reading thread and by the searches */
+      std::string output; /**< Text not sent yet (the client isn't reading fast enough), guarded by sendMutex */
+      std::atomic<bool> hasOutput; /**< Whether output isn't empty, for the reading thread to wait for the socket */
+      std::atomic<bool> overflowed; /**< Set when output exceeds MAX_OUTPUT_SIZE: the session must be closed */
+
+      Session(Socket socket, int tableMB);
+      ~Session(); /**< Closes the socket, once neither the reading thread nor a search uses the session */
+
+      /**
+       * Send a line (a new line is added), or queue it if the socket is full.
+       * Errors are ignored: the reading thread sees the connection closed.
+       */
+      void send(const std::string& line);
+
+      /**
+       * Send as much of the queued text as the socket takes.
+       */
+      void flush();
+
+    private:
+      void sendOutput(); /**< flush, with sendMutex locked */
+    };
+
+    int maxSessions;
+    int timeBudgetMs;
+    int tableMB;
+    NNUE* nnue;
+
+    ThreadPool pool;
+    std::vector<Socket> listeners;
+    std::string unixPath; /**< The Unix domain socket's file, removed when closing */
+    std::vector<std::shared_ptr<Session> > sessions; /**< A search holds its session too, until it ends */
+    std::atomic<int> numSessions;
+    std::atomic<bool> running;
+
+    /**
+     * Accept a connection on a listening socket.
+     */
+    void acceptSession(Socket listener);
+
+    /**
+     * Read what a session's client sent and run its complete lines.
+     * @return false if the session is closed (by the client, an error or "quit").
+     */
+    bool readSession(const std::shared_ptr<Session>& session);
+
+    /**
+     * Run one command.
+     * @return false to close the session.
+     */
+    bool runCommand(const std::shared_ptr<Session>& session, const std::string& line);
+
+    /**
+     * @return the thinking time of a search: a share of the session's remaining budget, 0 if none is left.
+     */
+    int getTimeShare(Session& session);
+
+    /**
+     * Queue the search of "go", or answer busy if the pool is full.
+     * @param args: the arguments after "go".
+     */
+    void startSearch(const std::shared_ptr<Session>& session, const std::vector<std::string>& args);
+
+    /**
+     * Search a session's board in a pool thread and send the reply.
+     */
+    void search(Session& session);
+
+    /**
+     * Queue the mate search of "mate", or answer busy if the pool is full.
+     * @param args: the arguments after "mate".
+     */
+    void startMateSearch(const std::shared_ptr<Session>& session, const std::vector<std::string>& args);
+
+    /**
+     * Look for a mate on a session's board in a pool thread and send the reply.
+     */
+    void searchMate(Session& session, int maxMoves);
+
+    /**
+     * Reset a session's game, its budget and its table.
+     * @param fen: the starting position, empty for the standard one.
+     * @return false if the FEN is invalid.
+     */
+    bool newGame(Session& session, const std::string& fen);
+
+    static void closeSocket(Socket socket);
+
+    /**
+     * Make a socket's sends and receives return at once instead of waiting.
+     */
+    static void setNonBlocking(Socket socket);
+
+    /**
+     * @return true if the last failed send or recv only failed because it would have waited.
+     */
+    static bool wouldBlock();
+};
+
+#endif // GAMESERVER_H
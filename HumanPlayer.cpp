@@ -47,5 +47,5 @@ int HumanPlayer::decideMove()
 
     }
   }*/
-  return bGUI->getInput();
+  return bGUI->waitInput();
 }
@@ -0,0 +1,106 @@
+#include "MappedFile.h"
+
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() {
+  data = NULL;
+  size = 0;
+#ifdef _WIN32
+  fileHandle = INVALID_HANDLE_VALUE;
+  mappingHandle = NULL;
+#else
+  fd = -1;
+#endif
+}
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(std::string path, bool randomAccess) {
+  close();
+  fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL | (randomAccess? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN), NULL);
+  if (fileHandle == INVALID_HANDLE_VALUE) {
+    printf("Unable to open %s\n", path.c_str());
+    return false;
+  }
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(fileHandle, &fileSize)) {
+    printf("Unable to get the size of %s\n", path.c_str());
+    close();
+    return false;
+  }
+  size = (size_t) fileSize.QuadPart;
+  if (size == 0) return true;
+
+  mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mappingHandle != NULL) data = (const char*) MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+  if (data == NULL) {
+    printf("Unable to map %s into memory\n", path.c_str());
+    close();
+    return false;
+  }
+  return true;
+}
+
+void MappedFile::close() {
+  if (data != NULL) UnmapViewOfFile(data);
+  if (mappingHandle != NULL) CloseHandle(mappingHandle);
+  if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+  data = NULL;
+  size = 0;
+  fileHandle = INVALID_HANDLE_VALUE;
+  mappingHandle = NULL;
+}
+
+#else
+
+bool MappedFile::open(std::string path, bool randomAccess) {
+  close();
+  fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    printf("Unable to open %s\n", path.c_str());
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    printf("Unable to get the size of %s\n", path.c_str());
+    close();
+    return false;
+  }
+  size = info.st_size;
+  if (size == 0) return true;
+
+  void* mapped = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (mapped == MAP_FAILED) {
+    printf("Unable to map %s into memory\n", path.c_str());
+    close();
+    return false;
+  }
+  // lookups jumping around the file would make the system read ahead pages that are not used
+  madvise(mapped, size, randomAccess? MADV_RANDOM : MADV_SEQUENTIAL);
+  data = (const char*) mapped;
+  return true;
+}
+
+void MappedFile::close() {
+  if (data != NULL) munmap((void*) data, size);
+  if (fd != -1) ::close(fd);
+  data = NULL;
+  size = 0;
+  fd = -1;
+}
+
+#endif
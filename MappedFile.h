@@ -0,0 +1,58 @@
+/***********************************************************************//**
+ * A file mapped read-only into memory (mmap, or a file mapping on Windows).
+ * Its pages are read from the disk when they are first touched, and stay
+ * in the operating system's cache, so random lookups in a large file
+ * don't read the whole file and don't copy it into the process.
+ ***************************************************************************/
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <stddef.h>
+#include <string>
+
+class MappedFile {
+  public:
+    MappedFile();
+    ~MappedFile();
+
+    /**
+     * Map a file (closing the previous one).
+     * @param path: path to the file.
+     * @param randomAccess: true if the file is read in random order (e.g. binary search),
+     * so that the system doesn't read ahead of the pages touched.
+     * @return false if the file can't be opened or mapped. An empty file is opened without data.
+     */
+    bool open(std::string path, bool randomAccess = false);
+
+    /**
+     * Unmap the file. Pointers into its data can't be used anymore.
+     */
+    void close();
+
+    /**
+     * @return the first byte of the file, NULL if no file is mapped or the file is empty.
+     */
+    const char* getData() { return data; }
+
+    /**
+     * @return the size of the file in bytes.
+     */
+    size_t getSize() { return size; }
+
+  private:
+    const char* data;
+    size_t size;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fd;
+#endif
+
+    // a mapping can't be shared by two objects
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,303 @@
+#include <stdio.h>
+
+#include "MateSolver.h"
+
+MateSolver::MateSolver(int memoryMB) {
+  // round down to a power of 2 so that a key can be masked into an index
+  long long numEntries = (long long) memoryMB * 1024 * 1024 / sizeof(Entry);
+  long long size = BUCKET_SIZE;
+  while (size * 2 <= numEntries) size *= 2;
+  table.resize(size);
+  mask = (size - 1) & ~(uint64_t) (BUCKET_SIZE - 1);
+  clear();
+  numNodes = 0;
+  maxNodes = 0;
+  maxTimeMs = 0;
+  abort = NULL;
+  shortest = false;
+}
+
+void MateSolver::clear() {
+  for (int i = 0; i < table.size(); i++) {
+    table[i].key = 0;
+    table[i].work = 0;
+  }
+}
+
+long long MateSolver::getNumNodes() {
+  return numNodes;
+}
+
+bool MateSolver::isShortest() {
+  return shortest;
+}
+
+std::vector<int> MateSolver::getMateLine() {
+  return mateLine;
+}
+
+std::string MateSolver::getMateLineSAN() {
+  Board b = board;
+  std::string san;
+  for (int i = 0; i < mateLine.size(); i++) {
+    if (i > 0) san += ' ';
+    san += b.getMoveSAN(mateLine[i]);
+    b.makeMove(mateLine[i]);
+  }
+  return san;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                          Transposition table
+////////////////////////////////////////////////////////////////////////////
+
+uint64_t MateSolver::getNodeKey(int plies) {
+  if (!limited) return board.getHashKey();
+  return board.getHashKey() ^ ((uint64_t) plies * 0x9E3779B97F4A7C15ULL);
+}
+
+MateSolver::Entry* MateSolver::lookup(uint64_t key) {
+  Entry* bucket = &table[key & mask];
+  for (int i = 0; i < BUCKET_SIZE; i++) {
+    if (bucket[i].key == key && bucket[i].work != 0) return &bucket[i];
+  }
+  return NULL;
+}
+
+void MateSolver::store(uint64_t key, uint32_t phi, uint32_t delta, uint32_t work, int move) {
+  Entry* bucket = &table[key & mask];
+  // same key, else the entry with the smallest sub-tree
+  Entry* entry = &bucket[0];
+  for (int i = 0; i < BUCKET_SIZE; i++) {
+    if (bucket[i].key == key) {
+      entry = &bucket[i];
+      break;
+    }
+    if (bucket[i].work < entry->work) entry = &bucket[i];
+  }
+  entry->key = key;
+  entry->phi = phi;
+  entry->delta = delta;
+  entry->work = (work > 0)? work : 1;
+  entry->move = move;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                                Search
+////////////////////////////////////////////////////////////////////////////
+
+int MateSolver::solve(Board* b, int maxMoves, long long maxNodes, int maxTimeMs, const std::atomic<bool>* abort) {
+  board = *b;
+  board.attachNNUE(NULL); // the solver doesn't evaluate, so don't update the accumulator
+  attacker = board.getPlayer();
+  limited = (maxMoves > 0);
+  rootPlies = limited? 2 * maxMoves - 1 : MAX_PLIES;
+  this->maxNodes = maxNodes;
+  this->maxTimeMs = maxTimeMs;
+  this->abort = abort;
+  startTime = std::chrono::steady_clock::now();
+  nextTimeCheck = TIME_CHECK_NODES;
+  numNodes = 0;
+  stopped = false;
+  path.clear();
+  mateLine.clear();
+  shortest = false;
+
+  uint32_t phi, delta;
+  if (!getTerminalNumbers(rootPlies, phi, delta)) {
+    search(INF, INF, rootPlies, phi, delta);
+  }
+  if (phi == 0) {
+    // the line is proven again where the table lost it, which must not stop on the limits
+    this->maxNodes = 0;
+    this->maxTimeMs = 0;
+    this->abort = NULL;
+    stopped = false;
+    if (extractMateLine()) return MATE_FOUND;
+    mateLine.clear();
+    return UNKNOWN;
+  }
+  if (delta == 0) return NO_MATE;
+  return UNKNOWN;
+}
+
+int MateSolver::solveShortest(Board* b, int maxMoves, long long maxNodes, int maxTimeMs, const std::atomic<bool>* abort) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  int result = solve(b, maxMoves, maxNodes, maxTimeMs, abort);
+  if (result != MATE_FOUND) return result;
+
+  // try the shorter mates, the table is kept (the move limit is part of the keys)
+  std::vector<int> line = mateLine;
+  long long totalNodes = numNodes;
+  int numMoves = (line.size() + 1) / 2;
+  bool found = false, stoppedEarly = false;
+  for (int moves = 1; moves < numMoves && !found && !stoppedEarly; moves++) {
+    long long nodesLeft = 0;
+    if (maxNodes > 0) {
+      nodesLeft = maxNodes - totalNodes;
+      if (nodesLeft <= 0) {
+        stoppedEarly = true;
+        break;
+      }
+    }
+    int timeLeftMs = 0;
+    if (maxTimeMs > 0) {
+      timeLeftMs = maxTimeMs - std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+      if (timeLeftMs <= 0) {
+        stoppedEarly = true;
+        break;
+      }
+    }
+    int shorterResult = solve(b, moves, nodesLeft, timeLeftMs, abort);
+    totalNodes += numNodes;
+    if (shorterResult == MATE_FOUND) found = true;
+    else if (shorterResult == UNKNOWN) stoppedEarly = true;
+  }
+  if (!found) mateLine = line;
+  numNodes = totalNodes;
+  shortest = !stoppedEarly;
+  return MATE_FOUND;
+}
+
+bool MateSolver::isLimitReached() {
+  if (maxNodes > 0 && numNodes >= maxNodes) return true;
+  if (abort != NULL && *abort) return true;
+  if (maxTimeMs > 0 && numNodes >= nextTimeCheck) {
+    nextTimeCheck = numNodes + TIME_CHECK_NODES;
+    int elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+    if (elapsedMs >= maxTimeMs) return true;
+  }
+  return false;
+}
+
+bool MateSolver::getTerminalNumbers(int plies, uint32_t& phi, uint32_t& delta) {
+  bool attackerToMove = (board.getPlayer() == attacker);
+  bool mate = false, draw = false;
+  if (board.getNumMoves() == 0) {
+    if (board.isKingChecked()) mate = true;
+    else draw = true;
+  } else if (plies <= 0) {
+    draw = true; // counts as failing to mate
+  } else {
+    for (int i = 0; i < path.size(); i++) {
+      if (path[i] == board.getHashKey()) draw = true;
+    }
+  }
+  if (mate) {
+    // the player to move is mated: proven if it is the defender, disproven if it is the attacker
+    phi = INF;
+    delta = 0;
+    return true;
+  }
+  if (draw) {
+    // disproven
+    phi = attackerToMove? INF : 0;
+    delta = attackerToMove? 0 : INF;
+    return true;
+  }
+  return false;
+}
+
+void MateSolver::search(uint32_t thPhi, uint32_t thDelta, int plies, uint32_t& phi, uint32_t& delta) {
+  numNodes++;
+  long long startNodes = numNodes;
+  uint64_t key = getNodeKey(plies);
+  int numMoves = board.getNumMoves();
+
+  // the numbers of the children (from their point of view)
+  std::vector<uint32_t> childPhi(numMoves), childDelta(numMoves);
+  path.push_back(board.getHashKey());
+  for (int m = 0; m < numMoves; m++) {
+    board.makeMove(m);
+    if (!getTerminalNumbers(plies - 1, childPhi[m], childDelta[m])) {
+      Entry* entry = lookup(getNodeKey(plies - 1));
+      childPhi[m] = (entry != NULL)? entry->phi : 1;
+      childDelta[m] = (entry != NULL)? entry->delta : 1;
+    }
+    board.undoMove();
+  }
+
+  int best = 0;
+  while (true) {
+    // phi is the smallest delta of the children, delta is the sum of their phi
+    phi = INF;
+    delta = 0;
+    uint32_t secondDelta = INF;
+    for (int m = 0; m < numMoves; m++) {
+      if (childDelta[m] < phi) {
+        secondDelta = phi;
+        phi = childDelta[m];
+        best = m;
+      } else if (childDelta[m] < secondDelta) {
+        secondDelta = childDelta[m];
+      }
+      delta += childPhi[m];
+      if (delta > INF) delta = INF;
+    }
+    if (phi >= thPhi || delta >= thDelta || stopped) break;
+    if (isLimitReached()) {
+      stopped = true;
+      break;
+    }
+
+    // search the most promising child until it is no longer the most promising
+    uint64_t childThPhi = (uint64_t) thDelta + childPhi[best] - delta;
+    uint64_t childThDelta = (secondDelta + 1 < thPhi)? secondDelta + 1 : thPhi;
+    board.makeMove(best);
+    search(childThPhi < INF? childThPhi : INF, childThDelta, plies - 1, childPhi[best], childDelta[best]);
+    board.undoMove();
+  }
+  path.pop_back();
+
+  if (!stopped) {
+    long long work = numNodes - startNodes + 1;
+    store(key, phi, delta, (work < 0xFFFFFFFF)? work : 0xFFFFFFFF, best);
+  }
+}
+
+bool MateSolver::extractMateLine() {
+  int plies = rootPlies;
+  bool proven = true;
+  while (board.getNumMoves() > 0 && plies > 0) {
+    // proven: the attacker to move has a proof number of 0, the defender to move a disproof number of 0
+    bool attackerToMove = (board.getPlayer() == attacker);
+    Entry* entry = lookup(getNodeKey(plies));
+    if (entry == NULL || (attackerToMove? entry->phi : entry->delta) != 0) {
+      // the sub-tree was replaced in the table, prove it again
+      uint32_t phi, delta;
+      search(INF, INF, plies, phi, delta);
+      entry = lookup(getNodeKey(plies));
+      if (entry == NULL || (attackerToMove? entry->phi : entry->delta) != 0) {
+        proven = false;
+        break;
+      }
+    }
+
+    int move = entry->move;
+    if (!attackerToMove) {
+      // defender: play the reply that took the most work to refute
+      uint32_t mostWork = 0;
+      for (int m = 0; m < board.getNumMoves(); m++) {
+        board.makeMove(m);
+        Entry* child = lookup(getNodeKey(plies - 1));
+        if (child != NULL && child->work > mostWork) {
+          mostWork = child->work;
+          move = m;
+        }
+        board.undoMove();
+      }
+    }
+    path.push_back(board.getHashKey()); // repetitions on the line, for the searches above
+    mateLine.push_back(move);
+    board.makeMove(move);
+    plies--;
+  }
+  // the line must end with the defender mated
+  proven = proven && board.getNumMoves() == 0 && board.isKingChecked() && board.getPlayer() != attacker;
+  // go back to the solved position
+  for (int i = 0; i < mateLine.size(); i++) {
+    board.undoMove();
+  }
+  path.clear();
+  return proven;
+}
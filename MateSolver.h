@@ -0,0 +1,160 @@
+/***********************************************************************//**
+ * Mate finder using depth-first proof-number search (df-pn).
+ * Proves that the player to move can force a check mate (or that it cannot,
+ * within the move limit), without evaluating positions.
+ * Unlike alpha-beta, the search grows the tree where the defender has
+ * the fewest replies, so long forcing mates are found quickly.
+ *
+ * Proof and disproof numbers are kept in a transposition table of fixed size,
+ * indexed by Board's Zobrist key. When the table is full, the entries
+ * with the smallest sub-trees are replaced.
+ * Repeated positions are scored as draws. Results depending on them are
+ * stored like any other, so a mate can rarely be missed, but a found mate is always sound.
+ ***************************************************************************/
+
+#ifndef MATESOLVER_H
+#define MATESOLVER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "Board.h"
+
+class MateSolver {
+  public:
+    /**
+     * @param memoryMB: the size of the transposition table in megabytes.
+     */
+    MateSolver(int memoryMB = 64);
+    ~MateSolver() {}
+
+    enum Results {
+      MATE_FOUND, /**< The player to move can force a mate */
+      NO_MATE, /**< There is no mate within the move limit */
+      UNKNOWN /**< The node limit was reached */
+    };
+
+    /**
+     * Search for a forced mate by the player to move. The board is not changed.
+     * @param b: the position to solve.
+     * @param maxMoves: only look for mates in at most this many moves (of the attacker), 0 for no limit.
+     * @param maxNodes: stop after this many nodes, 0 for no limit.
+     * @param maxTimeMs: stop after this many milliseconds, 0 for no limit.
+     * @param abort: stop when this flag is set (from another thread), NULL for none.
+     * @return one of the Results, UNKNOWN if stopped.
+     */
+    int solve(Board* b, int maxMoves = 0, long long maxNodes = 0, int maxTimeMs = 0, const std::atomic<bool>* abort = NULL);
+
+    /**
+     * Search for one of the shortest forced mates: solve, then if a mate in N moves is found,
+     * solve again with the move limits 1, 2, ... N - 1 until a mate is found.
+     * The node and time limits and the abort flag apply to all the searches together. When they stop
+     * a search after the first mate was found, that mate is kept (isShortest is then false).
+     * The parameters are those of solve.
+     * @return one of the Results.
+     */
+    int solveShortest(Board* b, int maxMoves = 0, long long maxNodes = 0, int maxTimeMs = 0, const std::atomic<bool>* abort = NULL);
+
+    /**
+     * @return true if the line found by the last call to solveShortest is one of the shortest mates.
+     * false after solve, whose line may be longer than needed.
+     */
+    bool isShortest();
+
+    /**
+     * Get the mating line found by the last call to solve or solveShortest.
+     * The line is a forced mate, not necessarily the shortest one (see isShortest).
+     * @return the move numbers, each in the move list of the position reached by the previous moves.
+     */
+    std::vector<int> getMateLine();
+
+    /**
+     * @return the mating line in SAN, separated by spaces. Empty if no mate was found.
+     */
+    std::string getMateLineSAN();
+
+    /**
+     * @return the number of nodes searched by the last call to solve or solveShortest.
+     */
+    long long getNumNodes();
+
+    /**
+     * Empty the transposition table.
+     */
+    void clear();
+
+  private:
+    static const uint32_t INF = 100000000; /**< Proof or disproof number of a solved node */
+    static const int MAX_PLIES = 250; /**< Depth limit of searches without a move limit */
+
+    struct Entry {
+      uint64_t key;
+      uint32_t phi; /**< Proof number if the attacker is to move, else disproof number */
+      uint32_t delta; /**< Disproof number if the attacker is to move, else proof number */
+      uint32_t work; /**< Number of nodes searched under this node, used for replacement */
+      int16_t move; /**< The move leading to the child with the smallest delta */
+      int16_t unused;
+    };
+    static const int BUCKET_SIZE = 4; /**< Number of entries a key can be stored in */
+
+    std::vector<Entry> table;
+    uint64_t mask; /**< Index mask of the first entry of a bucket */
+
+    Board board; /**< Copy of the solved position */
+    int attacker; /**< The player trying to mate */
+    bool limited; /**< true if searching with a move limit */
+    int rootPlies;
+    long long numNodes;
+    long long maxNodes;
+    int maxTimeMs;
+    std::chrono::steady_clock::time_point startTime;
+    long long nextTimeCheck; /**< The clock is read every TIME_CHECK_NODES nodes */
+    static const int TIME_CHECK_NODES = 1024;
+    const std::atomic<bool>* abort; /**< Stops the search when set, can be NULL */
+    bool stopped;
+    std::vector<uint64_t> path; /**< Keys of the positions from the root to the current node */
+    std::vector<int> mateLine;
+    bool shortest; /**< Whether mateLine is one of the shortest mates */
+
+    /**
+     * Search a node until its phi reaches thPhi or its delta reaches thDelta.
+     * @param plies: the number of half-turns left.
+     * @param phi, delta: receive the new numbers of the node.
+     */
+    void search(uint32_t thPhi, uint32_t thDelta, int plies, uint32_t& phi, uint32_t& delta);
+
+    /**
+     * @return true if the node limit or the time limit is reached, or the search is aborted.
+     */
+    bool isLimitReached();
+
+    /**
+     * Set phi and delta if the current node is solved without searching
+     * (check mate, stalemate, repetition or no half-turn left).
+     * @return true if the node is solved.
+     */
+    bool getTerminalNumbers(int plies, uint32_t& phi, uint32_t& delta);
+
+    /**
+     * @return the table key of the current node (the move limit makes the same position a different node).
+     */
+    uint64_t getNodeKey(int plies);
+
+    /**
+     * @return the entry of a key, NULL if it is not in the table.
+     */
+    Entry* lookup(uint64_t key);
+
+    void store(uint64_t key, uint32_t phi, uint32_t delta, uint32_t work, int move);
+
+    /**
+     * Follow the table from the root to build mateLine. Sub-trees replaced in the table are searched again.
+     * @return false if the line couldn't be proven again (the table is too small), or doesn't end with a mate.
+     */
+    bool extractMateLine();
+};
+
+#endif // MATESOLVER_H
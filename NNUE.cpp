@@ -0,0 +1,238 @@
+#include <stdio.h>
+#include <string.h>
+
+// With GCC or Clang on x86, all the kernels are compiled (each with its own target)
+// and the best one the CPU supports is chosen at run time, so builds without -mavx2 still use AVX2.
+// Other compilers only have the kernels of the instruction sets they target (e.g. MSVC's /arch:AVX2).
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define RUNTIME_DISPATCH
+#define USE_AVX2
+#define USE_SSE41
+#define TARGET(features) __attribute__((target(features)))
+#else
+#if defined(__AVX2__)
+#define USE_AVX2
+#endif
+#if defined(__SSE4_1__)
+#define USE_SSE41
+#endif
+#define TARGET(features)
+#endif
+
+#if defined(USE_AVX2) || defined(USE_SSE41)
+#include <immintrin.h>
+#endif
+
+#include "NNUE.h"
+
+////////////////////////////////////////////////////////////////////////////
+//                           Vector kernels
+////////////////////////////////////////////////////////////////////////////
+
+// addVector: acc[i] += w[i] for HIDDEN_SIZE values
+// subVector: acc[i] -= w[i] for HIDDEN_SIZE values
+// dotClipped: sum of clamp(acc[i], 0, ceiling) * w[i] for HIDDEN_SIZE values
+
+#ifdef USE_AVX2
+TARGET("avx2") static void addVectorAVX2(int16_t* acc, const int16_t* w) {
+  for (int i = 0; i < NNUE::HIDDEN_SIZE; i += 16) {
+    __m256i a = _mm256_loadu_si256((const __m256i*) (acc + i));
+    __m256i b = _mm256_loadu_si256((const __m256i*) (w + i));
+    _mm256_storeu_si256((__m256i*) (acc + i), _mm256_add_epi16(a, b));
+  }
+}
+
+TARGET("avx2") static void subVectorAVX2(int16_t* acc, const int16_t* w) {
+  for (int i = 0; i < NNUE::HIDDEN_SIZE; i += 16) {
+    __m256i a = _mm256_loadu_si256((const __m256i*) (acc + i));
+    __m256i b = _mm256_loadu_si256((const __m256i*) (w + i));
+    _mm256_storeu_si256((__m256i*) (acc + i), _mm256_sub_epi16(a, b));
+  }
+}
+
+TARGET("avx2") static int32_t dotClippedAVX2(const int16_t* acc, const int16_t* w, int16_t ceiling) {
+  __m256i zero = _mm256_setzero_si256();
+  __m256i top = _mm256_set1_epi16(ceiling);
+  __m256i sum = _mm256_setzero_si256();
+  for (int i = 0; i < NNUE::HIDDEN_SIZE; i += 16) {
+    __m256i a = _mm256_loadu_si256((const __m256i*) (acc + i));
+    __m256i b = _mm256_loadu_si256((const __m256i*) (w + i));
+    a = _mm256_min_epi16(_mm256_max_epi16(a, zero), top);
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(a, b));
+  }
+  __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+  half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(half);
+}
+#endif
+
+#ifdef USE_SSE41
+TARGET("sse4.1") static void addVectorSSE41(int16_t* acc, const int16_t* w) {
+  for (int i = 0; i < NNUE::HIDDEN_SIZE; i += 8) {
+    __m128i a = _mm_loadu_si128((const __m128i*) (acc + i));
+    __m128i b = _mm_loadu_si128((const __m128i*) (w + i));
+    _mm_storeu_si128((__m128i*) (acc + i), _mm_add_epi16(a, b));
+  }
+}
+
+TARGET("sse4.1") static void subVectorSSE41(int16_t* acc, const int16_t* w) {
+  for (int i = 0; i < NNUE::HIDDEN_SIZE; i += 8) {
+    __m128i a = _mm_loadu_si128((const __m128i*) (acc + i));
+    __m128i b = _mm_loadu_si128((const __m128i*) (w + i));
+    _mm_storeu_si128((__m128i*) (acc + i), _mm_sub_epi16(a, b));
+  }
+}
+
+TARGET("sse4.1") static int32_t dotClippedSSE41(const int16_t* acc, const int16_t* w, int16_t ceiling) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i top = _mm_set1_epi16(ceiling);
+  __m128i sum = _mm_setzero_si128();
+  for (int i = 0; i < NNUE::HIDDEN_SIZE; i += 8) {
+    __m128i a = _mm_loadu_si128((const __m128i*) (acc + i));
+    __m128i b = _mm_loadu_si128((const __m128i*) (w + i));
+    a = _mm_min_epi16(_mm_max_epi16(a, zero), top);
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(a, b));
+  }
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(sum);
+}
+#endif
+
+static void addVectorScalar(int16_t* acc, const int16_t* w) {
+  for (int i = 0; i < NNUE::HIDDEN_SIZE; i++) {
+    acc[i] += w[i];
+  }
+}
+
+static void subVectorScalar(int16_t* acc, const int16_t* w) {
+  for (int i = 0; i < NNUE::HIDDEN_SIZE; i++) {
+    acc[i] -= w[i];
+  }
+}
+
+static int32_t dotClippedScalar(const int16_t* acc, const int16_t* w, int16_t ceiling) {
+  int32_t sum = 0;
+  for (int i = 0; i < NNUE::HIDDEN_SIZE; i++) {
+    int16_t a = acc[i];
+    if (a < 0) a = 0;
+    if (a > ceiling) a = ceiling;
+    sum += a * w[i];
+  }
+  return sum;
+}
+
+/**
+ * The kernels of one instruction set.
+ */
+struct Kernels {
+  void (*addVector)(int16_t* acc, const int16_t* w);
+  void (*subVector)(int16_t* acc, const int16_t* w);
+  int32_t (*dotClipped)(const int16_t* acc, const int16_t* w, int16_t ceiling);
+  const char* name;
+};
+
+/**
+ * @return the kernels of the best instruction set available.
+ */
+static Kernels selectKernels() {
+#ifdef RUNTIME_DISPATCH
+  __builtin_cpu_init(); // may run before the constructor that detects the CPU
+  if (__builtin_cpu_supports("avx2")) {
+    Kernels avx2 = {addVectorAVX2, subVectorAVX2, dotClippedAVX2, "AVX2"};
+    return avx2;
+  }
+  if (__builtin_cpu_supports("sse4.1")) {
+    Kernels sse41 = {addVectorSSE41, subVectorSSE41, dotClippedSSE41, "SSE4.1"};
+    return sse41;
+  }
+#elif defined(USE_AVX2)
+  Kernels avx2 = {addVectorAVX2, subVectorAVX2, dotClippedAVX2, "AVX2"};
+  return avx2;
+#elif defined(USE_SSE41)
+  Kernels sse41 = {addVectorSSE41, subVectorSSE41, dotClippedSSE41, "SSE4.1"};
+  return sse41;
+#endif
+  Kernels scalar = {addVectorScalar, subVectorScalar, dotClippedScalar, "scalar"};
+  return scalar;
+}
+
+static const Kernels kernels = selectKernels();
+
+////////////////////////////////////////////////////////////////////////////
+//                              Network
+////////////////////////////////////////////////////////////////////////////
+
+NNUE::NNUE() {
+  outputBias = 0;
+  loaded = false;
+}
+
+bool NNUE::loadFromFile(std::string path) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == NULL) {
+    printf("Unable to open network file %s\n", path.c_str());
+    return false;
+  }
+
+  char magic[4];
+  int32_t hiddenSize;
+  if (fread(magic, 1, 4, file) != 4 || memcmp(magic, "CNN1", 4) != 0
+      || fread(&hiddenSize, sizeof(hiddenSize), 1, file) != 1 || hiddenSize != HIDDEN_SIZE) {
+    printf("Network file %s has wrong format (expected hidden size %i)\n", path.c_str(), HIDDEN_SIZE);
+    fclose(file);
+    return false;
+  }
+
+  featureWeights.resize(NUM_FEATURES * HIDDEN_SIZE);
+  featureBiases.resize(HIDDEN_SIZE);
+  outputWeights.resize(2 * HIDDEN_SIZE);
+  bool ok = fread(&featureWeights[0], sizeof(int16_t), featureWeights.size(), file) == featureWeights.size()
+            && fread(&featureBiases[0], sizeof(int16_t), featureBiases.size(), file) == featureBiases.size()
+            && fread(&outputWeights[0], sizeof(int16_t), outputWeights.size(), file) == outputWeights.size()
+            && fread(&outputBias, sizeof(outputBias), 1, file) == 1;
+  fclose(file);
+  if (!ok) {
+    printf("Network file %s is truncated\n", path.c_str());
+    return false;
+  }
+  loaded = true;
+  return true;
+}
+
+const char* NNUE::getInstructionSet() {
+  return kernels.name;
+}
+
+bool NNUE::isLoaded() {
+  return loaded;
+}
+
+int NNUE::featureIndex(int perspective, int piece, int square) {
+  if (perspective == 0) return piece * 64 + square;
+  // swap colors (black types are 0 -> 5, white types are 6 -> 11) and flip the board
+  return ((piece + 6) % 12) * 64 + (square ^ 56);
+}
+
+void NNUE::resetAccumulator(Accumulator& acc) {
+  memcpy(acc.values[0], &featureBiases[0], sizeof(acc.values[0]));
+  memcpy(acc.values[1], &featureBiases[0], sizeof(acc.values[1]));
+}
+
+void NNUE::addPiece(Accumulator& acc, int piece, int square) {
+  kernels.addVector(acc.values[0], &featureWeights[featureIndex(0, piece, square) * HIDDEN_SIZE]);
+  kernels.addVector(acc.values[1], &featureWeights[featureIndex(1, piece, square) * HIDDEN_SIZE]);
+}
+
+void NNUE::removePiece(Accumulator& acc, int piece, int square) {
+  kernels.subVector(acc.values[0], &featureWeights[featureIndex(0, piece, square) * HIDDEN_SIZE]);
+  kernels.subVector(acc.values[1], &featureWeights[featureIndex(1, piece, square) * HIDDEN_SIZE]);
+}
+
+int NNUE::evaluate(const Accumulator& acc, int color) {
+  // the player to move's hidden layer uses the first half of the output weights
+  int32_t sum = kernels.dotClipped(acc.values[color], &outputWeights[0], QA)
+                + kernels.dotClipped(acc.values[1 - color], &outputWeights[HIDDEN_SIZE], QA);
+  return (int) (((int64_t) sum + outputBias) * SCALE / (QA * QB));
+}
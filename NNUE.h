@@ -0,0 +1,99 @@
+/***********************************************************************//**
+ * An efficiently updatable neural network (NNUE) for board evaluation.
+ * Network: 768 inputs (12 piece types * 64 squares) for each side's perspective,
+ * a hidden layer of HIDDEN_SIZE neurons per perspective (the accumulator),
+ * clipped ReLU, and a single output neuron.
+ * The accumulator is kept by Board and updated whenever a piece is added or removed,
+ * so evaluating only needs the output layer.
+ * Uses AVX2 or SSE4.1 kernels when the CPU supports them (chosen at run time with GCC or Clang on x86,
+ * at compile time with other compilers), otherwise plain loops.
+ ***************************************************************************/
+
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class NNUE {
+  public:
+    NNUE();
+    ~NNUE() {}
+
+    static const int NUM_FEATURES = 768; /**< 12 piece types * 64 squares */
+    static const int HIDDEN_SIZE = 256; /**< Number of hidden neurons per perspective */
+
+    /**
+     * The hidden layer's values for both perspectives.
+     * Index 0 is white's perspective, index 1 is black's perspective.
+     */
+    struct Accumulator {
+      int16_t values[2][HIDDEN_SIZE];
+    };
+
+    /**
+     * Load the network's weights from a file.
+     * File format (little endian):
+     * 4 bytes magic "CNN1", int32 hidden size (must be HIDDEN_SIZE),
+     * int16 feature weights [NUM_FEATURES][HIDDEN_SIZE], int16 feature biases [HIDDEN_SIZE],
+     * int16 output weights [2 * HIDDEN_SIZE] (side to move first), int32 output bias (scaled by QA * QB).
+     * @param path: path to the weight file.
+     * @return true if load successfully.
+     */
+    bool loadFromFile(std::string path);
+
+    /**
+     * @return true if weights have been loaded.
+     */
+    bool isLoaded();
+
+    /**
+     * @return the instruction set of the kernels used by all networks: "AVX2", "SSE4.1" or "scalar".
+     */
+    static const char* getInstructionSet();
+
+    /**
+     * Set the accumulator to the biases (an empty board).
+     */
+    void resetAccumulator(Accumulator& acc);
+
+    /**
+     * Update the accumulator when a piece is put on a square.
+     * @param piece: the piece type according to Board::PieceTypes enum.
+     * @param square: the square number between 0 and 63.
+     */
+    void addPiece(Accumulator& acc, int piece, int square);
+
+    /**
+     * Update the accumulator when a piece is removed from a square.
+     */
+    void removePiece(Accumulator& acc, int piece, int square);
+
+    /**
+     * Evaluate a board from its accumulator.
+     * @param color: the player to move (Board::WHITE or Board::BLACK).
+     * @return the score of the board in centipawns, in the perspective of the player to move.
+     */
+    int evaluate(const Accumulator& acc, int color);
+
+  private:
+    static const int QA = 255; /**< Quantization of the hidden layer, also the clipped ReLU's ceiling */
+    static const int QB = 64; /**< Quantization of the output weights */
+    static const int SCALE = 400; /**< Converts the network's output to centipawns */
+
+    std::vector<int16_t> featureWeights; /**< [NUM_FEATURES][HIDDEN_SIZE] */
+    std::vector<int16_t> featureBiases; /**< [HIDDEN_SIZE] */
+    std::vector<int16_t> outputWeights; /**< [2 * HIDDEN_SIZE] */
+    int32_t outputBias;
+    bool loaded;
+
+    /**
+     * Get the input index of a piece in a perspective.
+     * Black's perspective flips the board vertically and swaps the colors,
+     * so both perspectives see the position as if they were white.
+     */
+    static int featureIndex(int perspective, int piece, int square);
+};
+
+#endif // NNUE_H
@@ -0,0 +1,75 @@
+#include "OffscreenRenderer.h"
+
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_mixer.h>
+#include <stdio.h>
+
+OffscreenRenderer::OffscreenRenderer() {
+  surface = NULL;
+  renderer = NULL;
+  initialized = false;
+}
+
+OffscreenRenderer::~OffscreenRenderer() {
+  quit();
+}
+
+bool OffscreenRenderer::init(int width, int height) {
+  // no window and no sound card: the drivers must be chosen before SDL_Init
+  SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+  SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+  if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) {
+    printf("Failed to initialize SDL. SDL Error: %s\n", SDL_GetError());
+    return false;
+  }
+  initialized = true;
+
+  surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+  if (surface == NULL) {
+    printf("Failed to create a %ix%i surface. SDL error: %s\n", width, height, SDL_GetError());
+    return false;
+  }
+  renderer = SDL_CreateSoftwareRenderer(surface);
+  if (renderer == NULL) {
+    printf("Failed to create software renderer. SDL error: %s\n", SDL_GetError());
+    return false;
+  }
+  SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0xFF, 0xFF); // white, like the game's renderer
+
+  // Init SDL_Image for Image loading
+  if (IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG) == 0) {
+    printf("Failed to initialize SDL_image. SDL_image error: %s\n", IMG_GetError());
+    return false;
+  }
+  // the GUIs load their sounds, on the dummy driver they are never heard
+  if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
+    printf("Failed to initialize SDL_Mixer. SDL_mixer error: %s\n", Mix_GetError());
+  }
+  return true;
+}
+
+SDL_Renderer* OffscreenRenderer::getRenderer() {
+  return renderer;
+}
+
+SDL_Surface* OffscreenRenderer::getSurface() {
+  return surface;
+}
+
+void OffscreenRenderer::quit() {
+  if (renderer != NULL) {
+    SDL_DestroyRenderer(renderer);
+    renderer = NULL;
+  }
+  if (surface != NULL) {
+    SDL_FreeSurface(surface);
+    surface = NULL;
+  }
+  if (initialized) {
+    Mix_CloseAudio();
+    Mix_Quit();
+    IMG_Quit();
+    SDL_Quit();
+    initialized = false;
+  }
+}
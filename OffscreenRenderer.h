@@ -0,0 +1,46 @@
+/***********************************************************************//**
+ * A renderer without a window, for tools and benchmarks that run without a display.
+ * SDL uses its dummy video and audio drivers, and a software renderer draws
+ * into a surface in memory, that can be read back (getSurface).
+ * Sets up SDL, SDL_image and SDL_mixer like the game does, so GUIs can be built on it.
+ ***************************************************************************/
+
+#ifndef OFFSCREENRENDERER_H
+#define OFFSCREENRENDERER_H
+
+#include <SDL2/SDL.h>
+
+class OffscreenRenderer {
+  public:
+    OffscreenRenderer();
+    ~OffscreenRenderer();
+
+    /**
+     * Init SDL without a display, and create the renderer.
+     * @param width, height: the size of the surface to draw on.
+     * @return true if init successfully
+     */
+    bool init(int width, int height);
+
+    /**
+     * @return the software renderer, NULL before init.
+     */
+    SDL_Renderer* getRenderer();
+
+    /**
+     * @return the surface holding the drawn pixels, NULL before init.
+     */
+    SDL_Surface* getSurface();
+
+    /**
+     * Destroy the renderer and quit SDL.
+     */
+    void quit();
+
+  private:
+    SDL_Surface* surface;
+    SDL_Renderer* renderer;
+    bool initialized; /**< SDL was initialized by init */
+};
+
+#endif // OFFSCREENRENDERER_H
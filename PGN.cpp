@@ -0,0 +1,483 @@
+#include "PGN.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+// result tokens, by result + 1 (unknown, white wins, black wins, draw)
+static const char* const RESULT_TEXTS[] = {"*", "1-0", "0-1", "1/2-1/2"};
+
+static const char* resultText(int result) {
+  return RESULT_TEXTS[(result >= Board::WHITE && result <= Board::BOTH_COLOR)? result + 1 : 0];
+}
+
+/**
+ * @return the result of a result token (see PGNGame::result), -2 if the token is not a result.
+ */
+static int parseResult(const char* token, int length) {
+  for (int i = 0; i < 4; i++) {
+    if (strlen(RESULT_TEXTS[i]) == length && strncmp(token, RESULT_TEXTS[i], length) == 0) return i - 1;
+  }
+  return -2;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                                 Games
+////////////////////////////////////////////////////////////////////////////
+
+void PGNGame::clear() {
+  numTags = 0;
+  fen.clear();
+  moves.clear();
+  result = -1;
+  valid = true;
+  error.clear();
+  offset = 0;
+}
+
+/**
+ * Add an empty tag to a game, reusing the strings of a previous game.
+ * @return the index of the tag.
+ */
+static int addTag(PGNGame& game) {
+  if (game.numTags == game.tagNames.size()) {
+    game.tagNames.push_back(std::string());
+    game.tagValues.push_back(std::string());
+  }
+  game.tagNames[game.numTags].clear();
+  game.tagValues[game.numTags].clear();
+  return game.numTags++;
+}
+
+void PGNGame::setTag(const char* name, const char* value) {
+  int tag = 0;
+  while (tag < numTags && tagNames[tag] != name) tag++;
+  if (tag == numTags) addTag(*this);
+  tagNames[tag] = name;
+  tagValues[tag] = value;
+  if (strcmp(name, "FEN") == 0) fen = value;
+}
+
+const char* PGNGame::getTag(const char* name) const {
+  for (int tag = 0; tag < numTags; tag++) {
+    if (tagNames[tag] == name) return tagValues[tag].c_str();
+  }
+  return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                                Reading
+////////////////////////////////////////////////////////////////////////////
+
+PGNReader::PGNReader(int numThreads, int chunkSize) {
+  this->numThreads = (numThreads > 0)? numThreads : std::thread::hardware_concurrency();
+  if (this->numThreads < 1) this->numThreads = 1;
+  this->chunkSize = (chunkSize > 0)? chunkSize : DEFAULT_CHUNK_SIZE;
+  numGames = 0;
+  numInvalidGames = 0;
+  numMoves = 0;
+  numBytes = 0;
+  numPrintedErrors = 0;
+  endOfFile = false;
+}
+
+bool PGNReader::read(std::string path, PGNListener* listener) {
+  numGames = 0;
+  numInvalidGames = 0;
+  numMoves = 0;
+  numBytes = 0;
+  numPrintedErrors = 0;
+
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == NULL) {
+    printf("Unable to open PGN file %s\n", path.c_str());
+    return false;
+  }
+
+  std::vector<Worker> workers(numThreads);
+  for (int t = 0; t < numThreads; t++) {
+    workers[t].numGames = 0;
+    workers[t].numInvalidGames = 0;
+    workers[t].numMoves = 0;
+  }
+  std::vector<char> carry;
+  long long fileOffset = 0;
+
+  if (numThreads == 1) {
+    Chunk chunk;
+    while (fillChunk(file, chunk, carry, fileOffset)) {
+      parseChunk(chunk, workers[0], 0, listener);
+    }
+  } else {
+    // two chunks per worker: one being parsed, one read ahead
+    chunks.assign(2 * numThreads, Chunk());
+    fullChunks.clear();
+    freeChunks.clear();
+    for (int i = 0; i < chunks.size(); i++) freeChunks.push_back(&chunks[i]);
+    endOfFile = false;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+      threads.push_back(std::thread(&PGNReader::parseChunks, this, &workers[t], t, listener));
+    }
+    while (true) {
+      Chunk* chunk;
+      {
+        std::unique_lock<std::mutex> lock(chunkMutex);
+        chunkFreed.wait(lock, [this]() { return !freeChunks.empty(); });
+        chunk = freeChunks.front();
+        freeChunks.pop_front();
+      }
+      bool filled = fillChunk(file, *chunk, carry, fileOffset);
+      {
+        std::lock_guard<std::mutex> lock(chunkMutex);
+        if (filled) {
+          fullChunks.push_back(chunk);
+        } else {
+          freeChunks.push_back(chunk);
+          endOfFile = true;
+        }
+      }
+      chunkFilled.notify_all();
+      if (!filled) break;
+    }
+    for (int t = 0; t < numThreads; t++) {
+      threads[t].join();
+    }
+    std::vector<Chunk>().swap(chunks);
+  }
+
+  bool success = !ferror(file);
+  if (!success) printf("Error while reading PGN file %s\n", path.c_str());
+  fclose(file);
+
+  for (int t = 0; t < numThreads; t++) {
+    numGames += workers[t].numGames;
+    numInvalidGames += workers[t].numInvalidGames;
+    numMoves += workers[t].numMoves;
+  }
+  numBytes = fileOffset;
+  return success;
+}
+
+bool PGNReader::fillChunk(FILE* file, Chunk& chunk, std::vector<char>& carry, long long& fileOffset) {
+  // the chunk starts with the end of the previous chunk
+  if (chunk.data.size() < carry.size() + chunkSize) chunk.data.resize(carry.size() + chunkSize);
+  if (!carry.empty()) memcpy(&chunk.data[0], &carry[0], carry.size());
+  chunk.size = carry.size();
+  chunk.offset = fileOffset - carry.size();
+  carry.clear();
+
+  while (true) {
+    size_t numRead = fread(&chunk.data[chunk.size], 1, chunk.data.size() - chunk.size, file);
+    chunk.size += numRead;
+    fileOffset += numRead;
+    // end of the file: the last game is complete
+    if (chunk.size < chunk.data.size()) return chunk.size > 0;
+
+    size_t cut = findLastGameStart(&chunk.data[0], chunk.size);
+    if (cut > 0) {
+      carry.assign(chunk.data.begin() + cut, chunk.data.begin() + chunk.size);
+      chunk.size = cut;
+      return true;
+    }
+    // a game longer than the chunk
+    chunk.data.resize(2 * chunk.data.size());
+  }
+}
+
+size_t PGNReader::findLastGameStart(const char* data, size_t size) {
+  // a game starts with a tag at the beginning of a line, after a line that is not a tag (its previous game's moves)
+  for (size_t i = size - 1; i > 0; i--) {
+    if (data[i] != '[' || data[i-1] != '\n') continue;
+    size_t j = i - 1;
+    while (j > 0 && isspace((unsigned char) data[j])) j--;
+    size_t lineStart = j;
+    while (lineStart > 0 && data[lineStart-1] != '\n') lineStart--;
+    if (j > 0 && data[lineStart] != '[') return i;
+  }
+  return 0;
+}
+
+void PGNReader::parseChunks(Worker* worker, int thread, PGNListener* listener) {
+  while (true) {
+    Chunk* chunk;
+    {
+      std::unique_lock<std::mutex> lock(chunkMutex);
+      chunkFilled.wait(lock, [this]() { return !fullChunks.empty() || endOfFile; });
+      if (fullChunks.empty()) return;
+      chunk = fullChunks.front();
+      fullChunks.pop_front();
+    }
+    parseChunk(*chunk, *worker, thread, listener);
+    {
+      std::lock_guard<std::mutex> lock(chunkMutex);
+      freeChunks.push_back(chunk);
+    }
+    chunkFreed.notify_one();
+  }
+}
+
+void PGNReader::parseChunk(const Chunk& chunk, Worker& worker, int thread, PGNListener* listener) {
+  const char* begin = &chunk.data[0];
+  const char* text = begin;
+  const char* end = begin + chunk.size;
+  PGNGame& game = worker.game;
+  while (true) {
+    long long offset = chunk.offset + (text - begin);
+    if (!parseGame(text, end, game, worker.board)) break;
+    game.offset += offset;
+    worker.numGames++;
+    worker.numMoves += game.moves.size();
+    if (!game.valid) {
+      worker.numInvalidGames++;
+      std::lock_guard<std::mutex> lock(printMutex);
+      if (numPrintedErrors < MAX_PRINTED_ERRORS) {
+        printf("Game at byte %lld: %s\n", game.offset, game.error.c_str());
+      } else if (numPrintedErrors == MAX_PRINTED_ERRORS) {
+        printf("More invalid games, only counting them\n");
+      }
+      numPrintedErrors++;
+    }
+    listener->onGame(game, thread);
+  }
+}
+
+bool PGNReader::parseGame(const char*& text, const char* end, PGNGame& game, Board& b) {
+  game.clear();
+  const char* p = text;
+  bool lineStart = true;
+
+  // skip what is before the first tag: blank lines, a byte order mark, escaped lines ("%...")
+  while (p < end && *p != '[') {
+    if (*p == '%' && lineStart) {
+      while (p < end && *p != '\n') p++;
+    } else if (isspace((unsigned char) *p) || (unsigned char) *p >= 0x80) {
+      lineStart = (*p == '\n');
+      p++;
+    } else {
+      break; // a game without tags
+    }
+  }
+  if (p == end) {
+    text = end;
+    return false;
+  }
+  game.offset = p - text;
+
+  // tag pairs: [Name "value"]
+  while (p < end && *p == '[') {
+    p++;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    int tag = addTag(game);
+    std::string& name = game.tagNames[tag];
+    std::string& value = game.tagValues[tag];
+    while (p < end && !isspace((unsigned char) *p) && *p != '"' && *p != ']') name += *p++;
+    while (p < end && *p != '"' && *p != ']' && *p != '\n') p++;
+    if (p < end && *p == '"') {
+      p++;
+      while (p < end && *p != '"' && *p != '\n') {
+        if (*p == '\\' && p + 1 < end) p++;
+        value += *p++;
+      }
+    }
+    while (p < end && *p != '\n') p++;
+    while (p < end && isspace((unsigned char) *p)) p++;
+    if (name == "FEN") game.fen = value;
+  }
+
+  if (game.fen.empty()) {
+    b.initBoard();
+  } else if (!b.loadFEN(game.fen)) {
+    game.valid = false;
+    game.error = "invalid FEN " + game.fen;
+  }
+
+  // movetext
+  bool resultFound = false;
+  int variationDepth = 0;
+  lineStart = true;
+  while (p < end) {
+    char c = *p;
+    if (isspace((unsigned char) c)) {
+      lineStart = (c == '\n');
+      p++;
+      continue;
+    }
+    // a tag at the beginning of a line: the next game (this one has no result)
+    bool atLineStart = lineStart;
+    lineStart = false;
+    if (c == '[' && atLineStart) break;
+
+    if (c == '{') { // comment
+      while (p < end && *p != '}') p++;
+      if (p < end) p++;
+      continue;
+    }
+    if (c == ';' || (c == '%' && atLineStart)) { // comment or escaped line
+      while (p < end && *p != '\n') p++;
+      continue;
+    }
+    if (c == '(' || c == ')') { // variations are skipped
+      variationDepth += (c == '(')? 1 : -1;
+      if (variationDepth < 0) variationDepth = 0;
+      p++;
+      continue;
+    }
+    if (c == '$') { // numeric annotation glyph
+      p++;
+      while (p < end && isdigit((unsigned char) *p)) p++;
+      continue;
+    }
+
+    const char* token = p;
+    while (p < end && !isspace((unsigned char) *p) && strchr("{}();[]$", *p) == NULL) p++;
+    if (p == token) { // a lone ']' or '['
+      p++;
+      continue;
+    }
+    if (variationDepth > 0) continue;
+
+    int result = parseResult(token, p - token);
+    if (result != -2) {
+      game.result = result;
+      resultFound = true;
+      break;
+    }
+
+    // move number ("12." or "12..."), possibly followed by the move ("12.e4")
+    const char* move = token;
+    while (move < p && isdigit((unsigned char) *move)) move++;
+    if (move == p) continue;
+    if (*move == '.') {
+      while (move < p && *move == '.') move++;
+      if (move == p) continue;
+    } else {
+      move = token; // castling with zeros ("0-0")
+    }
+    // a separate annotation ("e4 !?")
+    const char* annotation = move;
+    while (annotation < p && (*annotation == '!' || *annotation == '?')) annotation++;
+    if (annotation == p) continue;
+
+    if (!game.valid) continue;
+    int moveIndex = b.findMoveSAN(move, p - move);
+    if (moveIndex == -1) {
+      game.valid = false;
+      char ply[32];
+      sprintf(ply, " at ply %i", (int) game.moves.size() + 1);
+      game.error = "illegal move ";
+      game.error.append(move, p - move);
+      game.error += ply;
+      continue;
+    }
+    b.makeMove(moveIndex);
+    game.moves.push_back(moveIndex);
+  }
+
+  // a game cut before its result token keeps its Result tag
+  if (!resultFound) {
+    const char* tag = game.getTag("Result");
+    if (tag != NULL) {
+      int result = parseResult(tag, strlen(tag));
+      if (result != -2) game.result = result;
+    }
+  }
+  text = p;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                                Writing
+////////////////////////////////////////////////////////////////////////////
+
+static const int NUM_ROSTER_TAGS = 7;
+static const char* const ROSTER_TAGS[NUM_ROSTER_TAGS] = {"Event", "Site", "Date", "Round", "White", "Black", "Result"};
+static const char* const ROSTER_DEFAULTS[NUM_ROSTER_TAGS] = {"?", "?", "????.??.??", "?", "?", "?", "*"};
+
+static void appendTag(std::string& text, const char* name, const char* value) {
+  text += '[';
+  text += name;
+  text += " \"";
+  for (const char* c = value; *c != '\0'; c++) {
+    if (*c == '"' || *c == '\\') text += '\\';
+    text += *c;
+  }
+  text += "\"]\n";
+}
+
+bool PGNWriter::format(const PGNGame& game, std::string& text) {
+  text.clear();
+
+  // the seven tag roster, then the other tags
+  for (int i = 0; i < NUM_ROSTER_TAGS; i++) {
+    const char* value = game.getTag(ROSTER_TAGS[i]);
+    if (i == NUM_ROSTER_TAGS - 1) value = resultText(game.result);
+    appendTag(text, ROSTER_TAGS[i], (value != NULL)? value : ROSTER_DEFAULTS[i]);
+  }
+  bool hasSetUp = false;
+  for (int tag = 0; tag < game.numTags; tag++) {
+    bool roster = false;
+    for (int i = 0; i < NUM_ROSTER_TAGS; i++) {
+      if (game.tagNames[tag] == ROSTER_TAGS[i]) roster = true;
+    }
+    if (game.tagNames[tag] == "SetUp") hasSetUp = true;
+    if (!roster) appendTag(text, game.tagNames[tag].c_str(), game.tagValues[tag].c_str());
+  }
+  if (!game.fen.empty()) {
+    if (game.getTag("FEN") == NULL) appendTag(text, "FEN", game.fen.c_str());
+    if (!hasSetUp) appendTag(text, "SetUp", "1");
+  }
+  text += '\n';
+
+  // moves, numbered from the FEN's fullmove number
+  bool success = true;
+  int moveNumber = 1;
+  if (game.fen.empty()) {
+    board.initBoard();
+  } else {
+    success = board.loadFEN(game.fen);
+    const char* lastField = strrchr(game.fen.c_str(), ' ');
+    if (lastField != NULL && atoi(lastField + 1) > 0) moveNumber = atoi(lastField + 1);
+  }
+  line.clear();
+  char word[Board::SAN_BUFFER_SIZE + 16];
+  for (int i = 0; success && i < game.moves.size(); i++) {
+    int move = game.moves[i];
+    if (move < 0 || move >= board.getNumMoves()) {
+      success = false;
+      break;
+    }
+    if (board.getPlayer() == Board::WHITE) {
+      sprintf(word, "%i.", moveNumber);
+      appendWord(text, word);
+    } else if (i == 0) {
+      sprintf(word, "%i...", moveNumber);
+      appendWord(text, word);
+    }
+    board.writeMoveSAN(move, word);
+    appendWord(text, word);
+    if (board.getPlayer() == Board::BLACK) moveNumber++;
+    board.makeMove(move);
+  }
+  appendWord(text, resultText(game.result));
+  text += line;
+  text += "\n\n";
+  return success;
+}
+
+bool PGNWriter::write(const PGNGame& game, FILE* file) {
+  bool success = format(game, buffer);
+  return fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size() && success;
+}
+
+void PGNWriter::appendWord(std::string& text, const char* word) {
+  int length = strlen(word);
+  if (!line.empty() && line.size() + 1 + length > LINE_LENGTH) {
+    text += line;
+    text += '\n';
+    line.clear();
+  }
+  if (!line.empty()) line += ' ';
+  line += word;
+}
@@ -0,0 +1,211 @@
+/***********************************************************************//**
+ * Reads and writes games in Portable Game Notation (PGN).
+ * Moves are decoded and encoded in SAN with Board's move generator,
+ * so a game is only accepted if all its moves are legal.
+ *
+ * PGNReader streams a file of any size: it is read in chunks of about 1 MB,
+ * cut between two games, and the chunks are parsed by worker threads while
+ * the next ones are read. The chunk buffers and each worker's Board and PGNGame
+ * are reused from game to game, so reading a game does not allocate
+ * (once the buffers have grown to the largest game and tag seen).
+ ***************************************************************************/
+
+#ifndef PGN_H
+#define PGN_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Board.h"
+
+/**
+ * A game read from (or to be written to) a PGN file.
+ * The reader reuses the same PGNGame for all the games of a thread:
+ * strings and vectors keep their capacity, and only the first numTags tags are valid.
+ */
+struct PGNGame {
+  std::vector<std::string> tagNames;
+  std::vector<std::string> tagValues;
+  int numTags; /**< The number of valid tags in tagNames and tagValues */
+  std::string fen; /**< The value of the FEN tag, empty for the standard starting position */
+  std::vector<int> moves; /**< Move numbers, each in the move list of the board after the previous moves */
+  int result; /**< Board::WHITE, Board::BLACK, Board::BOTH_COLOR (draw), or -1 if unknown ("*") */
+  bool valid; /**< False if a move is illegal, or the FEN is invalid. moves then stops before the error */
+  std::string error; /**< Why the game is invalid, empty if it is valid */
+  long long offset; /**< Position of the game in the file, in bytes */
+
+  PGNGame() { clear(); }
+
+  /**
+   * Remove the tags and moves (keeping the memory).
+   */
+  void clear();
+
+  /**
+   * Set a tag, or add it if the game doesn't have it.
+   * The FEN tag also sets fen.
+   */
+  void setTag(const char* name, const char* value);
+
+  /**
+   * @return the value of a tag, NULL if the game doesn't have it.
+   */
+  const char* getTag(const char* name) const;
+};
+
+class PGNListener {
+  public:
+    virtual ~PGNListener() {}
+
+    /**
+     * Called for each game read (including invalid games), by the thread that parsed it.
+     * Different threads call it at the same time, and the order of the games is
+     * only kept with a single thread.
+     * @param game: only valid during the call.
+     * @param thread: the calling thread's number, from 0 to numThreads - 1 (for data kept per thread).
+     */
+    virtual void onGame(const PGNGame& game, int thread) = 0;
+};
+
+class PGNReader {
+  public:
+    static const int DEFAULT_CHUNK_SIZE = 1 << 20;
+    static const int MAX_PRINTED_ERRORS = 10; /**< Errors after these are only counted */
+
+    /**
+     * @param numThreads: the number of parsing threads. 0 to use all cores.
+     * With 1 thread, games are parsed by the calling thread, in the order of the file.
+     * @param chunkSize: the number of bytes read at a time. A chunk grows if a game doesn't fit.
+     */
+    PGNReader(int numThreads = 0, int chunkSize = DEFAULT_CHUNK_SIZE);
+    ~PGNReader() {}
+
+    /**
+     * Read all the games of a file, and give each one to the listener.
+     * Returns after the last game was given.
+     * @param path: path to the PGN file.
+     * @param listener: receives the games.
+     * @return false if the file can't be read.
+     */
+    bool read(std::string path, PGNListener* listener);
+
+    /**
+     * Parse the next game of a text.
+     * @param text: the text, moved to the end of the game.
+     * @param end: the end of the text.
+     * @param game: receives the game (its offset is the number of bytes before text).
+     * @param b: the board used to decode the moves, ends at the game's last valid position.
+     * @return false if there is no game before end.
+     */
+    static bool parseGame(const char*& text, const char* end, PGNGame& game, Board& b);
+
+    int getNumThreads() { return numThreads; }
+
+    /**
+     * Statistics of the last read.
+     */
+    long long getNumGames() { return numGames; }
+    long long getNumInvalidGames() { return numInvalidGames; }
+    long long getNumMoves() { return numMoves; }
+    long long getNumBytes() { return numBytes; }
+
+  private:
+    /**
+     * A part of the file with complete games only.
+     */
+    struct Chunk {
+      std::vector<char> data;
+      size_t size; /**< Bytes of data used */
+      long long offset; /**< Position of data[0] in the file */
+    };
+
+    /**
+     * What a parsing thread keeps from game to game.
+     */
+    struct Worker {
+      Board board;
+      PGNGame game;
+      long long numGames, numInvalidGames, numMoves;
+    };
+
+    int numThreads;
+    int chunkSize;
+    long long numGames, numInvalidGames, numMoves, numBytes;
+    int numPrintedErrors;
+    std::mutex printMutex;
+
+    /////////////////////////////////////////////////////////////////////////////
+    //  Chunks passed from the reading thread to the workers
+    /////////////////////////////////////////////////////////////////////////////
+    std::vector<Chunk> chunks;
+    std::mutex chunkMutex; /**< Protects fullChunks, freeChunks and endOfFile */
+    std::condition_variable chunkFilled; /**< Signaled when a chunk is read, or at the end of the file */
+    std::condition_variable chunkFreed; /**< Signaled when a worker is done with a chunk */
+    std::deque<Chunk*> fullChunks; /**< Read and not parsed yet, the oldest first */
+    std::deque<Chunk*> freeChunks;
+    bool endOfFile;
+
+    /**
+     * Read the next games of the file into a chunk. The end of the last game read,
+     * if it was cut, is moved to the beginning of the next chunk.
+     * @param carry: the beginning of a cut game, from the previous chunk. Replaced by the end of this chunk.
+     * @return false if the file has no more games.
+     */
+    bool fillChunk(FILE* file, Chunk& chunk, std::vector<char>& carry, long long& fileOffset);
+
+    /**
+     * Worker loop: parse the chunks read, until the end of the file.
+     */
+    void parseChunks(Worker* worker, int thread, PGNListener* listener);
+
+    /**
+     * Parse all the games of a chunk.
+     */
+    void parseChunk(const Chunk& chunk, Worker& worker, int thread, PGNListener* listener);
+
+    /**
+     * @return the position of the last game starting after data[0], 0 if there is none.
+     */
+    static size_t findLastGameStart(const char* data, size_t size);
+};
+
+class PGNWriter {
+  public:
+    static const int LINE_LENGTH = 79; /**< Movetext lines are wrapped before this length */
+
+    PGNWriter() {}
+    ~PGNWriter() {}
+
+    /**
+     * Write a game in PGN export format: the seven tag roster first ("?" for the missing tags),
+     * then the other tags, then the moves in SAN with move numbers, and the result.
+     * @param game: the game. Its moves are replayed from its FEN (or the starting position).
+     * @param text: receives the game (replaced, keeping its memory), with an empty line after it.
+     * @return false if a move of the game doesn't exist (the moves before it are written).
+     */
+    bool format(const PGNGame& game, std::string& text);
+
+    /**
+     * Write a game at the end of a file (see format).
+     * @return false if a move doesn't exist or the file can't be written.
+     */
+    bool write(const PGNGame& game, FILE* file);
+
+  private:
+    Board board; /**< Replays the moves to encode them */
+    std::string line; /**< The movetext line being filled */
+    std::string buffer; /**< The text of the game written by write */
+
+    /**
+     * Add a word to the movetext line, moving the line to text first if the word doesn't fit.
+     */
+    void appendWord(std::string& text, const char* word);
+};
+
+#endif // PGN_H
@@ -0,0 +1,140 @@
+#include <stdio.h>
+
+#include "PawnHashTable.h"
+
+const int PawnHashTable::PASSED_PAWN_BONUS[8] = {0, 10, 15, 25, 40, 65, 100, 0};
+const int PawnHashTable::DOUBLED_PAWN_PENALTY = 15;
+const int PawnHashTable::ISOLATED_PAWN_PENALTY = 12;
+const int PawnHashTable::BACKWARD_PAWN_PENALTY = 8;
+
+PawnHashTable::PawnHashTable(int numEntries) {
+  // round down to a power of 2 so that a key can be masked into an index
+  int size = 1;
+  while (size * 2 <= numEntries) size *= 2;
+  entries.resize(size);
+  mask = size - 1;
+  clear();
+}
+
+void PawnHashTable::clear() {
+  for (int i = 0; i < entries.size(); i++) {
+    entries[i].key = 0;
+    entries[i].score = 0; // a board without pawns has key 0 and score 0
+  }
+  numProbes = 0;
+  numHits = 0;
+}
+
+int PawnHashTable::probe(Board* b) {
+  numProbes++;
+  uint64_t key = b->getPawnKey();
+  Entry& entry = entries[key & mask];
+  if (entry.key == key) {
+    numHits++;
+    return entry.score;
+  }
+  entry.key = key;
+  entry.score = evaluate(b);
+  return entry.score;
+}
+
+int PawnHashTable::evaluate(Board* b) {
+  // Collect the pawns of each file:
+  // the number of pawns, and the lowest and highest row they stand on
+  int count[2][Board::COLS];
+  int minRow[2][Board::COLS];
+  int maxRow[2][Board::COLS];
+  for (int color = Board::WHITE; color <= Board::BLACK; color++) {
+    for (int c = 0; c < Board::COLS; c++) {
+      count[color][c] = 0;
+      minRow[color][c] = Board::ROWS;
+      maxRow[color][c] = -1;
+    }
+  }
+  for (int s = 0; s < Board::NUM_SQUARES; s++) {
+    int piece = b->getPiece(s);
+    if (piece != Board::WP && piece != Board::BP) continue;
+    int color = (piece == Board::WP)? Board::WHITE : Board::BLACK;
+    int r = s / Board::COLS;
+    int c = s % Board::COLS;
+    count[color][c]++;
+    if (r < minRow[color][c]) minRow[color][c] = r;
+    if (r > maxRow[color][c]) maxRow[color][c] = r;
+  }
+
+  int score = 0; // the score of the pawn structure for white
+  for (int s = 0; s < Board::NUM_SQUARES; s++) {
+    int piece = b->getPiece(s);
+    if (piece != Board::WP && piece != Board::BP) continue;
+    int r = s / Board::COLS;
+    int c = s % Board::COLS;
+    int pawnScore = 0; // the score of this pawn for its owner
+
+    if (piece == Board::WP) {
+      // passed: no black pawn ahead on the same or adjacent files
+      bool passed = true;
+      for (int f = c - 1; f <= c + 1; f++) {
+        if (f >= 0 && f < Board::COLS && maxRow[Board::BLACK][f] > r) passed = false;
+      }
+      if (passed) pawnScore += PASSED_PAWN_BONUS[r];
+
+      bool hasLeft = (c > 0) && count[Board::WHITE][c-1];
+      bool hasRight = (c < Board::COLS - 1) && count[Board::WHITE][c+1];
+      if (!hasLeft && !hasRight) {
+        pawnScore -= ISOLATED_PAWN_PENALTY;
+      } else if ((!hasLeft || minRow[Board::WHITE][c-1] > r) && (!hasRight || minRow[Board::WHITE][c+1] > r)) {
+        // backward: all neighbours are ahead, and the square in front is attacked by a black pawn
+        if (r + 2 < Board::ROWS
+            && ((c > 0 && b->getPiece((r+2) * Board::COLS + c-1) == Board::BP)
+                || (c < Board::COLS - 1 && b->getPiece((r+2) * Board::COLS + c+1) == Board::BP))) {
+          pawnScore -= BACKWARD_PAWN_PENALTY;
+        }
+      }
+      score += pawnScore;
+    } else {
+      // passed: no white pawn ahead (lower rows) on the same or adjacent files
+      bool passed = true;
+      for (int f = c - 1; f <= c + 1; f++) {
+        if (f >= 0 && f < Board::COLS && minRow[Board::WHITE][f] < r) passed = false;
+      }
+      if (passed) pawnScore += PASSED_PAWN_BONUS[Board::ROWS - 1 - r];
+
+      bool hasLeft = (c > 0) && count[Board::BLACK][c-1];
+      bool hasRight = (c < Board::COLS - 1) && count[Board::BLACK][c+1];
+      if (!hasLeft && !hasRight) {
+        pawnScore -= ISOLATED_PAWN_PENALTY;
+      } else if ((!hasLeft || maxRow[Board::BLACK][c-1] < r) && (!hasRight || maxRow[Board::BLACK][c+1] < r)) {
+        if (r - 2 >= 0
+            && ((c > 0 && b->getPiece((r-2) * Board::COLS + c-1) == Board::WP)
+                || (c < Board::COLS - 1 && b->getPiece((r-2) * Board::COLS + c+1) == Board::WP))) {
+          pawnScore -= BACKWARD_PAWN_PENALTY;
+        }
+      }
+      score -= pawnScore;
+    }
+  }
+
+  // doubled pawns
+  for (int c = 0; c < Board::COLS; c++) {
+    if (count[Board::WHITE][c] > 1) score -= (count[Board::WHITE][c] - 1) * DOUBLED_PAWN_PENALTY;
+    if (count[Board::BLACK][c] > 1) score += (count[Board::BLACK][c] - 1) * DOUBLED_PAWN_PENALTY;
+  }
+  return score;
+}
+
+long long PawnHashTable::getNumProbes() {
+  return numProbes;
+}
+
+long long PawnHashTable::getNumHits() {
+  return numHits;
+}
+
+double PawnHashTable::getHitRate() {
+  if (numProbes == 0) return 0;
+  return (double) numHits / numProbes;
+}
+
+void PawnHashTable::printStats() {
+  printf("Pawn hash: %lld probes, %lld hits (%.1f%%)\n", numProbes, numHits, 100 * getHitRate());
+}
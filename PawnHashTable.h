@@ -0,0 +1,88 @@
+/***********************************************************************//**
+ * Pawn structure evaluation, cached in a hash table.
+ * Evaluates passed, doubled, isolated and backward pawns.
+ * Pawn structure changes rarely during search, so the score is stored
+ * under the board's pawn-only Zobrist key and reused on later probes.
+ ***************************************************************************/
+
+#ifndef PAWNHASHTABLE_H
+#define PAWNHASHTABLE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "Board.h"
+
+class PawnHashTable {
+  public:
+    /**
+     * @param numEntries: the number of entries in the table. Rounded down to a power of 2.
+     */
+    PawnHashTable(int numEntries = DEFAULT_NUM_ENTRIES);
+    ~PawnHashTable() {}
+
+    static const int DEFAULT_NUM_ENTRIES = 16384; /**< 16384 entries * 16 bytes = 256 KB */
+
+    /**
+     * Get the pawn structure score of a board, from the table if possible.
+     * @param b: the board to evaluate.
+     * @return the score of the pawn structure (in white's perspective).
+     */
+    int probe(Board* b);
+
+    /**
+     * Evaluate the pawn structure of a board without using the table.
+     * @param b: the board to evaluate.
+     * @return the score of the pawn structure (in white's perspective).
+     */
+    static int evaluate(Board* b);
+
+    /**
+     * Empty the table and reset the statistics.
+     */
+    void clear();
+
+    /***************************************************************************
+     *                               Statistics
+     ***************************************************************************/
+
+    long long getNumProbes(); /**< Number of calls to probe since the last clear */
+    long long getNumHits(); /**< Number of probes answered from the table */
+    /**
+     * @return the fraction of probes answered from the table (0 -> 1).
+     */
+    double getHitRate();
+    /**
+     * Print the number of probes, hits and the hit rate to console.
+     */
+    void printStats();
+
+  private:
+    /**
+     * One cached pawn structure.
+     */
+    struct Entry {
+      uint64_t key; /**< The pawn key of the board. 0 if the entry is empty. */
+      int score; /**< Pawn structure score in white's perspective */
+    };
+
+    std::vector<Entry> entries;
+    uint64_t mask; /**< entries.size() - 1, used to index the table with a key */
+
+    long long numProbes;
+    long long numHits;
+
+    /***************************************************************************
+     *                      Values used in pawn evaluation
+     ***************************************************************************/
+
+    /**
+     * Bonus of a passed pawn, indexed by how far the pawn has advanced (0 -> 7).
+     */
+    static const int PASSED_PAWN_BONUS[Board::ROWS];
+    static const int DOUBLED_PAWN_PENALTY; /**< Penalty for each extra pawn on a file */
+    static const int ISOLATED_PAWN_PENALTY; /**< Penalty for a pawn without friendly pawns on adjacent files */
+    static const int BACKWARD_PAWN_PENALTY; /**< Penalty for a pawn that is behind its neighbours and cannot safely advance */
+};
+
+#endif // PAWNHASHTABLE_H
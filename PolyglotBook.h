@@ -0,0 +1,212 @@
+/***********************************************************************//**
+ * Opening books in the Polyglot format, read by most chess programs.
+ *
+ * A book is a list of 16-byte entries (key, move, weight, learn) in big endian order,
+ * sorted by key. The key of a position is Polyglot's own Zobrist key, made from
+ * the 781 random numbers ("Random64") published with the format, and checked
+ * against the keys of the specification's test positions (checkKeys).
+ *
+ * PolyglotBookBuilder makes a book from PGN files. The games are replayed with
+ * Board's moves, and the number of games, wins and draws of each (position, move)
+ * are counted in hash tables split into shards, each locked separately so that the
+ * reading threads rarely wait for each other. A shard has a fixed size: when it is
+ * full, its counts are sorted and written to a temporary run file, and the runs of
+ * each shard are merged into the book at the end. The memory used is bounded
+ * whatever the number of positions.
+ ***************************************************************************/
+
+#ifndef POLYGLOTBOOK_H
+#define POLYGLOTBOOK_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Board.h"
+#include "MappedFile.h"
+#include "PGN.h"
+
+class PolyglotBook {
+  public:
+    /**
+     * A book move, in the machine's byte order (the file is big endian).
+     */
+    struct Entry {
+      uint64_t key; /**< Polyglot key of the position */
+      uint16_t move; /**< See encodeMove */
+      uint16_t weight; /**< How often the move should be played, relative to the other moves of the position */
+      uint32_t learn; /**< 0 */
+    };
+
+    static const int ENTRY_SIZE = 16; /**< The size of an entry in the file */
+    static const int NUM_KEYS = 781;
+
+    PolyglotBook() { entries = NULL; numEntries = 0; }
+    ~PolyglotBook() {}
+
+    /**
+     * Check getKey against the keys of the test positions of Polyglot's specification
+     * (the starting position, and positions with castling rights lost and en passant squares).
+     * @return false if a key is wrong (printed): the books made would not be Polyglot's.
+     */
+    static bool checkKeys();
+
+    /**
+     * @return the Polyglot key of the board's position.
+     */
+    static uint64_t getKey(Board& b);
+
+    /**
+     * Encode a move as Polyglot does: ending file (bits 0 -> 2) and row (bits 3 -> 5),
+     * starting file (bits 6 -> 8) and row (bits 9 -> 11),
+     * promotion (bits 12 -> 14: 0 for none, then knight, bishop, rook, queen).
+     * Castling is the king capturing its own rook (e.g. e1h1).
+     * @param moveIndex: the move number in b's move list.
+     */
+    static uint16_t encodeMove(Board& b, int moveIndex);
+
+    /**
+     * @return the move number of an encoded move in b's move list, -1 if b has no such move.
+     */
+    static int decodeMove(Board& b, uint16_t move);
+
+    /**
+     * Open a book file (closing the previous one).
+     * @return false if the file can't be mapped or its size is not a number of entries.
+     */
+    bool open(std::string path);
+
+    void close();
+
+    /**
+     * Find the book moves of a position.
+     * @param moves: receives the moves of the position, in the order of the book (the greatest weight first).
+     * @return the number of moves, 0 if the book doesn't have the position.
+     */
+    int find(uint64_t key, std::vector<Entry>& moves);
+
+    uint64_t getNumEntries() { return numEntries; }
+
+    /**
+     * Write an entry in the book's big endian order.
+     * @param data: ENTRY_SIZE bytes.
+     */
+    static void writeEntry(const Entry& entry, unsigned char* data);
+
+    /**
+     * Read an entry in the book's big endian order.
+     */
+    static void readEntry(const unsigned char* data, Entry& entry);
+
+  private:
+    MappedFile file;
+    const unsigned char* entries; /**< In the mapped file */
+    uint64_t numEntries;
+};
+
+class PolyglotBookBuilder : public PGNListener {
+  public:
+    static const int DEFAULT_MAX_PLY = 30;
+    static const int DEFAULT_MIN_GAMES = 3;
+    static const int DEFAULT_MEMORY_MB = 512;
+
+    /**
+     * The games where a move was played from a position, and their results for the player making the move.
+     */
+    struct Count {
+      uint64_t key; /**< Polyglot key of the position */
+      uint16_t move; /**< Encoded as in the book */
+      uint16_t reserved; /**< 0 */
+      uint32_t games; /**< 0 for an empty slot of a shard */
+      uint32_t wins;
+      uint32_t draws;
+    };
+
+    /**
+     * @param maxPly: positions after this number of half-turns are not stored.
+     * @param minGames: moves played in fewer games are left out of the book.
+     * @param numThreads: the number of threads reading the games. 0 to use all cores.
+     * @param memoryMB: the memory used by the hash tables of all shards.
+     */
+    PolyglotBookBuilder(int maxPly = DEFAULT_MAX_PLY, int minGames = DEFAULT_MIN_GAMES,
+                        int numThreads = 0, int memoryMB = DEFAULT_MEMORY_MB);
+    ~PolyglotBookBuilder() {}
+
+    /**
+     * Read games and write the book. Fails at once if PolyglotBook::checkKeys fails.
+     * Games that are invalid or without a result are skipped.
+     * The weight of a move is 2 per win and 1 per draw of the player making it,
+     * scaled down if needed so that the largest weight of a position fits in 16 bits.
+     * Moves that never won nor drew are left out.
+     * The temporary run files are written next to the book, and removed.
+     * @param pgnPaths: the PGN files.
+     * @param bookPath: the book file, replaced.
+     * @return false if a file can't be read or written.
+     */
+    bool build(const std::vector<std::string>& pgnPaths, std::string bookPath);
+
+    /**
+     * Count the moves of a game (called by PGNReader).
+     */
+    void onGame(const PGNGame& game, int thread);
+
+    long long getNumGames() { return numGames; }
+    long long getNumPositions() { return numPositions; } /**< The number of positions in the book */
+    long long getNumEntries() { return numEntries; } /**< The number of moves in the book */
+    int getNumRuns() { return numRuns; } /**< The number of run files written */
+
+  private:
+    static const int SHARD_BITS = 6; /**< A shard is chosen by the highest bits of the key */
+    static const int NUM_SHARDS = 1 << SHARD_BITS;
+
+    /**
+     * A hash table with open addressing (linear probing), and the run files it was written to.
+     */
+    struct Shard {
+      std::mutex mutex;
+      std::vector<Count> slots;
+      int numUsed;
+      std::vector<std::string> runPaths;
+    };
+
+    int maxPly;
+    int minGames;
+    int numThreads;
+    size_t shardSize; /**< The number of slots of a shard, a power of 2 */
+    std::vector<Shard> shards;
+    std::vector<Board> boards; /**< The board replaying the games of each thread */
+    std::atomic<long long> numGames;
+    long long numPositions;
+    long long numEntries;
+    int numRuns;
+    std::atomic<bool> failed; /**< A run file couldn't be written */
+    std::string bookPath;
+
+    /**
+     * Add a game to the count of a move. The shard must be locked.
+     * @param result: 1 for a win of the player making the move, 0 for a draw, -1 for a loss.
+     */
+    void add(Shard& shard, uint64_t key, uint16_t move, int result);
+
+    /**
+     * Sort the counts of a shard and write them to a new run file, then empty the shard.
+     * @return false if the run file can't be written.
+     */
+    bool flush(Shard& shard);
+
+    /**
+     * Merge the runs of a shard, and write its positions to the book.
+     */
+    bool merge(Shard& shard, FILE* out);
+
+    /**
+     * Write the moves of a position played in enough games, the greatest weight first.
+     * @param moves: the counts of a position, in any order.
+     */
+    bool writePosition(std::vector<Count>& moves, FILE* out);
+};
+
+#endif // POLYGLOTBOOK_H
@@ -0,0 +1,244 @@
+#include "PositionDB.h"
+
+#include <string.h>
+#include <algorithm>
+#include <thread>
+
+#include "RunMerger.h"
+
+// order of the entries in the database
+static bool entryLess(const PositionDB::Entry& a, const PositionDB::Entry& b) {
+  return a.key < b.key || (a.key == b.key && a.move < b.move);
+}
+
+static bool keyLess(const PositionDB::Entry& entry, uint64_t key) {
+  return entry.key < key;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                                Queries
+////////////////////////////////////////////////////////////////////////////
+
+bool PositionDB::open(std::string path) {
+  close();
+  if (!file.open(path, true)) return false;
+  const Header* fileHeader = (const Header*) file.getData();
+  if (file.getSize() < sizeof(Header) || memcmp(fileHeader->magic, "CPDB", 4) != 0) {
+    printf("%s is not a position database\n", path.c_str());
+    file.close();
+    return false;
+  }
+  if (fileHeader->version != VERSION
+      || file.getSize() != sizeof(Header) + fileHeader->numEntries * sizeof(Entry)) {
+    printf("%s has an unknown version or is truncated\n", path.c_str());
+    file.close();
+    return false;
+  }
+  header = fileHeader;
+  entries = (const Entry*) (file.getData() + sizeof(Header));
+  return true;
+}
+
+void PositionDB::close() {
+  file.close();
+  header = NULL;
+  entries = NULL;
+}
+
+int PositionDB::find(uint64_t key, const Entry*& first) {
+  first = NULL;
+  if (header == NULL) return 0;
+  const Entry* end = entries + header->numEntries;
+  first = std::lower_bound(entries, end, key, keyLess);
+  const Entry* last = first;
+  while (last != end && last->key == key) last++;
+  return last - first;
+}
+
+bool PositionDB::getTotal(uint64_t key, Entry& total) {
+  memset(&total, 0, sizeof(total));
+  total.key = key;
+  total.move = NO_MOVE;
+  const Entry* first;
+  int numEntries = find(key, first);
+  for (int i = 0; i < numEntries; i++) {
+    total.whiteWins += first[i].whiteWins;
+    total.draws += first[i].draws;
+    total.blackWins += first[i].blackWins;
+  }
+  return numEntries > 0;
+}
+
+uint16_t PositionDB::encodeMove(Board& b, int moveIndex) {
+  Board::View moves = b.getMoveListView();
+  int i = moveIndex * Board::MOVE_LENGTH_MOVE_LIST;
+  int promotion = (moves[i+2] >= Board::MOVE_PROMOTION_QUEEN)? moves[i+2] - Board::MOVE_PROMOTION_QUEEN + 1 : 0;
+  return moves[i] | (moves[i+1] << 6) | (promotion << 12);
+}
+
+int PositionDB::decodeMove(Board& b, uint16_t move) {
+  int moveIndex = b.findMove(move & 63, (move >> 6) & 63);
+  if (moveIndex == -1) return -1;
+  // the other promotions follow the queen promotion
+  int promotion = move >> 12;
+  if (promotion > 0) moveIndex += promotion - 1;
+  Board::View moves = b.getMoveListView();
+  if (moveIndex >= b.getNumMoves()) return -1;
+  int moveType = moves[moveIndex * Board::MOVE_LENGTH_MOVE_LIST + 2];
+  if (promotion > 0 && moveType != Board::MOVE_PROMOTION_QUEEN + promotion - 1) return -1;
+  if (promotion == 0 && moveType >= Board::MOVE_PROMOTION_QUEEN) return -1;
+  return moveIndex;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                                Building
+////////////////////////////////////////////////////////////////////////////
+
+PositionDBBuilder::PositionDBBuilder(int maxPly, int numThreads, int memoryMB) : numGames(0) {
+  this->maxPly = maxPly;
+  this->numThreads = (numThreads > 0)? numThreads : std::thread::hardware_concurrency();
+  if (this->numThreads < 1) this->numThreads = 1;
+  bufferSize = (size_t) memoryMB * (1 << 20) / sizeof(PositionDB::Entry) / this->numThreads;
+  if (bufferSize < 1024) bufferSize = 1024;
+  numEntries = 0;
+  failed = false;
+}
+
+bool PositionDBBuilder::build(const std::vector<std::string>& pgnPaths, std::string dbPath) {
+  this->dbPath = dbPath;
+  numGames = 0;
+  numEntries = 0;
+  failed = false;
+  runPaths.clear();
+  threads.assign(numThreads, ThreadData());
+  for (int t = 0; t < numThreads; t++) threads[t].entries.reserve(bufferSize);
+
+  bool success = true;
+  PGNReader reader(numThreads);
+  for (int i = 0; i < pgnPaths.size() && success; i++) {
+    success = reader.read(pgnPaths[i], this);
+    if (success) printf("%s: %lld games\n", pgnPaths[i].c_str(), reader.getNumGames());
+  }
+  for (int t = 0; t < numThreads; t++) {
+    if (success && !flush(threads[t].entries, true)) success = false;
+    std::vector<PositionDB::Entry>().swap(threads[t].entries);
+  }
+  success = success && !failed && merge();
+  for (int i = 0; i < runPaths.size(); i++) {
+    remove(runPaths[i].c_str());
+  }
+  return success;
+}
+
+void PositionDBBuilder::onGame(const PGNGame& game, int thread) {
+  if (!game.valid || game.result == -1 || failed) return;
+  ThreadData& data = threads[thread];
+  Board& b = data.board;
+  if (game.fen.empty()) b.initBoard();
+  else b.loadFEN(game.fen);
+
+  PositionDB::Entry entry;
+  entry.reserved = 0;
+  entry.whiteWins = (game.result == Board::WHITE);
+  entry.draws = (game.result == Board::BOTH_COLOR);
+  entry.blackWins = (game.result == Board::BLACK);
+  std::vector<uint64_t>& gameKeys = data.gameKeys;
+  gameKeys.clear();
+  for (int ply = 0; ply <= game.moves.size() && ply <= maxPly; ply++) {
+    entry.key = b.getHashKey();
+    bool repeated = std::find(gameKeys.begin(), gameKeys.end(), entry.key) != gameKeys.end();
+    if (ply == game.moves.size()) {
+      entry.move = PositionDB::NO_MOVE;
+    } else {
+      entry.move = PositionDB::encodeMove(b, game.moves[ply]);
+      b.makeMove(game.moves[ply]);
+    }
+    if (repeated) continue; // the game is already counted in the position
+    gameKeys.push_back(entry.key);
+    data.entries.push_back(entry);
+    if (data.entries.size() >= bufferSize && !flush(data.entries, false)) failed = true;
+  }
+  numGames++;
+}
+
+void PositionDBBuilder::compact(std::vector<PositionDB::Entry>& entries) {
+  std::sort(entries.begin(), entries.end(), entryLess);
+  size_t last = 0;
+  for (size_t i = 1; i < entries.size(); i++) {
+    if (entries[i].key == entries[last].key && entries[i].move == entries[last].move) {
+      entries[last].whiteWins += entries[i].whiteWins;
+      entries[last].draws += entries[i].draws;
+      entries[last].blackWins += entries[i].blackWins;
+    } else {
+      entries[++last] = entries[i];
+    }
+  }
+  if (!entries.empty()) entries.resize(last + 1);
+}
+
+bool PositionDBBuilder::flush(std::vector<PositionDB::Entry>& entries, bool force) {
+  // positions near the start repeat a lot, compacting often frees half the buffer without writing it
+  compact(entries);
+  if (entries.empty() || (!force && entries.size() < bufferSize / 2)) return true;
+
+  std::string path;
+  {
+    std::lock_guard<std::mutex> lock(runMutex);
+    path = dbPath + ".run" + std::to_string(runPaths.size());
+    runPaths.push_back(path);
+  }
+  bool success = RunMerger<PositionDB::Entry>::writeRun(path, &entries[0], entries.size());
+  entries.clear(); // even on failure, or each following entry would sort the buffer again
+  return success;
+}
+
+bool PositionDBBuilder::merge() {
+  const int BLOCK_SIZE = 1 << 14;
+  RunMerger<PositionDB::Entry> runs(entryLess, BLOCK_SIZE);
+  bool success = runs.open(runPaths);
+  FILE* out = success? fopen(dbPath.c_str(), "wb") : NULL;
+  if (success && out == NULL) {
+    printf("Unable to create %s\n", dbPath.c_str());
+    success = false;
+  }
+
+  if (success) {
+    PositionDB::Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "CPDB", 4);
+    header.version = PositionDB::VERSION;
+    header.numGames = numGames;
+    header.maxPly = maxPly;
+    fwrite(&header, sizeof(header), 1, out); // numEntries is written at the end
+
+    std::vector<PositionDB::Entry> output;
+    output.reserve(BLOCK_SIZE);
+    numEntries = 0;
+    PositionDB::Entry entry;
+    while (runs.next(entry)) {
+      if (!output.empty() && output.back().key == entry.key && output.back().move == entry.move) {
+        output.back().whiteWins += entry.whiteWins;
+        output.back().draws += entry.draws;
+        output.back().blackWins += entry.blackWins;
+      } else {
+        // the last entry may still grow, write the ones before it
+        if (output.size() == output.capacity()) {
+          success = fwrite(&output[0], sizeof(PositionDB::Entry), output.size() - 1, out) == output.size() - 1 && success;
+          output[0] = output.back();
+          output.resize(1);
+        }
+        output.push_back(entry);
+        numEntries++;
+      }
+    }
+    if (!output.empty()) {
+      success = fwrite(&output[0], sizeof(PositionDB::Entry), output.size(), out) == output.size() && success;
+    }
+
+    header.numEntries = numEntries;
+    success = fseek(out, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, out) == 1 && success;
+    success = (fclose(out) == 0) && success;
+    if (!success) printf("Unable to write %s\n", dbPath.c_str());
+  }
+  return success;
+}
@@ -0,0 +1,184 @@
+/***********************************************************************//**
+ * A database of the positions reached in a collection of games,
+ * with the moves played from each position and the results of these games.
+ *
+ * The file is a header followed by one Entry per (position, move), sorted by
+ * Zobrist key (Board::getHashKey) and move. A query maps the file into memory
+ * and binary searches the key, so it only touches a few pages of a file of any size.
+ * The keys are Board's own, so a database only works with the Board that built it.
+ * Numbers are stored in the machine's byte order (little endian on x86 and ARM).
+ *
+ * PositionDBBuilder fills a database from PGN files. The entries of each thread
+ * are collected in a buffer of bounded size, sorted and written to a temporary run file
+ * when it is full, and the runs are merged into the database at the end.
+ ***************************************************************************/
+
+#ifndef POSITIONDB_H
+#define POSITIONDB_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Board.h"
+#include "MappedFile.h"
+#include "PGN.h"
+
+class PositionDB {
+  public:
+    /**
+     * The move of the entries counting the games that ended in the position.
+     */
+    static const uint16_t NO_MOVE = 0;
+
+    /**
+     * A move played from a position, and the results of the games where it was played.
+     * A game that repeats a position only counts the move played the first time.
+     */
+    struct Entry {
+      uint64_t key; /**< Zobrist key of the position */
+      uint16_t move; /**< See encodeMove, NO_MOVE if the game ended in the position */
+      uint16_t reserved; /**< 0 */
+      uint32_t whiteWins;
+      uint32_t draws;
+      uint32_t blackWins;
+    };
+
+    struct Header {
+      char magic[4]; /**< "CPDB" */
+      uint32_t version;
+      uint64_t numEntries;
+      uint64_t numGames;
+      uint32_t maxPly; /**< Positions after this number of half-turns are not in the database */
+      uint32_t reserved;
+    };
+
+    static const uint32_t VERSION = 1;
+
+    PositionDB() { header = NULL; entries = NULL; }
+    ~PositionDB() {}
+
+    /**
+     * Open a database file (closing the previous one).
+     * @return false if the file can't be mapped or is not a database.
+     */
+    bool open(std::string path);
+
+    void close();
+
+    /**
+     * Find the moves played from a position.
+     * @param key: the position's Zobrist key (Board::getHashKey).
+     * @param first: receives the position's first entry (in the mapped file), sorted by move.
+     * @return the number of entries of the position, 0 if the database doesn't have it.
+     */
+    int find(uint64_t key, const Entry*& first);
+
+    /**
+     * Count the games that reached a position.
+     * @param total: receives the sum of the results over all the position's entries (key and move are set too).
+     * @return false if the database doesn't have the position.
+     */
+    bool getTotal(uint64_t key, Entry& total);
+
+    /**
+     * @return all the entries (getNumEntries of them), sorted by key and move.
+     */
+    const Entry* getEntries() { return entries; }
+
+    uint64_t getNumEntries() { return (header != NULL)? header->numEntries : 0; }
+    uint64_t getNumGames() { return (header != NULL)? header->numGames : 0; }
+    int getMaxPly() { return (header != NULL)? header->maxPly : 0; }
+
+    /**
+     * Encode a move independently from the move list: starting square (bits 0 -> 5),
+     * ending square (bits 6 -> 11), promotion (bits 12 -> 14: 0 for none, then queen, rook, knight, bishop).
+     * Castling is the king's move. Never NO_MOVE.
+     * @param moveIndex: the move number in b's move list.
+     */
+    static uint16_t encodeMove(Board& b, int moveIndex);
+
+    /**
+     * @return the move number of an encoded move in b's move list, -1 if b has no such move.
+     */
+    static int decodeMove(Board& b, uint16_t move);
+
+  private:
+    MappedFile file;
+    const Header* header; /**< In the mapped file */
+    const Entry* entries; /**< In the mapped file, after the header */
+};
+
+class PositionDBBuilder : public PGNListener {
+  public:
+    static const int DEFAULT_MAX_PLY = 40;
+    static const int DEFAULT_MEMORY_MB = 512;
+
+    /**
+     * @param maxPly: positions after this number of half-turns are not stored.
+     * @param numThreads: the number of threads reading the games. 0 to use all cores.
+     * @param memoryMB: the memory used by the buffers of all threads.
+     */
+    PositionDBBuilder(int maxPly = DEFAULT_MAX_PLY, int numThreads = 0, int memoryMB = DEFAULT_MEMORY_MB);
+    ~PositionDBBuilder() {}
+
+    /**
+     * Read games and write the database. Games that are invalid or without a result are skipped.
+     * The temporary run files are written next to the database, and removed.
+     * @param pgnPaths: the PGN files.
+     * @param dbPath: the database file, replaced.
+     * @return false if a file can't be read or written.
+     */
+    bool build(const std::vector<std::string>& pgnPaths, std::string dbPath);
+
+    /**
+     * Store the positions of a game (called by PGNReader).
+     */
+    void onGame(const PGNGame& game, int thread);
+
+    long long getNumGames() { return numGames; }
+    long long getNumEntries() { return numEntries; }
+
+  private:
+    /**
+     * The buffer of a thread, and the board replaying its games.
+     */
+    struct ThreadData {
+      Board board;
+      std::vector<PositionDB::Entry> entries;
+      std::vector<uint64_t> gameKeys; /**< The positions of the current game, so that each counts the game once */
+    };
+
+    int maxPly;
+    int numThreads;
+    size_t bufferSize; /**< The number of entries of a thread's buffer */
+    std::vector<ThreadData> threads;
+    std::atomic<long long> numGames;
+    long long numEntries;
+    std::atomic<bool> failed; /**< A run file couldn't be written: the next games are skipped */
+
+    std::string dbPath;
+    std::mutex runMutex; /**< Protects runPaths */
+    std::vector<std::string> runPaths;
+
+    /**
+     * Sort a buffer and add up the entries with the same key and move.
+     */
+    static void compact(std::vector<PositionDB::Entry>& entries);
+
+    /**
+     * Sort a buffer, and write it to a new run file if it is still more than half full (or if forced).
+     * @return false if the run file can't be written.
+     */
+    bool flush(std::vector<PositionDB::Entry>& entries, bool force);
+
+    /**
+     * Merge the run files into the database, adding up the entries with the same key and move.
+     */
+    bool merge();
+};
+
+#endif // POSITIONDB_H
@@ -0,0 +1,316 @@
+#include "ResourceManager.h"
+
+#include <SDL2/SDL_image.h>
+#include <stdio.h>
+#include <algorithm>
+
+#include "GUI.h"
+
+ResourceManager::ResourceManager(SDL_Renderer* renderer, int atlasSize, int numThreads) {
+  this->renderer = renderer;
+  this->atlasSize = atlasSize;
+  numImagesRead = 0;
+  numQueued = 0;
+  numDecoded = 0;
+  stopping = false;
+
+  if (numThreads <= 0) numThreads = std::min((int) std::thread::hardware_concurrency(), MAX_THREADS);
+  if (numThreads <= 0) numThreads = 1;
+  for (int t = 0; t < numThreads; t++) {
+    workers.push_back(std::thread(&ResourceManager::decode, this));
+  }
+}
+
+ResourceManager::~ResourceManager() {
+  destroyMedia();
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  Loading
+//////////////////////////////////////////////////////////////////////////
+
+void ResourceManager::load(TextureWrapper* image, std::string path) {
+  std::map<std::string, int>::iterator found = imageIndexes.find(path);
+  if (found != imageIndexes.end()) {
+    Image& loaded = images[found->second];
+    loaded.users.push_back(image);
+    // already packed by a previous build
+    if (loaded.packed && loaded.atlas >= 0) image->setRegion(atlases[loaded.atlas], loaded.rect);
+    return;
+  }
+
+  Image loaded;
+  loaded.path = path;
+  loaded.surface = NULL;
+  loaded.packed = false;
+  loaded.users.push_back(image);
+  loaded.atlas = -1;
+  imageIndexes[path] = images.size();
+  images.push_back(loaded);
+  addJob(&images.back(), NULL);
+}
+
+void ResourceManager::loadMusic(Mix_Music** music, std::string path) {
+  *music = NULL;
+  Sound sound = {path, music, NULL, NULL, NULL, false};
+  sounds.push_back(sound);
+  addJob(NULL, &sounds.back());
+}
+
+void ResourceManager::loadSound(Mix_Chunk** chunk, std::string path) {
+  *chunk = NULL;
+  Sound sound = {path, NULL, chunk, NULL, NULL, false};
+  sounds.push_back(sound);
+  addJob(NULL, &sounds.back());
+}
+
+void ResourceManager::addJob(Image* image, Sound* sound) {
+  Job job = {image, sound};
+  {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    jobs.push_back(job);
+  }
+  numQueued++;
+  jobAdded.notify_one();
+}
+
+void ResourceManager::decode() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(jobMutex);
+      jobAdded.wait(lock, [this]() { return stopping || !jobs.empty(); });
+      if (stopping) return;
+      job = jobs.front();
+      jobs.pop_front();
+    }
+
+    if (job.image != NULL) {
+      job.image->surface = IMG_Load(job.image->path.c_str());
+      if (job.image->surface == NULL) {
+        printf("Unable to load image %s! SDL_image Error: %s\n", job.image->path.c_str(), IMG_GetError());
+      }
+    } else {
+      std::lock_guard<std::mutex> audioLock(audioMutex);
+      Sound* sound = job.sound;
+      if (sound->musicTarget != NULL) sound->music = Mix_LoadMUS(sound->path.c_str());
+      else sound->chunk = Mix_LoadWAV(sound->path.c_str());
+      if (sound->music == NULL && sound->chunk == NULL) {
+        printf("Failed to load %s. SDL_mixer error: %s\n", sound->path.c_str(), Mix_GetError());
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(jobMutex);
+      numDecoded++;
+    }
+    jobDone.notify_all();
+    GUI::wakeUp(); // the main loop may be waiting for these files to show a screen
+  }
+}
+
+void ResourceManager::stopWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    stopping = true;
+  }
+  jobAdded.notify_all();
+  for (int t = 0; t < workers.size(); t++) {
+    workers[t].join();
+  }
+  workers.clear();
+}
+
+bool ResourceManager::isLoaded() {
+  std::lock_guard<std::mutex> lock(jobMutex);
+  return numDecoded == numQueued;
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  Packing
+//////////////////////////////////////////////////////////////////////////
+
+void ResourceManager::place(Image& image, int width, std::vector<Shelf>& shelves, std::vector<int>& atlasHeights, int firstAtlas) {
+  int w = image.surface->w + PADDING;
+  int h = image.surface->h + PADDING;
+
+  // the first shelf with room left
+  for (int i = 0; i < shelves.size(); i++) {
+    if (shelves[i].height >= h && shelves[i].usedWidth + w <= width) {
+      image.atlas = shelves[i].atlas;
+      image.rect = {shelves[i].usedWidth, shelves[i].y, image.surface->w, image.surface->h};
+      shelves[i].usedWidth += w;
+      return;
+    }
+  }
+  // a new shelf under the others, in the first atlas with room left (or a new atlas)
+  int atlas = 0;
+  while (atlas < atlasHeights.size() && atlasHeights[atlas] + h > atlasSize) atlas++;
+  if (atlas == atlasHeights.size()) atlasHeights.push_back(0);
+  Shelf shelf = {firstAtlas + atlas, atlasHeights[atlas], h, w};
+  atlasHeights[atlas] += h;
+  shelves.push_back(shelf);
+  image.atlas = shelf.atlas;
+  image.rect = {0, shelf.y, image.surface->w, image.surface->h};
+}
+
+long long ResourceManager::pack(const std::vector<Image*>& order, int width, int firstAtlas) {
+  std::vector<Shelf> shelves;
+  std::vector<int> atlasHeights;
+  for (int i = 0; i < order.size(); i++) {
+    Image& image = *order[i];
+    if (image.surface->w > atlasSize || image.surface->h > atlasSize) {
+      // too big for an atlas: its own texture
+      image.atlas = firstAtlas + atlasHeights.size();
+      image.rect = {0, 0, image.surface->w, image.surface->h};
+      atlasHeights.push_back(atlasSize); // full
+      continue;
+    }
+    place(image, width, shelves, atlasHeights, firstAtlas);
+  }
+
+  // the pixels of the atlases, each trimmed to its images
+  std::vector<int> widths(atlasHeights.size(), 0), heights(atlasHeights.size(), 0);
+  for (int i = 0; i < order.size(); i++) {
+    Image& image = *order[i];
+    int a = image.atlas - firstAtlas;
+    widths[a] = std::max(widths[a], image.rect.x + image.rect.w);
+    heights[a] = std::max(heights[a], image.rect.y + image.rect.h);
+  }
+  long long area = 0;
+  for (int a = 0; a < atlasHeights.size(); a++) {
+    area += (long long) widths[a] * heights[a];
+  }
+  return area;
+}
+
+bool ResourceManager::build() {
+  {
+    std::unique_lock<std::mutex> lock(jobMutex);
+    jobDone.wait(lock, [this]() { return numDecoded == numQueued; });
+  }
+  bool success = true;
+
+  // hand out the sounds
+  for (int i = 0; i < sounds.size(); i++) {
+    Sound& sound = sounds[i];
+    if (sound.delivered) continue;
+    if (sound.musicTarget != NULL) *sound.musicTarget = sound.music;
+    else *sound.chunkTarget = sound.chunk;
+    if (sound.music == NULL && sound.chunk == NULL) success = false;
+    sound.delivered = true;
+  }
+
+  // the images that are not packed yet, the tallest first, so that each shelf is filled with images of similar heights
+  std::vector<Image*> order;
+  for (int i = 0; i < images.size(); i++) {
+    if (images[i].packed) continue;
+    if (images[i].surface == NULL) {
+      images[i].packed = true; // failed to load, stays empty
+      success = false;
+      continue;
+    }
+    order.push_back(&images[i]);
+    numImagesRead++;
+  }
+  if (order.empty()) return success;
+  std::sort(order.begin(), order.end(), [](Image* a, Image* b) {
+    return a->surface->h > b->surface->h;
+  });
+
+  // place all images, with the shelf width that needs the fewest pixels
+  int firstAtlas = atlases.size();
+  int minWidth = 1;
+  for (int i = 0; i < order.size(); i++) {
+    minWidth = std::max(minWidth, std::min(order[i]->surface->w + PADDING, atlasSize));
+  }
+  int bestWidth = atlasSize;
+  long long bestArea = -1;
+  for (int width = minWidth; width <= atlasSize; width += WIDTH_STEP) {
+    long long area = pack(order, width, firstAtlas);
+    if (bestArea < 0 || area < bestArea) {
+      bestArea = area;
+      bestWidth = width;
+    }
+  }
+  int numAtlases = 0;
+  pack(order, bestWidth, firstAtlas);
+  for (int i = 0; i < order.size(); i++) {
+    numAtlases = std::max(numAtlases, order[i]->atlas - firstAtlas + 1);
+  }
+
+  // copy the images into one surface per atlas, just big enough for its images
+  for (int a = 0; a < numAtlases; a++) {
+    int width = 0, height = 0;
+    for (int i = 0; i < order.size(); i++) {
+      Image& image = *order[i];
+      if (image.atlas != firstAtlas + a) continue;
+      width = std::max(width, image.rect.x + image.rect.w);
+      height = std::max(height, image.rect.y + image.rect.h);
+    }
+    SDL_Texture* texture = NULL;
+    SDL_Surface* atlas = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+    if (atlas == NULL) {
+      printf("Unable to create a %ix%i atlas! SDL Error: %s\n", width, height, SDL_GetError());
+      success = false;
+    } else {
+      for (int i = 0; i < order.size(); i++) {
+        Image& image = *order[i];
+        if (image.atlas != firstAtlas + a) continue;
+        // copy the pixels with their alpha, without blending them on the atlas
+        SDL_SetSurfaceBlendMode(image.surface, SDL_BLENDMODE_NONE);
+        SDL_Rect dst = image.rect;
+        SDL_BlitSurface(image.surface, NULL, atlas, &dst);
+      }
+      texture = SDL_CreateTextureFromSurface(renderer, atlas);
+      if (texture == NULL) {
+        printf("Unable to create an atlas texture! SDL Error: %s\n", SDL_GetError());
+        success = false;
+      } else {
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+      }
+      SDL_FreeSurface(atlas);
+    }
+    atlases.push_back(texture);
+  }
+
+  // hand out the regions
+  for (int i = 0; i < order.size(); i++) {
+    Image& image = *order[i];
+    for (int u = 0; u < image.users.size(); u++) {
+      image.users[u]->setRegion(atlases[image.atlas], image.rect);
+    }
+    SDL_FreeSurface(image.surface);
+    image.surface = NULL;
+    image.packed = true;
+  }
+  return success;
+}
+
+int ResourceManager::getNumAtlases() {
+  return atlases.size();
+}
+
+int ResourceManager::getNumImages() {
+  return numImagesRead;
+}
+
+void ResourceManager::destroyMedia() {
+  stopWorkers();
+  for (int i = 0; i < atlases.size(); i++) {
+    if (atlases[i] != NULL) SDL_DestroyTexture(atlases[i]);
+  }
+  atlases.clear();
+  // the files decoded but not built yet
+  for (int i = 0; i < images.size(); i++) {
+    if (images[i].surface != NULL) SDL_FreeSurface(images[i].surface);
+  }
+  for (int i = 0; i < sounds.size(); i++) {
+    if (sounds[i].delivered) continue;
+    if (sounds[i].music != NULL) Mix_FreeMusic(sounds[i].music);
+    if (sounds[i].chunk != NULL) Mix_FreeChunk(sounds[i].chunk);
+  }
+  images.clear();
+  sounds.clear();
+  imageIndexes.clear();
+}
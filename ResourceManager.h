@@ -0,0 +1,199 @@
+/***********************************************************************//**
+ * Loads the images and sounds of all GUIs once, and packs the images into a few large textures (atlases).
+ * GUIs ask for their media by path in their constructors. The files are decoded by worker threads,
+ * in the order they were asked for, while the main thread goes on. Each image file is read once,
+ * however many TextureWrappers ask for it. build() then waits for the files asked for so far,
+ * packs their images into atlases and gives each TextureWrapper its sub-rectangle of an atlas.
+ * So a screen can be shown as soon as its own media is built, while the next screens are still loading.
+ * Drawing images from the same atlas doesn't switch textures,
+ * and the GPU receives a few uploads instead of one per image.
+ ***************************************************************************/
+
+#ifndef RESOURCEMANAGER_H
+#define RESOURCEMANAGER_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TextureWrapper.h"
+
+class ResourceManager {
+  public:
+    /**
+     * Atlas side length. 2048 is supported by practically all renderers,
+     * and fits 6 of the 800x600 screens with the small images in the gaps.
+     */
+    static const int DEFAULT_ATLAS_SIZE = 2048;
+
+    /**
+     * Maximum number of decoding threads. There are few files, and they compete for the disk.
+     */
+    static const int MAX_THREADS = 4;
+
+    /**
+     * @param renderer: the renderer that creates and draws the atlases.
+     * @param atlasSize: the maximum width and height of an atlas.
+     * @param numThreads: the number of decoding threads, 0 for one per core (at most MAX_THREADS).
+     */
+    ResourceManager(SDL_Renderer* renderer, int atlasSize = DEFAULT_ATLAS_SIZE, int numThreads = 0);
+    ~ResourceManager();
+
+    /**
+     * Load an image (once per path) in the background, to be drawn by a TextureWrapper.
+     * The TextureWrapper can draw the image after the next build(), and must not move until then.
+     * @param image: the TextureWrapper that will draw the image.
+     * @param path: path to the image file.
+     */
+    void load(TextureWrapper* image, std::string path);
+
+    /**
+     * Load a music in the background. The music is stored in *music by the next build(),
+     * NULL until then or if it can't be loaded. The caller frees the music.
+     * @param music: where to store the music.
+     * @param path: path to the music file.
+     */
+    void loadMusic(Mix_Music** music, std::string path);
+
+    /**
+     * Load a sound effect in the background. The sound is stored in *sound by the next build(),
+     * NULL until then or if it can't be loaded. The caller frees the sound.
+     * @param sound: where to store the sound.
+     * @param path: path to the sound file.
+     */
+    void loadSound(Mix_Chunk** sound, std::string path);
+
+    /**
+     * @return true if all the files asked for are decoded, so that build() won't wait.
+     */
+    bool isLoaded();
+
+    /**
+     * Wait for the files asked for since the last build, pack their images into atlases,
+     * create the atlas textures, and give each TextureWrapper its region and each GUI its sounds.
+     * Frees the decoded images. Must be called by the thread that owns the renderer.
+     * @return true if all files were loaded and all atlases were created.
+     */
+    bool build();
+
+    /**
+     * @return the number of atlas textures.
+     */
+    int getNumAtlases();
+
+    /**
+     * @return the number of image files read (each path is read once).
+     */
+    int getNumImages();
+
+    /**
+     * Stop loading and destroy the atlases. The TextureWrappers using them can't be drawn anymore.
+     */
+    void destroyMedia();
+
+  private:
+    /**
+     * An image file, and where it goes in the atlases.
+     */
+    struct Image {
+      std::string path;
+      SDL_Surface* surface; /**< The decoded file, written by a worker, NULL once packed */
+      bool packed; /**< Set by build(), when the image has its place in an atlas (or failed to load) */
+      std::vector<TextureWrapper*> users; /**< The TextureWrappers drawing this image */
+      int atlas; /**< Index in atlases */
+      SDL_Rect rect; /**< Position in the atlas */
+    };
+
+    /**
+     * A sound file, and the variable waiting for it.
+     */
+    struct Sound {
+      std::string path;
+      Mix_Music** musicTarget; /**< Where to store the music, NULL for a sound effect */
+      Mix_Chunk** chunkTarget; /**< Where to store the sound effect, NULL for a music */
+      Mix_Music* music; /**< The decoded music, written by a worker */
+      Mix_Chunk* chunk; /**< The decoded sound effect, written by a worker */
+      bool delivered; /**< Set by build(), when the sound is stored in its target */
+    };
+
+    /**
+     * A file to decode: exactly one of image and sound is not NULL.
+     */
+    struct Job {
+      Image* image;
+      Sound* sound;
+    };
+
+    /**
+     * A row of images in an atlas, as tall as its first (tallest) image.
+     */
+    struct Shelf {
+      int atlas;
+      int y, height;
+      int usedWidth;
+    };
+
+    static const int PADDING = 1; /**< Empty pixels between images, so that scaled images don't bleed into each other */
+    static const int WIDTH_STEP = 16; /**< Difference between the shelf widths tried by build() */
+
+    SDL_Renderer* renderer;
+    int atlasSize;
+    // deques: the workers keep pointers to the elements while the main thread adds more
+    std::deque<Image> images;
+    std::deque<Sound> sounds;
+    std::map<std::string, int> imageIndexes; /**< The index in images of each loaded path */
+    std::vector<SDL_Texture*> atlases;
+    int numImagesRead;
+
+    /////////////////////////////////////////////////////////////////////////////
+    //  Workers
+    /////////////////////////////////////////////////////////////////////////////
+    std::vector<std::thread> workers;
+    std::mutex jobMutex; /**< Protects jobs, numDecoded and stopping */
+    std::condition_variable jobAdded; /**< Signaled when a job is queued, or when the workers must stop */
+    std::condition_variable jobDone; /**< Signaled when a job is decoded */
+    std::deque<Job> jobs; /**< The files not taken by a worker yet, the oldest first */
+    int numQueued; /**< Number of jobs ever queued, only used by the main thread */
+    int numDecoded; /**< Number of jobs finished by the workers */
+    bool stopping;
+    std::mutex audioMutex; /**< SDL_mixer's loaders are not documented as thread-safe, one at a time */
+
+    /**
+     * Queue a file for the workers.
+     */
+    void addJob(Image* image, Sound* sound);
+
+    /**
+     * Worker loop: decode the queued files until stopping.
+     */
+    void decode();
+
+    /**
+     * Stop the workers, after the file they are decoding.
+     */
+    void stopWorkers();
+
+    /**
+     * Place the images in new atlases, on shelves of the given width.
+     * @param order: the images to place, the tallest first.
+     * @param width: the maximum width of the shelves.
+     * @param firstAtlas: the index in atlases of the first new atlas.
+     * @return the number of pixels of the new atlases.
+     */
+    long long pack(const std::vector<Image*>& order, int width, int firstAtlas);
+
+    /**
+     * Find a place for an image: on an existing shelf, on a new shelf, or in a new atlas.
+     * @param width: the maximum width of the shelves.
+     * @param atlasHeights: the height used by the shelves of each new atlas (grows as shelves are added).
+     */
+    void place(Image& image, int width, std::vector<Shelf>& shelves, std::vector<int>& atlasHeights, int firstAtlas);
+};
+
+#endif // RESOURCEMANAGER_H
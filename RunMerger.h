@@ -0,0 +1,141 @@
+/***********************************************************************//**
+ * Sorting more records than fit in memory, as the database and book builders do:
+ * the records are sorted a buffer at a time and written to temporary "run" files,
+ * then the runs are read back a block at a time and merged in order with a heap.
+ * Records are plain structs, written to the run files as they are in memory.
+ ***************************************************************************/
+
+#ifndef RUNMERGER_H
+#define RUNMERGER_H
+
+#include <stdio.h>
+#include <queue>
+#include <string>
+#include <vector>
+
+/**
+ * @param Record: the type of the records.
+ * @param Less: the order of the records in the runs, a function or functor comparing two records.
+ */
+template<typename Record, typename Less = bool (*)(const Record&, const Record&)>
+class RunMerger {
+  public:
+    /**
+     * Write sorted records to a new run file.
+     * @return false if the file can't be written (the error is printed).
+     */
+    static bool writeRun(const std::string& path, const Record* records, size_t count) {
+      FILE* file = fopen(path.c_str(), "wb");
+      if (file == NULL) {
+        printf("Unable to create %s\n", path.c_str());
+        return false;
+      }
+      bool success = fwrite(records, sizeof(Record), count, file) == count;
+      success = (fclose(file) == 0) && success;
+      if (!success) printf("Unable to write %s\n", path.c_str());
+      return success;
+    }
+
+    /**
+     * @param less: the order of the records in the runs.
+     * @param blockSize: the number of records read at a time from each run.
+     */
+    RunMerger(Less less, size_t blockSize) : less(less), blockSize(blockSize), heap(Greater(this)) {}
+    ~RunMerger() { close(); }
+
+    /**
+     * Open run files written by writeRun (closing the previous ones).
+     * @return false if a file can't be opened (the error is printed).
+     */
+    bool open(const std::vector<std::string>& paths) {
+      close();
+      runs.resize(paths.size());
+      bool success = true;
+      for (int r = 0; r < runs.size(); r++) {
+        runs[r].file = fopen(paths[r].c_str(), "rb");
+        runs[r].block.reserve(blockSize);
+        runs[r].next = (size_t) -1;
+        if (runs[r].file == NULL) {
+          printf("Unable to open %s\n", paths[r].c_str());
+          success = false;
+        }
+      }
+      if (!success) return false;
+      for (int r = 0; r < runs.size(); r++) {
+        if (runs[r].advance()) heap.push(r);
+      }
+      return true;
+    }
+
+    /**
+     * Take the smallest record left in the runs.
+     * @param record: receives the record.
+     * @return false when all records were taken.
+     */
+    bool next(Record& record) {
+      if (heap.empty()) return false;
+      int r = heap.top();
+      heap.pop();
+      record = runs[r].block[runs[r].next];
+      if (runs[r].advance()) heap.push(r);
+      return true;
+    }
+
+    /**
+     * Close the run files (they are not removed).
+     */
+    void close() {
+      for (int r = 0; r < runs.size(); r++) {
+        if (runs[r].file != NULL) fclose(runs[r].file);
+      }
+      runs.clear();
+      heap = std::priority_queue<int, std::vector<int>, Greater>(Greater(this));
+    }
+
+  private:
+    /**
+     * A run file being merged, read a block at a time.
+     */
+    struct Run {
+      FILE* file;
+      std::vector<Record> block;
+      size_t next; /**< The current record in block */
+
+      /**
+       * Move to the next record, reading the next block if needed.
+       * @return false at the end of the run.
+       */
+      bool advance() {
+        next++;
+        if (next < block.size()) return true;
+        block.resize(block.capacity());
+        block.resize(fread(&block[0], sizeof(Record), block.size(), file));
+        next = 0;
+        return !block.empty();
+      }
+    };
+
+    /**
+     * Puts the run with the smallest current record on top of the heap.
+     */
+    struct Greater {
+      RunMerger* merger;
+
+      Greater(RunMerger* merger) : merger(merger) {}
+
+      bool operator()(int a, int b) const {
+        const std::vector<Run>& runs = merger->runs;
+        return merger->less(runs[b].block[runs[b].next], runs[a].block[runs[a].next]);
+      }
+    };
+
+    Less less;
+    size_t blockSize;
+    std::vector<Run> runs;
+    std::priority_queue<int, std::vector<int>, Greater> heap; /**< The runs that have records left */
+
+    RunMerger(const RunMerger&) = delete; // the heap points to this object
+    RunMerger& operator=(const RunMerger&) = delete;
+};
+
+#endif // RUNMERGER_H
@@ -0,0 +1,72 @@
+/***********************************************************************//**
+ * Bounded lock-free queue for one producer thread and one consumer thread.
+ * Elements are copied into a fixed ring buffer, so pushing never allocates
+ * and never waits: when the queue is full, push fails and the producer moves on.
+ * Used to send search reports from the searching thread to the GUI.
+ ***************************************************************************/
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+
+/**
+ * @param T: the element type, copied in and out of the queue.
+ * @param CAPACITY: the number of slots, must be a power of 2. The queue holds at most CAPACITY - 1 elements.
+ */
+template<typename T, size_t CAPACITY>
+class SPSCQueue {
+  static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of 2");
+
+  public:
+    SPSCQueue() : head(0), tail(0) {}
+
+    /**
+     * Add an element. Only called by the producer thread.
+     * @return false if the queue is full (the element is dropped).
+     */
+    bool push(const T& element) {
+      size_t t = tail.load(std::memory_order_relaxed);
+      size_t next = (t + 1) & (CAPACITY - 1);
+      if (next == head.load(std::memory_order_acquire)) return false;
+      slots[t] = element;
+      tail.store(next, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * Remove the oldest element. Only called by the consumer thread.
+     * @param element: receives the element.
+     * @return false if the queue is empty.
+     */
+    bool pop(T& element) {
+      size_t h = head.load(std::memory_order_relaxed);
+      if (h == tail.load(std::memory_order_acquire)) return false;
+      element = slots[h];
+      head.store((h + 1) & (CAPACITY - 1), std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * Remove all elements. Only called by the consumer thread.
+     */
+    void clear() {
+      head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+  private:
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    // head and tail are written by different threads, keep them on different cache lines.
+    // Padded rather than alignas: an over-aligned type would need C++17's aligned new inside
+    // the objects allocated with new (AIPlayer), and the padding works at any address.
+    char headPadding[CACHE_LINE_SIZE];
+    std::atomic<size_t> head; /**< Next slot to read, written by the consumer */
+    char tailPadding[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> tail; /**< Next slot to write, written by the producer */
+    char slotsPadding[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    T slots[CAPACITY];
+};
+
+#endif // SPSCQUEUE_H
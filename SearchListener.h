@@ -0,0 +1,36 @@
+/***********************************************************************//**
+ * Receives progress reports from AIPlayer's search.
+ ***************************************************************************/
+
+#ifndef SEARCHLISTENER_H
+#define SEARCHLISTENER_H
+
+/**
+ * The result of one completed search depth.
+ * Has a fixed size, so that it can be copied between threads without allocating.
+ */
+struct SearchInfo {
+  static const int MAX_PV_LENGTH = 64;
+
+  int depth; /**< The depth that was completed (in half-turns) */
+  int score; /**< The score of the best move, in the perspective of the player to move */
+  long long nodes; /**< Nodes searched since the search started */
+  long long nps; /**< Nodes per second since the search started */
+  int timeMs; /**< Milliseconds since the search started */
+  int bestMove; /**< The best move's number in the move list of the searched board */
+  int pvLength; /**< The number of moves in pv */
+  int pv[MAX_PV_LENGTH]; /**< The principal variation: move numbers, each in the move list of the board after the previous moves */
+};
+
+class SearchListener {
+  public:
+    virtual ~SearchListener() {}
+
+    /**
+     * Called by the searching thread each time a depth is completed.
+     * The board is back at the searched position when this is called.
+     */
+    virtual void onSearchInfo(const SearchInfo& info) = 0;
+};
+
+#endif // SEARCHLISTENER_H
@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <random>
+#include <thread>
+
+#include "SelfPlay.h"
+
+SelfPlay::SelfPlay(int numThreads) : numGames(0), failed(false) {
+  this->numThreads = (numThreads > 0)? numThreads : std::thread::hardware_concurrency();
+  if (this->numThreads < 1) this->numThreads = 1;
+  maxDepth = 6;
+  maxNodes = 0;
+  randomPlies = DEFAULT_RANDOM_PLIES;
+  seed = 1;
+  for (int i = 0; i < 3; i++) numWins[i] = 0;
+}
+
+void SelfPlay::setLimits(int depth, long long nodes) {
+  maxDepth = depth;
+  maxNodes = nodes;
+}
+
+void SelfPlay::setOpenings(int randomPlies, uint64_t seed) {
+  this->randomPlies = randomPlies;
+  this->seed = seed;
+}
+
+bool SelfPlay::run(int numGames, std::string path) {
+  this->numGames = 0;
+  for (int i = 0; i < 3; i++) numWins[i] = 0;
+  failed = false;
+  if (!writer.open(path)) return false;
+
+  std::atomic<int> nextGame(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < numThreads; t++) {
+    threads.push_back(std::thread(&SelfPlay::playGames, this, &nextGame, numGames));
+  }
+  for (int t = 0; t < numThreads; t++) {
+    threads[t].join();
+  }
+  return writer.close() && !failed;
+}
+
+void SelfPlay::playGames(std::atomic<int>* nextGame, int numGames) {
+  Board b;
+  AIPlayer ai(&b, NULL, maxDepth);
+  ai.setLimits(maxDepth, maxNodes, 0);
+  TranspositionTable table;
+  ai.setTranspositionTable(&table);
+  std::vector<PackedPosition> positions;
+  while (!failed) {
+    int i = (*nextGame)++;
+    if (i >= numGames) break;
+    int winner = playGame(i, b, ai, table, positions);
+    if (!writer.write(positions.data(), positions.size())) failed = true;
+    numWins[winner]++;
+    long long numPlayed = ++this->numGames;
+    if (numPlayed % 100 == 0) printf("%lld games, %lld positions\n", numPlayed, writer.getNumPositions());
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                                  Games
+////////////////////////////////////////////////////////////////////////////
+
+int SelfPlay::playGame(int gameNumber, Board& b, AIPlayer& ai, TranspositionTable& table,
+                       std::vector<PackedPosition>& positions) {
+  table.clear();
+  b.initBoard();
+  positions.clear();
+  std::mt19937_64 random(seed + gameNumber * 0x9E3779B97F4A7C15ULL);
+  std::vector<uint64_t> keys(1, b.getHashKey());
+
+  int ply = 0;
+  int winner = -1;
+  int winningSide = -1; // the side the searches agree is winning, -1 if none
+  int winningPlies = 0;
+  while (true) {
+    winner = getGameResult(b, keys);
+    if (winner != -1) break;
+    if (ply >= MAX_GAME_PLIES) {
+      winner = Board::BOTH_COLOR;
+      break;
+    }
+
+    int move;
+    if (ply < randomPlies) {
+      move = random() % b.getNumMoves();
+    } else {
+      move = ai.decideMove();
+      int score = (ai.getNumPVLines() > 0)? ai.getPVLine(0).score : 0;
+      if (!b.isKingChecked() && !b.isCapture(move)) {
+        PackedPosition position;
+        if (position.pack(b, score, 0, ply)) positions.push_back(position);
+      }
+      // adjudicate when the score stays high for the same side
+      int side = (score >= WIN_SCORE)? b.getPlayer() : (score <= -WIN_SCORE)? 1 - b.getPlayer() : -1;
+      winningPlies = (side != -1 && side == winningSide)? winningPlies + 1 : 1;
+      winningSide = side;
+      if (winningSide != -1 && winningPlies >= WIN_PLIES) {
+        winner = winningSide;
+        break;
+      }
+    }
+
+    // positions before a capture or a pawn move can't be repeated
+    int from = b.getMoveListView()[move * Board::MOVE_LENGTH_MOVE_LIST];
+    if (b.isCapture(move) || b.getPiece(from) == Board::WP || b.getPiece(from) == Board::BP) keys.clear();
+    b.makeMove(move);
+    keys.push_back(b.getHashKey());
+    ply++;
+  }
+
+  for (int i = 0; i < positions.size(); i++) {
+    if (winner == Board::BOTH_COLOR) positions[i].result = 0;
+    else positions[i].result = (positions[i].getPlayer() == winner)? 1 : -1;
+  }
+  return winner;
+}
+
+int SelfPlay::getGameResult(Board& b, const std::vector<uint64_t>& keys) {
+  if (b.getNumMoves() == 0) return b.getWinner();
+  // 50 moves by each player without a capture or a pawn move
+  if (keys.size() > 100) return Board::BOTH_COLOR;
+  // the same player to move in the same position for the third time
+  int numRepetitions = 1;
+  for (int i = (int) keys.size() - 3; i >= 0; i -= 2) {
+    if (keys[i] == keys.back()) numRepetitions++;
+  }
+  if (numRepetitions >= 3) return Board::BOTH_COLOR;
+  if (isInsufficientMaterial(b)) return Board::BOTH_COLOR;
+  return -1;
+}
+
+bool SelfPlay::isInsufficientMaterial(Board& b) {
+  int numMinors = 0;
+  for (int s = 0; s < Board::NUM_SQUARES; s++) {
+    switch (b.getPiece(s)) {
+      case Board::EMPTY: case Board::WK: case Board::BK:
+        break;
+      case Board::WN: case Board::BN: case Board::WB: case Board::BB:
+        numMinors++;
+        break;
+      default: // a queen, rook or pawn
+        return false;
+    }
+  }
+  return numMinors <= 1;
+}
@@ -0,0 +1,109 @@
+/***********************************************************************//**
+ * Generates training data by making AIPlayer play against itself.
+ *
+ * Games are played in parallel, each thread with its own Board, AIPlayer and
+ * transposition table, taking the next game number from a shared counter.
+ * A game starts with a few random moves, so that games don't repeat,
+ * then each move is searched with a fixed depth and node limit. The table is
+ * cleared before each game, so a game only depends on its number and the seed.
+ *
+ * Board doesn't detect draws by repetition, the 50 moves rule or insufficient
+ * material, so the games are adjudicated here. A game is also won when the
+ * searches of both players agree for a few moves that one side is far ahead,
+ * and drawn when it gets too long.
+ *
+ * The searched positions are written with their score and the game's result
+ * in TrainingData's packed format, a whole game at a time. Positions in check
+ * and positions whose best move is a capture are left out: their static evaluation
+ * is far from their score.
+ ***************************************************************************/
+
+#ifndef SELFPLAY_H
+#define SELFPLAY_H
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "AIPlayer.h"
+#include "Board.h"
+#include "TrainingData.h"
+
+class SelfPlay {
+  public:
+    static const int DEFAULT_RANDOM_PLIES = 8;
+    static const int MAX_GAME_PLIES = 400; /**< Longer games are drawn */
+    static const int WIN_SCORE = 1000; /**< A game is won when the score stays over this value... */
+    static const int WIN_PLIES = 8; /**< ...for this number of half-turns */
+
+    /**
+     * @param numThreads: the number of games played at the same time. 0 to use all cores.
+     */
+    SelfPlay(int numThreads = 0);
+    ~SelfPlay() {}
+
+    /**
+     * Set the limits of each move's search.
+     * @param depth: the maximum number of half-turns to look ahead.
+     * @param nodes: the maximum number of nodes, 0 for no limit.
+     */
+    void setLimits(int depth, long long nodes);
+
+    /**
+     * Set how games start.
+     * @param randomPlies: the number of random moves played before the searches.
+     * @param seed: the seed of the random moves, a game's moves depend on it and the game's number.
+     */
+    void setOpenings(int randomPlies, uint64_t seed);
+
+    /**
+     * Play games and write their positions to a new file.
+     * @param numGames: the number of games.
+     * @param path: the training data file, replaced.
+     * @return false if the file can't be written.
+     */
+    bool run(int numGames, std::string path);
+
+    long long getNumGames() { return numGames; }
+    long long getNumPositions() { return writer.getNumPositions(); }
+    long long getNumWins(int color) { return numWins[color]; } /**< @param color: WHITE, BLACK or BOTH_COLOR (draws) */
+
+  private:
+    int numThreads;
+    int maxDepth;
+    long long maxNodes;
+    int randomPlies;
+    uint64_t seed;
+
+    TrainingDataWriter writer;
+    std::atomic<long long> numGames;
+    std::atomic<long long> numWins[3]; /**< By winner: WHITE, BLACK, BOTH_COLOR */
+    std::atomic<bool> failed; /**< A write failed */
+
+    /**
+     * Play games taken from a shared counter until none is left.
+     */
+    void playGames(std::atomic<int>* nextGame, int numGames);
+
+    /**
+     * Play one game with the given board and AI.
+     * @param positions: receives the positions of the game to write, with their results.
+     * @return the winner: WHITE, BLACK or BOTH_COLOR.
+     */
+    int playGame(int gameNumber, Board& b, AIPlayer& ai, TranspositionTable& table,
+                 std::vector<PackedPosition>& positions);
+
+    /**
+     * @return WHITE, BLACK or BOTH_COLOR if the game is over (by mate or by a draw Board doesn't detect), -1 otherwise.
+     * @param keys: the keys of the positions since the last capture or pawn move, the current one last.
+     */
+    static int getGameResult(Board& b, const std::vector<uint64_t>& keys);
+
+    /**
+     * @return true if neither player has enough pieces to mate (kings alone, with at most a knight or bishop).
+     */
+    static bool isInsufficientMaterial(Board& b);
+};
+
+#endif // SELFPLAY_H
@@ -0,0 +1,69 @@
+#include "SpriteBatch.h"
+
+void SpriteBatch::add(SDL_Texture* texture, const SDL_Rect& src, const SDL_Rect& dst, Uint8 alpha) {
+  if (texture == NULL) return;
+  Sprite sprite = {texture, src, dst, alpha};
+  sprites.push_back(sprite);
+}
+
+int SpriteBatch::flush(SDL_Renderer* renderer) {
+  int drawCalls = 0;
+  int begin = 0;
+  for (int i = 1; i <= sprites.size(); i++) {
+    // a run ends where the texture changes
+    if (i == sprites.size() || sprites[i].texture != sprites[begin].texture) {
+      drawCalls += drawRun(renderer, begin, i);
+      begin = i;
+    }
+  }
+  sprites.clear();
+  return drawCalls;
+}
+
+int SpriteBatch::drawRun(SDL_Renderer* renderer, int begin, int end) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  SDL_Texture* texture = sprites[begin].texture;
+  int width, height;
+  if (SDL_QueryTexture(texture, NULL, NULL, &width, &height) != 0) return 0;
+
+  vertices.clear();
+  indices.clear();
+  for (int i = begin; i < end; i++) {
+    const Sprite& sprite = sprites[i];
+    SDL_Color color = {0xFF, 0xFF, 0xFF, sprite.alpha};
+    float u1 = (float) sprite.src.x / width;
+    float v1 = (float) sprite.src.y / height;
+    float u2 = (float) (sprite.src.x + sprite.src.w) / width;
+    float v2 = (float) (sprite.src.y + sprite.src.h) / height;
+    float x1 = sprite.dst.x;
+    float y1 = sprite.dst.y;
+    float x2 = sprite.dst.x + sprite.dst.w;
+    float y2 = sprite.dst.y + sprite.dst.h;
+
+    // corners: top left, top right, bottom right, bottom left
+    int first = vertices.size();
+    SDL_Vertex corners[4] = {
+      {{x1, y1}, color, {u1, v1}},
+      {{x2, y1}, color, {u2, v1}},
+      {{x2, y2}, color, {u2, v2}},
+      {{x1, y2}, color, {u1, v2}}
+    };
+    vertices.insert(vertices.end(), corners, corners + 4);
+    int quad[6] = {first, first + 1, first + 2, first, first + 2, first + 3};
+    indices.insert(indices.end(), quad, quad + 6);
+  }
+  if (SDL_RenderGeometry(renderer, texture, &vertices[0], vertices.size(), &indices[0], indices.size()) == 0) return 1;
+  // not supported by this renderer
+#endif
+  return copyRun(renderer, begin, end);
+}
+
+int SpriteBatch::copyRun(SDL_Renderer* renderer, int begin, int end) {
+  for (int i = begin; i < end; i++) {
+    const Sprite& sprite = sprites[i];
+    SDL_SetTextureAlphaMod(sprite.texture, sprite.alpha);
+    SDL_RenderCopy(renderer, sprite.texture, &sprite.src, &sprite.dst);
+  }
+  if (end > begin) SDL_SetTextureAlphaMod(sprites[begin].texture, 0xFF);
+  return end - begin;
+}
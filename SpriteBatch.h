@@ -0,0 +1,61 @@
+/***********************************************************************//**
+ * Collects sprites (rectangles of textures) and draws them with as few draw calls as possible.
+ * Consecutive sprites of the same texture (e.g. images of the same ResourceManager atlas)
+ * become one SDL_RenderGeometry call, with two triangles per sprite and the sprite's
+ * transparency in its vertices' color, so fading a sprite doesn't change the texture's state.
+ * Without SDL_RenderGeometry (SDL older than 2.0.18, or not supported by the renderer),
+ * the sprites are drawn one by one with SDL_RenderCopy.
+ ***************************************************************************/
+
+#ifndef SPRITEBATCH_H
+#define SPRITEBATCH_H
+
+#include <SDL2/SDL.h>
+#include <vector>
+
+class SpriteBatch {
+  public:
+    SpriteBatch() {}
+    ~SpriteBatch() {}
+
+    /**
+     * Queue a sprite, drawn over the sprites queued before it.
+     * @param texture: the texture to draw from.
+     * @param src: the rectangle of the texture to draw.
+     * @param dst: where to draw it on the render target.
+     * @param alpha: between 0 and 255, 0 is transparent, 255 is opaque.
+     */
+    void add(SDL_Texture* texture, const SDL_Rect& src, const SDL_Rect& dst, Uint8 alpha = 0xFF);
+
+    /**
+     * Draw the queued sprites, and empty the queue.
+     * @return the number of draw calls.
+     */
+    int flush(SDL_Renderer* renderer);
+
+  private:
+    struct Sprite {
+      SDL_Texture* texture;
+      SDL_Rect src, dst;
+      Uint8 alpha;
+    };
+
+    std::vector<Sprite> sprites;
+    // kept between flushes so that drawing doesn't allocate
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+
+    /**
+     * Draw sprites[begin, end), which all have the same texture, in one call if possible.
+     * @return the number of draw calls.
+     */
+    int drawRun(SDL_Renderer* renderer, int begin, int end);
+
+    /**
+     * Draw sprites[begin, end) with one SDL_RenderCopy each.
+     * @return the number of draw calls.
+     */
+    int copyRun(SDL_Renderer* renderer, int begin, int end);
+};
+
+#endif // SPRITEBATCH_H
@@ -1,5 +1,3 @@
-#include <stdio.h>
-
 #include "StartGUI.h"
 
 const int StartGUI::singleButtonX = 254;
@@ -8,16 +6,15 @@ const int StartGUI::multiButtonX = 254;
 const int StartGUI::multiButtonY = 268;
 const int StartGUI::quitButtonX = 254;
 const int StartGUI::quitButtonY = 400;
-const float StartGUI::speed = 2;
 
-StartGUI::StartGUI(SDL_Renderer* renderer) {
+StartGUI::StartGUI(ResourceManager& resources) {
   ///////////////////////////////////////////////////////////////////////
   //                               Visual
   ///////////////////////////////////////////////////////////////////////
-  singleButton.loadFromFile(renderer, "img/startGUI/single-player.png");
-  multiButton.loadFromFile(renderer, "img/startGUI/multi-player.png");
-  quitButton.loadFromFile(renderer, "img/startGUI/quit.png");
-  background.loadFromFile(renderer, "img/startGUI/background.jpg");
+  resources.load(&singleButton, "img/startGUI/single-player.png");
+  resources.load(&multiButton, "img/startGUI/multi-player.png");
+  resources.load(&quitButton, "img/startGUI/quit.png");
+  resources.load(&background, "img/startGUI/background.jpg");
 
   boxes.push_back(Box(singleButtonX, singleButtonY, singleButtonX + 292, singleButtonY + 94, INPUT_SINGLE_PLAYER));
   boxes.push_back(Box(multiButtonX, multiButtonY, multiButtonX + 292, multiButtonY + 94, INPUT_MULTI_PLAYER));
@@ -26,45 +23,43 @@ StartGUI::StartGUI(SDL_Renderer* renderer) {
   ///////////////////////////////////////////////////////////////////////
   //                               Audio
   ///////////////////////////////////////////////////////////////////////
-  startbmg = Mix_LoadMUS("sound/start bgm.mp3");
-  if (!startbmg) {
-    printf("Failed to load music; %s\n", Mix_GetError());
-  }
+  resources.loadMusic(&startbmg, "sound/start bgm.mp3");
 }
 
 StartGUI::~StartGUI() {}
 
 void StartGUI::draw(SDL_Renderer* renderer)
 {
-  openAnimation(renderer);
+  // the buttons come from outside the screen: 292 is their width
+  float t = buttonSlide.getValue(scheduler.getFrameTicks());
+  float sBX = -292 + (singleButtonX + 292) * t;
+  float mBX = 800 + (multiButtonX - 800) * t;
+  float qBX = -292 + (quitButtonX + 292) * t;
+
   background.render(renderer, NULL, NULL);
-  singleButton.render(renderer, singleButtonX, singleButtonY, NULL, NULL);
-  multiButton.render(renderer, multiButtonX, multiButtonY, NULL, NULL);
-  quitButton.render(renderer, quitButtonX, quitButtonY, NULL, NULL);
+  singleButton.render(renderer, sBX, singleButtonY, NULL, NULL);
+  multiButton.render(renderer, mBX, multiButtonY, NULL, NULL);
+  quitButton.render(renderer, qBX, quitButtonY, NULL, NULL);
 
   SDL_RenderPresent(renderer);
 }
 
-void StartGUI::openAnimation(SDL_Renderer* renderer)
+void StartGUI::startAnimation()
+{
+  buttonSlide.start(0, 1, OPEN_ANIMATION_MS, SDL_GetTicks());
+  scheduler.requestFrame();
+}
+
+bool StartGUI::isAnimating()
+{
+  return buttonSlide.isRunning(SDL_GetTicks());
+}
+
+bool StartGUI::skipAnimation()
 {
-  float sBX = -292;
-  float mBX = 800;
-  float qBX = -292;
-  while(true)
-  {
-    background.render(renderer, NULL, NULL);
-    singleButton.render(renderer, sBX, singleButtonY, NULL, NULL);
-    multiButton.render(renderer, mBX, multiButtonY, NULL, NULL);
-    quitButton.render(renderer, qBX, quitButtonY, NULL, NULL);
-    SDL_RenderPresent(renderer);
-    sBX += speed;
-    mBX -= speed;
-    qBX += speed;
-    if (sBX > singleButtonX)
-    {
-      break;
-    }
-  }
+  if (!isAnimating()) return false;
+  buttonSlide.finish();
+  return true;
 }
 
 void StartGUI::playMusic() {
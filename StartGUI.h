@@ -2,7 +2,9 @@
 #define STARTGUI_H
 
 #include "GUI.h"
+#include "ResourceManager.h"
 #include "TextureWrapper.h"
+#include "Tween.h"
 #include <SDL2/SDL_mixer.h>
 
 
@@ -14,11 +16,24 @@ class StartGUI: public GUI {
       INPUT_QUIT,
     };
 
-    StartGUI(SDL_Renderer* renderer);
+    /**
+     * @param resources: loads the images and sounds (usable after resources.build()).
+     */
+    StartGUI(ResourceManager& resources);
     ~StartGUI();
 
+    /**
+     * Draw the start screen, with the buttons where the open animation has moved them.
+     */
     void draw(SDL_Renderer* renderer);
 
+    /**
+     * Start sliding the buttons in from the sides. Frames are drawn by drawFrame.
+     */
+    void startAnimation();
+
+    bool isAnimating();
+
     void playMusic();
     void stopMusic();
 
@@ -40,9 +55,11 @@ class StartGUI: public GUI {
     static const int multiButtonY;
     static const int quitButtonX;
     static const int quitButtonY;
-    static const float speed; /**< The speed of the open animation */
+    static const int OPEN_ANIMATION_MS = 600; /**< The duration of the open animation */
+
+    Tween buttonSlide; /**< Progress of the open animation, from 0 (buttons outside the screen) to 1 */
 
-    void openAnimation(SDL_Renderer* renderer);
+    bool skipAnimation();
 
     /************************************************************
      *                        Audio
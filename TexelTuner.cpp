@@ -0,0 +1,346 @@
+#include <math.h>
+#include <stdio.h>
+#include <thread>
+
+#include "PawnHashTable.h"
+#include "TexelTuner.h"
+
+TexelTuner::TexelTuner(int numThreads) {
+  this->numThreads = (numThreads > 0)? numThreads : std::thread::hardware_concurrency();
+  if (this->numThreads < 1) this->numThreads = 1;
+  K = 1;
+
+  // start from AIPlayer's current values
+  params.resize(NUM_PARAMS);
+  for (int t = 0; t < Board::NUM_PIECE_TYPES; t++) {
+    params[t] = AIPlayer::pieceValues[t];
+  }
+  for (int t = 0; t <= Board::NUM_PIECE_TYPES; t++) {
+    for (int s = 0; s < Board::NUM_SQUARES; s++) {
+      params[Board::NUM_PIECE_TYPES + t * Board::NUM_SQUARES + s] = AIPlayer::positionValues[t][s];
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                          Loading positions
+////////////////////////////////////////////////////////////////////////////
+
+bool TexelTuner::loadPositions(std::string path) {
+  FILE* file = fopen(path.c_str(), "r");
+  if (file == NULL) {
+    printf("Unable to open position file %s\n", path.c_str());
+    return false;
+  }
+  std::vector<std::string> lines;
+  char buffer[512];
+  while (fgets(buffer, sizeof(buffer), file) != NULL) {
+    lines.push_back(buffer);
+  }
+  fclose(file);
+
+  // parse slices of the file in parallel, then append the slices in order
+  std::vector< std::vector<Position> > slicePositions(numThreads);
+  std::vector< std::vector<uint16_t> > sliceTerms(numThreads);
+  std::vector<std::thread> threads;
+  int sliceSize = (lines.size() + numThreads - 1) / numThreads;
+  for (int t = 0; t < numThreads; t++) {
+    int begin = t * sliceSize;
+    int end = (begin + sliceSize < lines.size())? begin + sliceSize : lines.size();
+    threads.push_back(std::thread(&TexelTuner::parseLines, this, std::cref(lines), begin, end,
+                                  std::ref(slicePositions[t]), std::ref(sliceTerms[t])));
+  }
+  for (int t = 0; t < numThreads; t++) {
+    threads[t].join();
+    for (int i = 0; i < slicePositions[t].size(); i++) {
+      Position pos = slicePositions[t][i];
+      pos.firstTerm += terms.size();
+      positions.push_back(pos);
+    }
+    terms.insert(terms.end(), sliceTerms[t].begin(), sliceTerms[t].end());
+  }
+  printf("Loaded %i positions (%i lines)\n", (int) positions.size(), (int) lines.size());
+  return !positions.empty();
+}
+
+void TexelTuner::parseLines(const std::vector<std::string>& lines, int begin, int end,
+                            std::vector<Position>& outPositions, std::vector<uint16_t>& outTerms) {
+  Board b;
+  std::vector<int> pv;
+  for (int i = begin; i < end; i++) {
+    const std::string& line = lines[i];
+
+    // result
+    int result;
+    if (line.find("1/2-1/2") != std::string::npos || line.find("[0.5]") != std::string::npos) {
+      result = 1;
+    } else if (line.find("1-0") != std::string::npos || line.find("[1.0]") != std::string::npos) {
+      result = 2;
+    } else if (line.find("0-1") != std::string::npos || line.find("[0.0]") != std::string::npos) {
+      result = 0;
+    } else {
+      continue; // unlabeled line
+    }
+
+    if (!b.loadFEN(line)) continue;
+    if (b.isKingChecked() || b.getNumMoves() == 0) continue;
+
+    // go to the quiet leaf of the position
+    quiesce(b, -100000, 100000, MAX_QUIESCENCE_DEPTH, pv);
+    for (int m = 0; m < pv.size(); m++) b.makeMove(pv[m]);
+
+    // material decides whether the king uses the late game table, as in AIPlayer::heuristicEval
+    int material = 0;
+    for (int s = 0; s < Board::NUM_SQUARES; s++) {
+      int piece = b.getPiece(s);
+      if (piece != Board::EMPTY) material += AIPlayer::pieceValues[piece % Board::NUM_PIECE_TYPES];
+    }
+    bool lateGame = material <= AIPlayer::LATE_GAME_MATERIAL;
+
+    Position pos;
+    pos.firstTerm = outTerms.size();
+    pos.numTerms = 0;
+    pos.result = result;
+    pos.fixedScore = PawnHashTable::evaluate(&b);
+    for (int s = 0; s < Board::NUM_SQUARES; s++) {
+      int piece = b.getPiece(s);
+      if (piece == Board::EMPTY) continue;
+      bool black = piece <= Board::MAX_BLACK_TYPE;
+      int type = piece % Board::NUM_PIECE_TYPES;
+      int table = type;
+      int index = s;
+      if (type == Board::BK) {
+        if (lateGame) table = Board::NUM_PIECE_TYPES;
+        if (!black) index = 56 + 2*(s % Board::COLS) - s; // flips the board vertically
+      } else if (!black) {
+        index = 63 - s; // same flip as in heuristicEval
+      }
+      outTerms.push_back((black? 0x8000 : 0) | (table << 6) | index);
+      pos.numTerms++;
+    }
+    outPositions.push_back(pos);
+  }
+}
+
+int TexelTuner::evaluate(Board& b) {
+  int score = 0;
+  int material = 0;
+  for (int s = 0; s < Board::NUM_SQUARES; s++) {
+    int piece = b.getPiece(s);
+    if (piece == Board::EMPTY || piece == Board::WK || piece == Board::BK) continue;
+    int type = piece % Board::NUM_PIECE_TYPES;
+    int value = (int) params[type];
+    material += value;
+    if (piece > Board::MAX_BLACK_TYPE) {
+      score += value + (int) params[Board::NUM_PIECE_TYPES + type * Board::NUM_SQUARES + 63 - s];
+    } else {
+      score -= value + (int) params[Board::NUM_PIECE_TYPES + type * Board::NUM_SQUARES + s];
+    }
+  }
+  int kingTable = (material > AIPlayer::LATE_GAME_MATERIAL)? Board::BK : Board::NUM_PIECE_TYPES;
+  int kingSq = b.getKingSquare(Board::WHITE);
+  score += (int) params[Board::NUM_PIECE_TYPES + kingTable * Board::NUM_SQUARES + 56 + 2*(kingSq % Board::COLS) - kingSq];
+  kingSq = b.getKingSquare(Board::BLACK);
+  score -= (int) params[Board::NUM_PIECE_TYPES + kingTable * Board::NUM_SQUARES + kingSq];
+  return score + PawnHashTable::evaluate(&b);
+}
+
+int TexelTuner::quiesce(Board& b, int alpha, int beta, int depth, std::vector<int>& pv) {
+  pv.clear();
+  int standPat = (b.getPlayer()? -1 : 1) * evaluate(b);
+  if (depth == 0 || b.getNumMoves() == 0 || standPat >= beta) return standPat;
+  if (standPat > alpha) alpha = standPat;
+
+  // captures, most valuable victim first, then least valuable attacker first
+  Board::View moveList = b.getMoveListView();
+  std::vector<int> captures;
+  std::vector<int> order;
+  int numMoves = b.getNumMoves();
+  for (int m = 0; m < numMoves; m++) {
+    int victim = b.getPiece(moveList[m * Board::MOVE_LENGTH_MOVE_LIST + 1]);
+    int moveType = moveList[m * Board::MOVE_LENGTH_MOVE_LIST + 2];
+    if (victim == Board::EMPTY && moveType != Board::MOVE_PAWN_EN_PASSANT) continue; // not a capture
+    int victimValue = (victim == Board::EMPTY)? AIPlayer::pieceValues[Board::BP]
+                                              : AIPlayer::pieceValues[victim % Board::NUM_PIECE_TYPES];
+    int attacker = b.getPiece(moveList[m * Board::MOVE_LENGTH_MOVE_LIST]) % Board::NUM_PIECE_TYPES;
+    int key = victimValue * 16 - AIPlayer::pieceValues[attacker] / 100;
+    int n = captures.size();
+    captures.push_back(m);
+    order.push_back(key);
+    while (n > 0 && order[n-1] < key) { // insertion sort
+      captures[n] = captures[n-1];
+      order[n] = order[n-1];
+      n--;
+    }
+    captures[n] = m;
+    order[n] = key;
+  }
+
+  std::vector<int> childPv;
+  for (int i = 0; i < captures.size(); i++) {
+    int m = captures[i];
+    b.makeMove(m);
+    int score = -quiesce(b, -beta, -alpha, depth - 1, childPv);
+    b.undoMove();
+    if (score > alpha) {
+      alpha = score;
+      pv.clear();
+      pv.push_back(m);
+      pv.insert(pv.end(), childPv.begin(), childPv.end());
+      if (alpha >= beta) break;
+    }
+  }
+  return alpha;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                               Tuning
+////////////////////////////////////////////////////////////////////////////
+
+double TexelTuner::sigmoid(double score) {
+  return 1.0 / (1.0 + pow(10.0, -K * score / 400.0));
+}
+
+double TexelTuner::evaluate(const Position& pos) {
+  double score = pos.fixedScore;
+  const uint16_t* term = &terms[pos.firstTerm];
+  for (int i = 0; i < pos.numTerms; i++) {
+    int table = (term[i] >> 6) & 7;
+    int index = term[i] & 63;
+    int material = (table == Board::NUM_PIECE_TYPES)? Board::BK : table;
+    double value = params[material] + params[Board::NUM_PIECE_TYPES + table * Board::NUM_SQUARES + index];
+    score += (term[i] & 0x8000)? -value : value;
+  }
+  return score;
+}
+
+double TexelTuner::computeGradient(int begin, int end, std::vector<double>& grad) {
+  double error = 0;
+  for (int i = begin; i < end; i++) {
+    const Position& pos = positions[i];
+    double sig = sigmoid(evaluate(pos));
+    double diff = pos.result / 2.0 - sig;
+    error += diff * diff;
+    // d(diff^2)/d(score) = -2 * diff * sig' ; sig' = sig * (1 - sig) * K * ln(10) / 400
+    double dScore = -2 * diff * sig * (1 - sig) * K * log(10.0) / 400.0;
+    const uint16_t* term = &terms[pos.firstTerm];
+    for (int t = 0; t < pos.numTerms; t++) {
+      int table = (term[t] >> 6) & 7;
+      int index = term[t] & 63;
+      int material = (table == Board::NUM_PIECE_TYPES)? Board::BK : table;
+      double d = (term[t] & 0x8000)? -dScore : dScore;
+      grad[material] += d;
+      grad[Board::NUM_PIECE_TYPES + table * Board::NUM_SQUARES + index] += d;
+    }
+  }
+  return error;
+}
+
+double TexelTuner::computeError() {
+  std::vector<double> errors(numThreads, 0);
+  std::vector< std::vector<double> > grads(numThreads, std::vector<double>(NUM_PARAMS, 0));
+  std::vector<std::thread> threads;
+  int sliceSize = (positions.size() + numThreads - 1) / numThreads;
+  for (int t = 0; t < numThreads; t++) {
+    int begin = t * sliceSize;
+    int end = (begin + sliceSize < positions.size())? begin + sliceSize : positions.size();
+    threads.push_back(std::thread([this, begin, end, t, &errors, &grads]() {
+      errors[t] = computeGradient(begin, end, grads[t]);
+    }));
+  }
+  double error = 0;
+  for (int t = 0; t < numThreads; t++) {
+    threads[t].join();
+    error += errors[t];
+  }
+  return error / positions.size();
+}
+
+void TexelTuner::fitK() {
+  // ternary search, the error is convex in K around its minimum
+  double lo = 0.1, hi = 3.0;
+  for (int i = 0; i < 30; i++) {
+    double k1 = lo + (hi - lo) / 3;
+    double k2 = hi - (hi - lo) / 3;
+    K = k1;
+    double e1 = computeError();
+    K = k2;
+    double e2 = computeError();
+    if (e1 < e2) hi = k2; else lo = k1;
+  }
+  K = (lo + hi) / 2;
+  printf("K = %.4f, error = %.6f\n", K, computeError());
+}
+
+void TexelTuner::tune(int numEpochs) {
+  if (positions.empty()) return;
+  fitK();
+
+  // Adam optimizer
+  const double LEARNING_RATE = 1.0;
+  const double BETA1 = 0.9;
+  const double BETA2 = 0.999;
+  std::vector<double> m(NUM_PARAMS, 0), v(NUM_PARAMS, 0);
+
+  for (int epoch = 1; epoch <= numEpochs; epoch++) {
+    // each thread sums the gradient of its own slice
+    std::vector< std::vector<double> > grads(numThreads, std::vector<double>(NUM_PARAMS, 0));
+    std::vector<double> errors(numThreads, 0);
+    std::vector<std::thread> threads;
+    int sliceSize = (positions.size() + numThreads - 1) / numThreads;
+    for (int t = 0; t < numThreads; t++) {
+      int begin = t * sliceSize;
+      int end = (begin + sliceSize < positions.size())? begin + sliceSize : positions.size();
+      threads.push_back(std::thread([this, begin, end, t, &errors, &grads]() {
+        errors[t] = computeGradient(begin, end, grads[t]);
+      }));
+    }
+    double error = 0;
+    std::vector<double> grad(NUM_PARAMS, 0);
+    for (int t = 0; t < numThreads; t++) {
+      threads[t].join();
+      error += errors[t];
+      for (int p = 0; p < NUM_PARAMS; p++) grad[p] += grads[t][p];
+    }
+
+    for (int p = 0; p < NUM_PARAMS; p++) {
+      if (p == Board::BK) continue; // the king's value is not a real parameter
+      double g = grad[p] / positions.size();
+      m[p] = BETA1 * m[p] + (1 - BETA1) * g;
+      v[p] = BETA2 * v[p] + (1 - BETA2) * g * g;
+      double mHat = m[p] / (1 - pow(BETA1, epoch));
+      double vHat = v[p] / (1 - pow(BETA2, epoch));
+      params[p] -= LEARNING_RATE * mHat / (sqrt(vHat) + 1e-8);
+    }
+    printf("Epoch %i: error = %.6f\n", epoch, error / positions.size());
+  }
+}
+
+bool TexelTuner::writeParameters(std::string path) {
+  FILE* file = fopen(path.c_str(), "w");
+  if (file == NULL) {
+    printf("Unable to write to %s\n", path.c_str());
+    return false;
+  }
+  fprintf(file, "const int AIPlayer::pieceValues[6] = {");
+  for (int t = 0; t < Board::NUM_PIECE_TYPES; t++) {
+    fprintf(file, "%s%i", t? ", " : "", (int) lround(params[t]));
+  }
+  fprintf(file, "};\n\n");
+
+  const char* names[7] = {"queen", "king", "rook", "knight", "bishop", "pawn", "king late game"};
+  fprintf(file, "const int AIPlayer::positionValues[7][64] = {\n");
+  for (int t = 0; t <= Board::NUM_PIECE_TYPES; t++) {
+    fprintf(file, "  { //%s\n", names[t]);
+    for (int s = 0; s < Board::NUM_SQUARES; s++) {
+      if (s % Board::COLS == 0) fprintf(file, "    ");
+      fprintf(file, "%3i", (int) lround(params[Board::NUM_PIECE_TYPES + t * Board::NUM_SQUARES + s]));
+      if (s != Board::NUM_SQUARES - 1) fprintf(file, ",");
+      if (s % Board::COLS == Board::COLS - 1) fprintf(file, "\n");
+    }
+    fprintf(file, (t == Board::NUM_PIECE_TYPES)? "  }\n" : "  },\n");
+  }
+  fprintf(file, "};\n");
+  fclose(file);
+  return true;
+}
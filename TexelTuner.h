@@ -0,0 +1,131 @@
+/***********************************************************************//**
+ * Offline tuner for AIPlayer's evaluation (Texel's tuning method).
+ * Reads positions labeled with the game's result, and minimizes the error
+ * between the game result and a sigmoid of the evaluation,
+ * over AIPlayer::pieceValues and all AIPlayer::positionValues tables.
+ *
+ * Each position is resolved once with a captures-only quiescence search,
+ * and its quiet leaf is stored in a compact form (one 16 bit term per piece),
+ * so an epoch over millions of positions does not touch Board at all.
+ * Epochs are split across threads.
+ ***************************************************************************/
+
+#ifndef TEXELTUNER_H
+#define TEXELTUNER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "AIPlayer.h"
+#include "Board.h"
+
+class TexelTuner {
+  public:
+    /**
+     * @param numThreads: the number of threads used to load positions and compute gradients.
+     * 0 to use all cores.
+     */
+    TexelTuner(int numThreads = 0);
+    ~TexelTuner() {}
+
+    /**
+     * Load labeled positions from a file. Each line has a FEN followed by the result,
+     * either as "1-0", "0-1", "1/2-1/2", or as "[1.0]", "[0.5]", "[0.0]".
+     * Positions where the player to move is checked are skipped.
+     * @param path: path to the file.
+     * @return true if at least one position was loaded.
+     */
+    bool loadPositions(std::string path);
+
+    /**
+     * Run gradient descent (Adam) over all parameters.
+     * @param numEpochs: the number of passes over all positions.
+     */
+    void tune(int numEpochs);
+
+    /**
+     * Write the parameters as C++ definitions in the layout used in AIPlayer.cpp.
+     * @param path: path to the output file.
+     * @return true if written successfully.
+     */
+    bool writeParameters(std::string path);
+
+  private:
+    /**
+     * A position in compact form. Its pieces are stored in the terms array,
+     * from firstTerm to firstTerm + numTerms - 1.
+     */
+    struct Position {
+      uint32_t firstTerm;
+      uint8_t numTerms;
+      uint8_t result; /**< 0: black won, 1: draw, 2: white won */
+      int16_t fixedScore; /**< The part of the evaluation that is not tuned (pawn structure) */
+    };
+
+    /**
+     * One piece of a position.
+     * Bit 15: 1 if black. Bits 6 -> 8: table index of positionValues (6 for the late game king).
+     * Bits 0 -> 5: index in the table (already flipped for white).
+     */
+    std::vector<uint16_t> terms;
+    std::vector<Position> positions;
+
+    /**
+     * All parameters: pieceValues (6), followed by positionValues (7 * 64).
+     */
+    std::vector<double> params;
+    static const int NUM_PARAMS = Board::NUM_PIECE_TYPES + (Board::NUM_PIECE_TYPES + 1) * Board::NUM_SQUARES;
+    static const int MAX_QUIESCENCE_DEPTH = 8;
+
+    int numThreads;
+    double K; /**< Scaling of the sigmoid, fitted to the data before tuning */
+
+    /**
+     * Evaluate a board with the current parameters (same formula as AIPlayer::heuristicEval).
+     * @return the score of the board (in white's perspective)
+     */
+    int evaluate(Board& b);
+
+    /**
+     * Captures-only search used to find the quiet leaf of a position.
+     * @param pv: filled with the moves (move numbers) leading to the leaf.
+     * @return the score for the player to move.
+     */
+    int quiesce(Board& b, int alpha, int beta, int depth, std::vector<int>& pv);
+
+    /**
+     * Parse lines into compact positions.
+     * @param lines: lines of the position file.
+     * @param begin, end: the range of lines to parse.
+     * @param outPositions, outTerms: receive the parsed positions (firstTerm relative to outTerms).
+     */
+    void parseLines(const std::vector<std::string>& lines, int begin, int end,
+                    std::vector<Position>& outPositions, std::vector<uint16_t>& outTerms);
+
+    /**
+     * Evaluate a compact position with the current parameters.
+     */
+    double evaluate(const Position& pos);
+
+    /**
+     * Compute the error over a range of positions, and add its gradient to grad.
+     * @param grad: must have NUM_PARAMS elements.
+     * @return the sum of squared errors over the range.
+     */
+    double computeGradient(int begin, int end, std::vector<double>& grad);
+
+    /**
+     * @return the mean squared error over all positions, using all threads.
+     */
+    double computeError();
+
+    /**
+     * Find the K that minimizes the error of the current parameters.
+     */
+    void fitK();
+
+    double sigmoid(double score);
+};
+
+#endif // TEXELTUNER_H
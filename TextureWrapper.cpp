@@ -7,6 +7,8 @@ TextureWrapper::TextureWrapper()
   texture = NULL;
   textureHeight = 0;
   textureWidth = 0;
+  region = {0, 0, 0, 0};
+  ownsTexture = true;
 }
 
 TextureWrapper::~TextureWrapper()
@@ -46,14 +48,33 @@ bool TextureWrapper::loadFromFile(SDL_Renderer* renderer, std::string path)
   SDL_FreeSurface(loadedImage);
 
   texture = newTexture;
+  region = {0, 0, textureWidth, textureHeight};
+  ownsTexture = true;
   return texture != NULL;
 }
 
+void TextureWrapper::setRegion(SDL_Texture* atlas, SDL_Rect rect)
+{
+  destroyTexture();
+  texture = atlas;
+  region = rect;
+  textureWidth = rect.w;
+  textureHeight = rect.h;
+  ownsTexture = false;
+}
+
+SDL_Rect TextureWrapper::toTextureRect(SDL_Rect* crop)
+{
+  if (crop == NULL) return region;
+  SDL_Rect rect = {region.x + crop->x, region.y + crop->y, crop->w, crop->h};
+  return rect;
+}
+
 void TextureWrapper::destroyTexture()
 {
   if (texture != NULL)
   {
-    SDL_DestroyTexture(texture);
+    if (ownsTexture) SDL_DestroyTexture(texture);
     texture = NULL;
   }
 }
@@ -85,10 +106,23 @@ void TextureWrapper::render(SDL_Renderer* renderer, int x, int y, SDL_Rect* crop
     }
 
   }
-  SDL_RenderCopy(renderer, texture, crop, &renderQuad);
+  SDL_Rect src = toTextureRect(crop);
+  SDL_RenderCopy(renderer, texture, &src, &renderQuad);
 }
 
 void TextureWrapper::render(SDL_Renderer* renderer, SDL_Rect* crop, SDL_Rect* dst)
 {
-  SDL_RenderCopy(renderer, texture, crop, dst);
+  SDL_Rect src = toTextureRect(crop);
+  SDL_RenderCopy(renderer, texture, &src, dst);
+}
+
+void TextureWrapper::render(SpriteBatch& batch, int x, int y)
+{
+  SDL_Rect dst = {x, y, textureWidth, textureHeight};
+  batch.add(texture, region, dst);
+}
+
+void TextureWrapper::render(SpriteBatch& batch, SDL_Rect* crop, SDL_Rect* dst, Uint8 alpha)
+{
+  batch.add(texture, toTextureRect(crop), *dst, alpha);
 }
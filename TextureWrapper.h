@@ -4,6 +4,8 @@
 #include <SDL2/SDL.h>
 #include <string>
 
+#include "SpriteBatch.h"
+
 /**
  * Contain image data
  * and functions to load and draw image on screen
@@ -28,6 +30,14 @@ class TextureWrapper
      */
     bool loadFromFile(SDL_Renderer* renderer, std::string path);
 
+    /**
+     * Draw a region of a texture owned by someone else (an atlas of ResourceManager)
+     * instead of a texture of its own.
+     * @param atlas the texture containing the image
+     * @param rect the image's position in the texture
+     */
+    void setRegion(SDL_Texture* atlas, SDL_Rect rect);
+
     /**
      * Enable image blending (opaque <-> transparent)
      * @param one of the SDL_BlendMode const
@@ -37,6 +47,7 @@ class TextureWrapper
     /**
      * Set the transparency of texture.
      * Must call setBlendMode at first.
+     * With an atlas, this applies to every image of the atlas, so set it back after drawing.
      * @param alpha between 0 and 255, 0 is transparent, 255 is opaque.
      */
     void setTransparency (Uint8 alpha);
@@ -60,6 +71,24 @@ class TextureWrapper
      */
     void render(SDL_Renderer* renderer, SDL_Rect* crop = NULL, SDL_Rect* dst = NULL);
 
+    /**
+     * Queue the image in a sprite batch, drawn when the batch is flushed
+     *
+     * @param batch the batch to add the image to
+     * @param x,y coordinate of left upper point of the screen rectangle (the image keeps its size)
+     */
+    void render(SpriteBatch& batch, int x, int y);
+
+    /**
+     * Queue a rectangle region of the image in a sprite batch, drawn when the batch is flushed
+     *
+     * @param batch the batch to add the image to
+     * @param crop only the part of the texture in side this rectangle is drawn
+     * @param dst the texture part will fill in this rectangle on screen
+     * @param alpha between 0 and 255, 0 is transparent, 255 is opaque (only for this sprite).
+     */
+    void render(SpriteBatch& batch, SDL_Rect* crop, SDL_Rect* dst, Uint8 alpha = 0xFF);
+
   private:
     /**
      * The texture being wrapped
@@ -71,6 +100,22 @@ class TextureWrapper
      */
     int textureHeight, textureWidth;
 
+    /**
+     * The image's position in the texture: the whole texture, or a region of an atlas
+     */
+    SDL_Rect region;
+
+    /**
+     * False when the texture is an atlas owned by ResourceManager
+     */
+    bool ownsTexture;
+
+    /**
+     * Convert a crop rectangle (relative to the image) to a rectangle of the texture
+     * @return the rectangle in the texture
+     */
+    SDL_Rect toTextureRect(SDL_Rect* crop);
+
     /**
      * Deallocate Texture
      */
@@ -0,0 +1,58 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int numThreads, int maxQueued) {
+  if (numThreads <= 0) numThreads = std::thread::hardware_concurrency();
+  if (numThreads < 1) numThreads = 1;
+  this->maxQueued = (maxQueued > 0)? maxQueued : 2 * numThreads;
+  numRunning = 0;
+  stopping = false;
+  for (int t = 0; t < numThreads; t++) {
+    threads.push_back(std::thread(&ThreadPool::workerLoop, this));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  jobAvailable.notify_all();
+  for (int t = 0; t < threads.size(); t++) {
+    threads[t].join();
+  }
+}
+
+bool ThreadPool::trySubmit(std::function<void()> job) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (jobs.size() >= maxQueued) return false;
+    jobs.push_back(job);
+  }
+  jobAvailable.notify_one();
+  return true;
+}
+
+int ThreadPool::getNumQueued() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return jobs.size();
+}
+
+int ThreadPool::getNumRunning() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return numRunning;
+}
+
+void ThreadPool::workerLoop() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    jobAvailable.wait(lock, [this]() { return !jobs.empty() || stopping; });
+    if (jobs.empty()) return; // stopping, and nothing left to run
+    std::function<void()> job = jobs.front();
+    jobs.pop_front();
+    numRunning++;
+    lock.unlock();
+    job();
+    lock.lock();
+    numRunning--;
+  }
+}
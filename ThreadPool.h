@@ -0,0 +1,58 @@
+/***********************************************************************//**
+ * A fixed number of worker threads running jobs from a bounded queue.
+ * A job is refused when the queue is full instead of waiting, so that the
+ * caller can tell its own client to come back later (back-pressure)
+ * rather than letting the queue grow without limit.
+ ***************************************************************************/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+  public:
+    /**
+     * @param numThreads: the number of worker threads. 0 to use all cores.
+     * @param maxQueued: the number of jobs waiting for a thread before jobs are refused.
+     * 0 for twice the number of threads.
+     */
+    ThreadPool(int numThreads = 0, int maxQueued = 0);
+
+    /**
+     * Run the queued jobs, then stop the threads.
+     */
+    ~ThreadPool();
+
+    /**
+     * Queue a job, run by the first free thread.
+     * @return false if the queue is full (the job is not queued).
+     */
+    bool trySubmit(std::function<void()> job);
+
+    int getNumThreads() { return threads.size(); }
+    int getNumQueued(); /**< The number of jobs waiting for a thread */
+    int getNumRunning(); /**< The number of jobs being run */
+
+  private:
+    std::vector<std::thread> threads;
+    int maxQueued;
+
+    std::mutex mutex; /**< Protects jobs, numRunning and stopping */
+    std::condition_variable jobAvailable;
+    std::deque<std::function<void()> > jobs;
+    int numRunning;
+    bool stopping; /**< Set by the destructor: threads return when the queue is empty */
+
+    /**
+     * Take jobs from the queue and run them, until stopping.
+     */
+    void workerLoop();
+};
+
+#endif // THREADPOOL_H
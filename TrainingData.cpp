@@ -0,0 +1,155 @@
+#include "TrainingData.h"
+
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////
+//                                 Packing
+////////////////////////////////////////////////////////////////////////////
+
+bool PackedPosition::pack(Board& b, int score, int result, int ply) {
+  occupancy = 0;
+  memset(pieces, 0, sizeof(pieces));
+  int numPieces = 0;
+  for (int s = 0; s < Board::NUM_SQUARES; s++) {
+    int piece = b.getPiece(s);
+    if (piece == Board::EMPTY) continue;
+    if (numPieces == MAX_PIECES) return false;
+    occupancy |= (uint64_t) 1 << s;
+    pieces[numPieces / 2] |= piece << (4 * (numPieces % 2));
+    numPieces++;
+  }
+  this->score = score;
+  state = b.getCastlingRights() | ((b.getPlayer() == Board::BLACK)? 16 : 0);
+  int file = b.getEnPassantFile();
+  enPassant = (file == -1)? NO_EN_PASSANT : file;
+  this->result = result;
+  reserved = 0;
+  this->ply = ply;
+  return true;
+}
+
+void PackedPosition::getPieces(int squares[Board::NUM_SQUARES]) const {
+  int numPieces = 0;
+  for (int s = 0; s < Board::NUM_SQUARES; s++) {
+    if (occupancy & ((uint64_t) 1 << s)) {
+      squares[s] = (pieces[numPieces / 2] >> (4 * (numPieces % 2))) & 15;
+      numPieces++;
+    } else {
+      squares[s] = Board::EMPTY;
+    }
+  }
+}
+
+std::string PackedPosition::toFEN() const {
+  static const char PIECE_CHARS[] = "qkrnbpQKRNBP"; // in the order of Board::PieceTypes
+  int squares[Board::NUM_SQUARES];
+  getPieces(squares);
+  std::string fen;
+  for (int r = Board::ROWS - 1; r >= 0; r--) {
+    int numEmpty = 0;
+    for (int c = 0; c < Board::COLS; c++) {
+      int piece = squares[r * Board::COLS + c];
+      if (piece == Board::EMPTY) {
+        numEmpty++;
+        continue;
+      }
+      if (numEmpty > 0) fen += '0' + numEmpty;
+      numEmpty = 0;
+      fen += PIECE_CHARS[piece];
+    }
+    if (numEmpty > 0) fen += '0' + numEmpty;
+    if (r > 0) fen += '/';
+  }
+  fen += (getPlayer() == Board::WHITE)? " w " : " b ";
+
+  // bit 0/1: white left/right rook, bit 2/3: black left/right rook
+  if (state & 2) fen += 'K';
+  if (state & 1) fen += 'Q';
+  if (state & 8) fen += 'k';
+  if (state & 4) fen += 'q';
+  if ((state & 15) == 0) fen += '-';
+
+  if (enPassant == NO_EN_PASSANT) {
+    fen += " -";
+  } else {
+    fen += ' ';
+    fen += 'a' + enPassant;
+    fen += (getPlayer() == Board::WHITE)? '6' : '3';
+  }
+  fen += " 0 " + std::to_string(ply / 2 + 1);
+  return fen;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                                 Writing
+////////////////////////////////////////////////////////////////////////////
+
+bool TrainingDataWriter::open(std::string path) {
+  close();
+  this->path = path;
+  numPositions = 0;
+  failed = false;
+  file = fopen(path.c_str(), "wb");
+  if (file == NULL) {
+    printf("Unable to create %s\n", path.c_str());
+    return false;
+  }
+  TrainingDataReader::Header header;
+  memcpy(header.magic, "CTDP", 4);
+  header.version = TrainingDataReader::VERSION;
+  if (fwrite(&header, sizeof(header), 1, file) != 1) {
+    printf("Unable to write %s\n", path.c_str());
+    failed = true;
+  }
+  return !failed;
+}
+
+bool TrainingDataWriter::write(const PackedPosition* positions, int count) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (file == NULL || failed) return false;
+  if (count > 0 && fwrite(positions, sizeof(PackedPosition), count, file) != count) {
+    printf("Unable to write %s\n", path.c_str());
+    failed = true;
+    return false;
+  }
+  numPositions += count;
+  return true;
+}
+
+bool TrainingDataWriter::close() {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (file == NULL) return true;
+  bool success = (fclose(file) == 0) && !failed;
+  if (!success && !failed) printf("Unable to write %s\n", path.c_str());
+  file = NULL;
+  return success;
+}
+
+////////////////////////////////////////////////////////////////////////////
+//                                 Reading
+////////////////////////////////////////////////////////////////////////////
+
+bool TrainingDataReader::open(std::string path) {
+  close();
+  if (!file.open(path)) return false;
+  const Header* header = (const Header*) file.getData();
+  if (file.getSize() < sizeof(Header) || memcmp(header->magic, "CTDP", 4) != 0) {
+    printf("%s is not training data\n", path.c_str());
+    file.close();
+    return false;
+  }
+  if (header->version != VERSION || (file.getSize() - sizeof(Header)) % sizeof(PackedPosition) != 0) {
+    printf("%s has an unknown version or is truncated\n", path.c_str());
+    file.close();
+    return false;
+  }
+  positions = (const PackedPosition*) (file.getData() + sizeof(Header));
+  numPositions = (file.getSize() - sizeof(Header)) / sizeof(PackedPosition);
+  return true;
+}
+
+void TrainingDataReader::close() {
+  file.close();
+  positions = NULL;
+  numPositions = 0;
+}
@@ -0,0 +1,135 @@
+/***********************************************************************//**
+ * Scored positions for training or tuning the evaluation, in a packed binary format.
+ *
+ * The file is a header followed by one 32-byte PackedPosition per position:
+ * the occupied squares as a bitboard, the piece of each occupied square in 4 bits,
+ * the player to move, castling rights and en passant file, the search score
+ * and the result of the game. That is about half the size of the FEN alone,
+ * and positions are read without parsing any text.
+ * Numbers are stored in the machine's byte order (little endian on x86 and ARM).
+ *
+ * TrainingDataWriter appends positions from several threads.
+ * TrainingDataReader maps a file into memory and gives the positions in place,
+ * so a file of any size is streamed by the system's read ahead.
+ ***************************************************************************/
+
+#ifndef TRAININGDATA_H
+#define TRAININGDATA_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <mutex>
+#include <string>
+
+#include "Board.h"
+#include "MappedFile.h"
+
+struct PackedPosition {
+  uint64_t occupancy; /**< Bit s is set if square s (0 -> 63) has a piece */
+  uint8_t pieces[16]; /**< The pieces (Board::PieceTypes) of the occupied squares in ascending order, 2 per byte, low bits first */
+  int16_t score; /**< The search score in centipawns, for the player to move */
+  uint8_t state; /**< Bits 0 -> 3: castling rights (as Board::getCastlingRights), bit 4: black to move */
+  uint8_t enPassant; /**< The file of a pawn that just double jumped, NO_EN_PASSANT if none */
+  int8_t result; /**< The result of the game for the player to move: 1 win, 0 draw, -1 loss */
+  uint8_t reserved; /**< 0 */
+  uint16_t ply; /**< The number of half-turns played before the position */
+
+  static const int MAX_PIECES = 32;
+  static const uint8_t NO_EN_PASSANT = 8;
+
+  /**
+   * Pack the board's position.
+   * @param score: the search score for the player to move.
+   * @param result: the result for the player to move (1, 0 or -1).
+   * @param ply: the number of half-turns played before the position.
+   * @return false if the board has more than MAX_PIECES pieces (the position is not packed).
+   */
+  bool pack(Board& b, int score, int result, int ply);
+
+  /**
+   * @return the player to move, Board::WHITE or Board::BLACK.
+   */
+  int getPlayer() const { return (state & 16)? Board::BLACK : Board::WHITE; }
+
+  /**
+   * Unpack the pieces, without going through a Board.
+   * @param squares: receives the piece of each square, Board::EMPTY if none.
+   */
+  void getPieces(int squares[Board::NUM_SQUARES]) const;
+
+  /**
+   * @return the position in Forsyth-Edwards Notation, e.g. to load it in a Board.
+   */
+  std::string toFEN() const;
+};
+
+class TrainingDataWriter {
+  public:
+    TrainingDataWriter() { file = NULL; numPositions = 0; failed = false; }
+    ~TrainingDataWriter() { close(); }
+
+    /**
+     * Create a file (replacing it) and write the header.
+     * @return false if the file can't be created.
+     */
+    bool open(std::string path);
+
+    /**
+     * Append positions. Can be called by several threads at the same time:
+     * the positions of one call are written together.
+     * @return false if the file can't be written.
+     */
+    bool write(const PackedPosition* positions, int count);
+
+    /**
+     * @return false if the file couldn't be written completely.
+     */
+    bool close();
+
+    long long getNumPositions() { return numPositions; }
+
+  private:
+    FILE* file;
+    std::string path;
+    std::mutex mutex; /**< Protects file and numPositions */
+    long long numPositions;
+    bool failed; /**< A write failed */
+};
+
+class TrainingDataReader {
+  public:
+    /**
+     * The start of a file.
+     */
+    struct Header {
+      char magic[4]; /**< "CTDP" */
+      uint32_t version;
+    };
+
+    static const uint32_t VERSION = 1;
+
+    TrainingDataReader() { positions = NULL; numPositions = 0; }
+    ~TrainingDataReader() {}
+
+    /**
+     * Open a file written by TrainingDataWriter (closing the previous one).
+     * @return false if the file can't be mapped or is not training data.
+     */
+    bool open(std::string path);
+
+    void close();
+
+    /**
+     * @return all the positions (getNumPositions of them), in the mapped file.
+     */
+    const PackedPosition* getPositions() { return positions; }
+
+    uint64_t getNumPositions() { return numPositions; }
+
+  private:
+    MappedFile file;
+    const PackedPosition* positions; /**< In the mapped file, after the header */
+    uint64_t numPositions;
+};
+
+#endif // TRAININGDATA_H
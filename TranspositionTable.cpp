@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "TranspositionTable.h"
+
+TranspositionTable::TranspositionTable(int memoryMB) {
+  resize(memoryMB);
+}
+
+void TranspositionTable::resize(int memoryMB) {
+  // round down to a power of 2 so that a key can be masked into an index
+  long long numEntries = (long long) memoryMB * 1024 * 1024 / sizeof(Entry);
+  if (numEntries < BUCKET_SIZE) {
+    std::vector<Entry>().swap(entries);
+    mask = 0;
+  } else {
+    long long size = BUCKET_SIZE;
+    while (size * 2 <= numEntries) size *= 2;
+    entries.resize(size);
+    mask = (size - 1) & ~(uint64_t) (BUCKET_SIZE - 1);
+  }
+  clear();
+}
+
+void TranspositionTable::clear() {
+  for (int i = 0; i < entries.size(); i++) {
+    entries[i].key = 0;
+    entries[i].generation = 0;
+  }
+  generation = 0;
+  numProbes = 0;
+  numHits = 0;
+}
+
+void TranspositionTable::newSearch() {
+  generation++;
+}
+
+const TranspositionTable::Entry* TranspositionTable::probe(uint64_t key) {
+  if (entries.empty()) return NULL;
+  numProbes++;
+  Entry* bucket = &entries[key & mask];
+  for (int i = 0; i < BUCKET_SIZE; i++) {
+    if (bucket[i].key == key) {
+      numHits++;
+      bucket[i].generation = generation; // still useful, keep it
+      return &bucket[i];
+    }
+  }
+  return NULL;
+}
+
+void TranspositionTable::store(uint64_t key, int score, int move, int depth, int bound) {
+  if (entries.empty()) return;
+  Entry* bucket = &entries[key & mask];
+  Entry* replaced = &bucket[0];
+  for (int i = 0; i < BUCKET_SIZE; i++) {
+    if (bucket[i].key == key || bucket[i].key == 0) {
+      replaced = &bucket[i];
+      break;
+    }
+    // the oldest search first, then the shallowest entry
+    uint8_t age = generation - bucket[i].generation;
+    uint8_t replacedAge = generation - replaced->generation;
+    if (age > replacedAge || (age == replacedAge && bucket[i].depth < replaced->depth)) replaced = &bucket[i];
+  }
+  // keep the best move of a position searched again without finding one (failed low)
+  if (move == -1 && replaced->key == key) move = replaced->move;
+  replaced->key = key;
+  replaced->score = score;
+  replaced->move = move;
+  replaced->depth = depth;
+  replaced->bound = bound;
+  replaced->generation = generation;
+  replaced->unused = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  Files
+//////////////////////////////////////////////////////////////////////////
+
+bool TranspositionTable::save(std::string path) {
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == NULL) {
+    printf("Unable to create %s\n", path.c_str());
+    return false;
+  }
+  uint32_t numEntries = entries.size();
+  bool success = fwrite("CTT1", 1, 4, file) == 4
+                 && fwrite(&numEntries, sizeof(numEntries), 1, file) == 1
+                 && fwrite(&generation, sizeof(generation), 1, file) == 1
+                 && (numEntries == 0 || fwrite(&entries[0], sizeof(Entry), numEntries, file) == numEntries);
+  success = (fclose(file) == 0) && success;
+  if (!success) printf("Unable to write %s\n", path.c_str());
+  return success;
+}
+
+bool TranspositionTable::load(std::string path) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == NULL) {
+    printf("Unable to open %s\n", path.c_str());
+    return false;
+  }
+  clear();
+  char magic[4];
+  uint32_t numEntries;
+  uint8_t savedGeneration;
+  bool success = fread(magic, 1, 4, file) == 4 && memcmp(magic, "CTT1", 4) == 0
+                 && fread(&numEntries, sizeof(numEntries), 1, file) == 1
+                 && fread(&savedGeneration, sizeof(savedGeneration), 1, file) == 1;
+  if (success && numEntries == entries.size()) {
+    success = numEntries == 0 || fread(&entries[0], sizeof(Entry), numEntries, file) == numEntries;
+    generation = savedGeneration;
+  } else if (success) {
+    // another size: store the entries one by one, a block at a time
+    generation = savedGeneration;
+    std::vector<Entry> block(4096);
+    uint32_t numRead = 0;
+    while (success && numRead < numEntries) {
+      size_t count = fread(&block[0], sizeof(Entry), block.size(), file);
+      if (count == 0) success = false;
+      for (size_t i = 0; i < count && numRead < numEntries; i++, numRead++) {
+        const Entry& entry = block[i];
+        if (entry.key == 0) continue;
+        store(entry.key, entry.score, entry.move, entry.depth, entry.bound);
+      }
+    }
+  }
+  fclose(file);
+  if (!success) {
+    printf("%s is not a transposition table or is truncated\n", path.c_str());
+    clear();
+  }
+  return success;
+}
+
+//////////////////////////////////////////////////////////////////////////
+//  Statistics
+//////////////////////////////////////////////////////////////////////////
+
+int TranspositionTable::getNumEntries() {
+  return entries.size();
+}
+
+int TranspositionTable::getNumUsed() {
+  int numUsed = 0;
+  for (int i = 0; i < entries.size(); i++) {
+    if (entries[i].key != 0) numUsed++;
+  }
+  return numUsed;
+}
+
+long long TranspositionTable::getNumProbes() {
+  return numProbes;
+}
+
+long long TranspositionTable::getNumHits() {
+  return numHits;
+}
+
+void TranspositionTable::printStats() {
+  printf("Transposition table: %lld probes, %lld hits (%.1f%%), %i of %i entries used\n", numProbes, numHits,
+         (numProbes > 0)? 100.0 * numHits / numProbes : 0.0, getNumUsed(), getNumEntries());
+}
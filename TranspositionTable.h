@@ -0,0 +1,117 @@
+/***********************************************************************//**
+ * Transposition table of AIPlayer's search: the score, bound, depth and best move
+ * of searched positions, indexed by Board's Zobrist key.
+ * A position reached again (by another move order, at the next move of the game,
+ * or in another game) is cut off if it was searched deep enough, and otherwise
+ * searches its stored best move first.
+ *
+ * The table outlives a search and can be shared by the AIPlayers of
+ * successive games. It can be saved to a file and loaded at the next start,
+ * so that analysing the same openings again starts warm.
+ ***************************************************************************/
+
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class TranspositionTable {
+  public:
+    static const int DEFAULT_MEMORY_MB = 16;
+
+    /**
+     * What the stored score is, relative to the real score of the position.
+     */
+    enum Bounds {
+      BOUND_NONE,
+      BOUND_UPPER, /**< The search failed low: the real score is at most the stored one */
+      BOUND_LOWER, /**< The search failed high (cut-off): the real score is at least the stored one */
+      BOUND_EXACT
+    };
+
+    struct Entry {
+      uint64_t key; /**< The board's Zobrist key, 0 if the entry is empty */
+      int16_t score; /**< For the player to move */
+      int16_t move; /**< The best move's number in the move list, -1 if unknown */
+      uint8_t depth; /**< The depth (in half-turns) the position was searched to */
+      uint8_t bound; /**< According to Bounds */
+      uint8_t generation; /**< The search that stored the entry, modulo 256 */
+      uint8_t unused;
+    };
+
+    /**
+     * @param memoryMB: the size of the table in megabytes. 0 for an empty table, that stores nothing.
+     */
+    TranspositionTable(int memoryMB = DEFAULT_MEMORY_MB);
+    ~TranspositionTable() {}
+
+    /**
+     * Change the size of the table, and empty it.
+     * @param memoryMB: the size of the table in megabytes, rounded down to a power of 2 entries.
+     */
+    void resize(int memoryMB);
+
+    /**
+     * Empty the table and reset the statistics.
+     */
+    void clear();
+
+    /**
+     * Called at the start of each search. The entries of older searches are replaced first.
+     */
+    void newSearch();
+
+    /**
+     * @return the entry of a position, NULL if it is not in the table.
+     */
+    const Entry* probe(uint64_t key);
+
+    /**
+     * Store the result of a search. Replaces the entry of the same position, an empty entry,
+     * or the entry of the oldest search with the smallest depth.
+     * @param score: the score for the player to move.
+     * @param move: the best move's number, -1 if unknown (the previous move of the position is kept).
+     * @param depth: the searched depth.
+     * @param bound: according to Bounds.
+     */
+    void store(uint64_t key, int score, int move, int depth, int bound);
+
+    /**
+     * Write the table to a file.
+     * @return true if saved successfully.
+     */
+    bool save(std::string path);
+
+    /**
+     * Read a table written by save. Entries are stored again if the table has another size.
+     * @return false if the file can't be read or is not a table (the table is then left empty).
+     */
+    bool load(std::string path);
+
+    /***************************************************************************
+     *                               Statistics
+     ***************************************************************************/
+
+    int getNumEntries(); /**< The number of entries the table can hold */
+    int getNumUsed(); /**< The number of entries holding a position (reads the whole table) */
+    long long getNumProbes(); /**< Number of calls to probe since the last clear */
+    long long getNumHits(); /**< Number of probes that found their position */
+    /**
+     * Print the number of probes, hits and the hit rate to console.
+     */
+    void printStats();
+
+  private:
+    static const int BUCKET_SIZE = 4; /**< Number of entries a key can be stored in */
+
+    std::vector<Entry> entries;
+    uint64_t mask; /**< Index mask of the first entry of a bucket */
+    uint8_t generation;
+
+    long long numProbes;
+    long long numHits;
+};
+
+#endif // TRANSPOSITIONTABLE_H
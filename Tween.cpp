@@ -0,0 +1,51 @@
+#include "Tween.h"
+
+Tween::Tween() {
+  from = 0;
+  to = 0;
+  durationMs = 1;
+  startTicks = 0;
+  easing = LINEAR;
+  repeat = ONCE;
+  running = false;
+}
+
+void Tween::start(float from, float to, Uint32 durationMs, Uint32 now, Easing easing, Repeat repeat) {
+  this->from = from;
+  this->to = to;
+  this->durationMs = (durationMs > 0)? durationMs : 1;
+  this->startTicks = now;
+  this->easing = easing;
+  this->repeat = repeat;
+  running = true;
+}
+
+void Tween::finish() {
+  running = false;
+}
+
+bool Tween::isRunning(Uint32 now) {
+  if (!running) return false;
+  return repeat == PING_PONG || now - startTicks < durationMs;
+}
+
+float Tween::getValue(Uint32 now) {
+  if (!running) return to;
+  Uint32 elapsed = now - startTicks;
+
+  // progress from 0 (start value) to 1 (end value)
+  float t;
+  if (repeat == PING_PONG) {
+    Uint32 phase = elapsed % (2 * durationMs);
+    t = (phase < durationMs)? (float) phase / durationMs : 2 - (float) phase / durationMs;
+  } else {
+    if (elapsed >= durationMs) return to;
+    t = (float) elapsed / durationMs;
+  }
+
+  if (easing == EASE_OUT) {
+    float remaining = 1 - t;
+    t = 1 - remaining * remaining * remaining;
+  }
+  return from + (to - from) * t;
+}
@@ -0,0 +1,66 @@
+/***********************************************************************//**
+ * A value animated over time, e.g. the position of a sliding image.
+ * The value only depends on the time since the tween started, not on how many
+ * frames were drawn, so an animation takes the same time on any machine.
+ * The caller passes the time (usually FrameScheduler::getFrameTicks),
+ * so that all tweens drawn in a frame agree.
+ ***************************************************************************/
+
+#ifndef TWEEN_H
+#define TWEEN_H
+
+#include <SDL2/SDL.h>
+
+class Tween {
+  public:
+    enum Easing {
+      LINEAR,
+      EASE_OUT, /**< Fast at the start, slows down at the end (cubic) */
+    };
+
+    enum Repeat {
+      ONCE, /**< Stops at the end value */
+      PING_PONG, /**< Goes back and forth between the values until finish() */
+    };
+
+    /**
+     * A tween that is not running, with the value 0.
+     */
+    Tween();
+    ~Tween() {}
+
+    /**
+     * Start animating the value.
+     * @param from, to: the start and end values.
+     * @param durationMs: the time from the start value to the end value, in milliseconds.
+     * @param now: the current time (SDL_GetTicks).
+     */
+    void start(float from, float to, Uint32 durationMs, Uint32 now, Easing easing = EASE_OUT, Repeat repeat = ONCE);
+
+    /**
+     * Stop the animation at its end value, e.g. when the user clicks to skip it.
+     */
+    void finish();
+
+    /**
+     * @param now: the current time (SDL_GetTicks).
+     * @return true until the end value is reached (never for PING_PONG), or finish() is called.
+     */
+    bool isRunning(Uint32 now);
+
+    /**
+     * @param now: the current time (SDL_GetTicks).
+     * @return the value at this time, the end value once the tween is finished.
+     */
+    float getValue(Uint32 now);
+
+  private:
+    float from, to;
+    Uint32 durationMs;
+    Uint32 startTicks; /**< When the tween started (SDL_GetTicks) */
+    Easing easing;
+    Repeat repeat;
+    bool running; /**< False once finish() is called */
+};
+
+#endif // TWEEN_H
@@ -6,18 +6,26 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
+#include <signal.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
 
 #include "AIPlayer.h"
 #include "Board.h"
 #include "BoardGUI.h"
 #include "ChooseComGUI.h"
 #include "EndGUI.h"
+#include "GameServer.h"
 #include "GUI.h"
 #include "HumanPlayer.h"
+#include "NNUE.h"
 #include "Player.h"
 #include "RandomPlayer.h"
+#include "ResourceManager.h"
 #include "StartGUI.h"
+#include "TranspositionTable.h"
 
 
 /*******************************************************************
@@ -53,21 +61,68 @@ void quitGraphic(SDL_Window* window, SDL_Renderer* rederer);
 int playGame(Board* b, Player** players, BoardGUI* bgui, SDL_Renderer* renderer);
 
 
+/*******************************************************************
+ *                        Headless server
+ *******************************************************************/
+
+/**
+ * Serve games over local sockets (GameServer) without opening a window, until interrupted (Ctrl+C).
+ * Options: --threads N (searches at the same time), --sessions N, --budget ms (thinking time per game),
+ * --nnue <weight file>.
+ * @param address: a TCP port on 127.0.0.1, or unix:<path> for a Unix domain socket.
+ * @return the exit code.
+ */
+int runServer(int argc, char* argv[], const char* address);
+
+
 
 int main(int argc, char* argv[]) {
+  // Headless server: chess --server <port | unix:path> [options]
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], "--server") == 0) return runServer(argc, argv, argv[i+1]);
+  }
+
+  // Optional startup time, printed when the first frame is drawn: chess --timing
+  bool printTiming = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--timing") == 0) printTiming = true;
+  }
+  std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
   SDL_Window* window;
   SDL_Renderer* renderer;
   if( !initGraphic(window, renderer) ) return 0; //quit if cannot initialize graphic
 
+  // Optional neural network evaluation: chess --nnue <weight file>
+  // Optional saved search table, loaded now (if it exists) and saved when quitting: chess --tt <file>
+  NNUE nnue;
+  TranspositionTable table; // kept from game to game
+  const char* tablePath = NULL;
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], "--nnue") == 0 && nnue.loadFromFile(argv[i+1])) {
+      printf("Using neural network evaluation from %s (%s)\n", argv[i+1], NNUE::getInstructionSet());
+    }
+    if (strcmp(argv[i], "--tt") == 0) {
+      tablePath = argv[i+1];
+      FILE* file = fopen(tablePath, "rb");
+      if (file != NULL) {
+        fclose(file);
+        if (table.load(tablePath)) printf("Loaded search table from %s\n", tablePath);
+      }
+    }
+  }
 
-  // Init GUIs and board
+  // Init GUIs and board.
+  // Only the start screen is waited for, the other screens load in the background while it is shown.
   Board b;
 
   GUI::quit = false;
-  StartGUI sgui(renderer);
-  ChooseComGUI cgui(renderer);
-  BoardGUI bgui(&b, renderer);
-  EndGUI egui(renderer);
+  ResourceManager resources(renderer);
+  StartGUI sgui(resources);
+  resources.build();
+  ChooseComGUI cgui(resources);
+  BoardGUI bgui(&b, renderer, resources);
+  EndGUI egui(resources);
+  bool firstFrame = printTiming;
 
   Player** players = new Player*[2];
 
@@ -76,11 +131,20 @@ int main(int argc, char* argv[]) {
   while (true) {
     sgui.playMusic();
     b.initBoard(); //new board every game
-    sgui.draw(renderer);
+    sgui.startAnimation();
     do {
-      input = sgui.getInput();
+      sgui.drawFrame(renderer);
+      if (firstFrame) {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        printf("First frame after %.0f ms\n", ms);
+        firstFrame = false;
+      }
+      // sleep until the user clicks, the next animation frame, or the loading workers finish
+      input = sgui.waitInput();
+      if (resources.isLoaded()) resources.build(); // upload the other screens while the user is idle
     } while (input == 0 && !GUI::quit);
     if (GUI::quit) break;
+    resources.build(); // wait for the other screens, if the user is faster than the disk
 
     if(input == StartGUI::INPUT_QUIT) {
       break;
@@ -90,13 +154,13 @@ int main(int argc, char* argv[]) {
       bgui.setPlayer(Board::BOTH_COLOR);
       egui.setPlayer(Board::BOTH_COLOR);
     } else {
-      cgui.openingAnimation(renderer);
-      cgui.draw(renderer);
+      cgui.startOpeningAnimation();
       // get which player
 
       int comPlayer, difficulty;
       do {
-        input = cgui.getInput();
+        cgui.drawFrame(renderer);
+        input = cgui.waitInput();
       } while (input == 0 && !GUI::quit);
       if (GUI::quit) break;
 
@@ -108,11 +172,18 @@ int main(int argc, char* argv[]) {
         case ChooseComGUI::INPUT_BLACK_MEDIUM: comPlayer = Board::BLACK; difficulty = 4; break;
         case ChooseComGUI::INPUT_BLACK_HARD  : comPlayer = Board::BLACK; difficulty = 6; break;
       }
-      players[comPlayer] = new AIPlayer(&b, &bgui, difficulty);
+      AIPlayer* ai = new AIPlayer(&b, &bgui, difficulty);
+      if (nnue.isLoaded()) ai->setNNUE(&nnue);
+      ai->setTranspositionTable(&table);
+      players[comPlayer] = ai;
       players[1-comPlayer] = new HumanPlayer(&bgui, &b);
       bgui.setPlayer(1-comPlayer);
       egui.setPlayer(1-comPlayer);
-      cgui.endingAnimation(renderer);
+      cgui.startEndingAnimation();
+      do {
+        cgui.drawFrame(renderer);
+        cgui.waitInput(); // a click skips the animation
+      } while (cgui.isAnimating() && !GUI::quit);
     }
 
     sgui.stopMusic();
@@ -138,8 +209,9 @@ int main(int argc, char* argv[]) {
     }
     egui.draw(renderer);
     do {
-      input = egui.getInput();
-    } while (input == 0);
+      input = egui.getInput(GUI::IDLE_TIMEOUT_MS);
+    } while (input == 0 && !GUI::quit);
+    if (GUI::quit) break;
   }
 
   delete[] players;
@@ -147,19 +219,60 @@ int main(int argc, char* argv[]) {
   sgui.destroyMedia();
   bgui.destroyMedia();
   egui.destroyMedia();
+  resources.destroyMedia();
+  if (tablePath != NULL) table.save(tablePath);
 
   quitGraphic(window, renderer);
 
   return 0;
 }
 
+static GameServer* server = NULL; /**< The server stopped by Ctrl+C */
+
+static void stopServer(int signal) {
+  if (server != NULL) server->stop();
+}
+
+int runServer(int argc, char* argv[], const char* address) {
+  int numThreads = 0;
+  int maxSessions = GameServer::DEFAULT_MAX_SESSIONS;
+  int timeBudgetMs = GameServer::DEFAULT_TIME_BUDGET_MS;
+  NNUE nnue;
+  bool useNNUE = false;
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], "--threads") == 0) numThreads = atoi(argv[i+1]);
+    if (strcmp(argv[i], "--sessions") == 0) maxSessions = atoi(argv[i+1]);
+    if (strcmp(argv[i], "--budget") == 0) timeBudgetMs = atoi(argv[i+1]);
+    if (strcmp(argv[i], "--nnue") == 0 && nnue.loadFromFile(argv[i+1])) {
+      printf("Using neural network evaluation from %s (%s)\n", argv[i+1], NNUE::getInstructionSet());
+      useNNUE = true;
+    }
+  }
+
+  GameServer gameServer(numThreads, maxSessions, timeBudgetMs);
+  if (useNNUE) gameServer.setNNUE(&nnue);
+  bool listening = (strncmp(address, "unix:", 5) == 0)? gameServer.listenUnix(address + 5)
+                                                       : gameServer.listenTCP(atoi(address));
+  if (!listening) return 1;
+  server = &gameServer;
+  signal(SIGINT, stopServer);
+  signal(SIGTERM, stopServer);
+  gameServer.run();
+  server = NULL;
+  printf("Server stopped\n");
+  return 0;
+}
+
 int playGame(Board* b, Player** players, BoardGUI* bgui, SDL_Renderer* renderer) {
   int numUndo[2] = {-1, -1};
   int curPlayer, input;
   int gameLength = 0; // increase every time a move is made
 
-  bgui->draw(renderer);
+  bgui->requestRedraw();
+  bgui->drawFrame();
 
+  // Players sleep until an input or a frame is due (HumanPlayer), or until the search finishes (AIPlayer),
+  // and the board is only drawn when it changed or the move pointers are animating.
   while (b->getNumMoves() != 0) { // continue as long as the game haven't ended
     curPlayer = b->getPlayer();
 
@@ -198,18 +311,20 @@ int playGame(Board* b, Player** players, BoardGUI* bgui, SDL_Renderer* renderer)
         }
       }
       bgui->updateMovePointers();
+      if (input != 0) bgui->requestRedraw();
     } else {
     //if is AI, the value returned is a move number. Make the move, and process input queue to catch quitting event.
       if (input == -1) return -1; // AI returns -1 when user quit during AI thinking
       b->makeMove(input);
+      bgui->requestRedraw();
     }
 
     if (b->getGameLength() != gameLength) {
       gameLength = b->getGameLength();
       bgui->playMoveSFX();
     }
-    // draw board
-    bgui->draw(renderer);
+    // draw board if needed
+    bgui->drawFrame();
   }
   SDL_Delay(3000);
   return (b->getWinner());
@@ -239,7 +354,8 @@ bool initGraphic(SDL_Window* &window, SDL_Renderer* &renderer) {
   }
 
   // Create renderer
-  renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+  // vsync: presenting a frame waits for the display, which paces the animations
+  renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
   if(renderer == NULL) {
     printf("Failed to create renderer. SDL error: %s\n", SDL_GetError());
     return false;
@@ -0,0 +1,55 @@
+/******************************************************//**
+ * Analysis of a position with several lines (MultiPV).
+ * Usage: analyze <FEN> [depth] [lines] [time ms] [table file]
+ * Prints the best lines of the last completed depth, with their scores in centipawns
+ * from the perspective of the player to move.
+ * With a table file, the search's transposition table is loaded from it (if it exists)
+ * and saved to it afterwards, so analysing the same position again starts warm.
+ **********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include "../AIPlayer.h"
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    printf("Usage: %s <FEN> [depth] [lines] [time ms] [table file]\n", argv[0]);
+    return 1;
+  }
+  int depth = (argc > 2)? atoi(argv[2]) : 5;
+  int lines = (argc > 3)? atoi(argv[3]) : 3;
+  int timeMs = (argc > 4)? atoi(argv[4]) : 0;
+  const char* tablePath = (argc > 5)? argv[5] : NULL;
+
+  Board b;
+  if (!b.loadFEN(argv[1])) {
+    printf("Invalid FEN: %s\n", argv[1]);
+    return 1;
+  }
+  TranspositionTable table;
+  if (tablePath != NULL) {
+    FILE* file = fopen(tablePath, "rb");
+    if (file != NULL) {
+      fclose(file);
+      table.load(tablePath);
+    }
+  }
+  AIPlayer ai(&b, NULL, depth);
+  ai.setLimits(depth, 0, timeMs);
+  ai.setMultiPV(lines);
+  ai.setTranspositionTable(&table);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  if (ai.decideMove() == -1) {
+    printf("No legal move\n");
+    return 0;
+  }
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  for (int i = 0; i < ai.getNumPVLines(); i++) {
+    printf("%2i. %6i  %s\n", i + 1, ai.getPVLine(i).score, ai.getPVLineSAN(i).c_str());
+  }
+  printf("%lld nodes in %.0f ms\n", ai.getNumNodes(), ms);
+  if (tablePath != NULL) table.save(tablePath);
+  return 0;
+}
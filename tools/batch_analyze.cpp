@@ -0,0 +1,75 @@
+/******************************************************//**
+ * Analysis of many positions on all cores.
+ * Usage: batch_analyze <positions file> [depth] [nodes] [time ms] [threads]
+ * The positions file has one FEN per line. Limits of 0 mean no limit.
+ * Prints one line per position, in the order of the file, as soon as it and the
+ * previous ones are searched: the position's number, the best move, the score in
+ * centipawns from the perspective of the player to move, the depth, the nodes and the
+ * principal variation, in SAN.
+ **********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../BatchAnalyzer.h"
+
+/**
+ * Prints the results, and counts their nodes.
+ */
+class ResultPrinter : public BatchAnalyzer::Listener {
+  public:
+    long long numNodes;
+
+    ResultPrinter() { numNodes = 0; }
+
+    void onResult(const BatchAnalyzer::Result& result) {
+      if (!result.valid) {
+        printf("%i\tinvalid\n", result.index + 1);
+      } else if (result.bestMove.empty()) {
+        printf("%i\tnone\n", result.index + 1);
+      } else {
+        printf("%i\t%s\t%i\t%i\t%lld\t%s\n", result.index + 1, result.bestMove.c_str(), result.score,
+               result.depth, result.nodes, result.pv.c_str());
+      }
+      fflush(stdout);
+      numNodes += result.nodes;
+    }
+};
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    printf("Usage: %s <positions file> [depth] [nodes] [time ms] [threads]\n", argv[0]);
+    return 1;
+  }
+  int depth = (argc > 2)? atoi(argv[2]) : 6;
+  long long nodes = (argc > 3)? atoll(argv[3]) : 0;
+  int timeMs = (argc > 4)? atoi(argv[4]) : 0;
+  int threads = (argc > 5)? atoi(argv[5]) : 0;
+  if (depth <= 0) depth = 64;
+
+  std::ifstream file(argv[1]);
+  if (!file) {
+    printf("Unable to open %s\n", argv[1]);
+    return 1;
+  }
+  std::vector<std::string> fens;
+  std::string line;
+  while (std::getline(file, line)) {
+    if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+    if (!line.empty()) fens.push_back(line);
+  }
+
+  BatchAnalyzer analyzer(threads);
+  analyzer.setLimits(depth, nodes, timeMs);
+  ResultPrinter printer;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  analyzer.analyze(fens, &printer);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("%i positions, %lld nodes in %.2f s with %i threads\n", (int) fens.size(), printer.numNodes,
+         seconds, analyzer.getNumThreads());
+  return 0;
+}
@@ -0,0 +1,30 @@
+/******************************************************//**
+ * EPD test suite runner.
+ * Usage: epd_runner <suite.epd> [depth] [time ms] [nodes] [threads] [results file] [baseline file]
+ * A limit of 0 means no limit. Prints the solved positions,
+ * with their time and nodes to solution.
+ **********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../EPDRunner.h"
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    printf("Usage: %s <suite.epd> [depth] [time ms] [nodes] [threads] [results file] [baseline file]\n", argv[0]);
+    return 1;
+  }
+  int maxDepth = (argc > 2)? atoi(argv[2]) : 64;
+  int maxTimeMs = (argc > 3)? atoi(argv[3]) : 1000;
+  long long maxNodes = (argc > 4)? atoll(argv[4]) : 0;
+  int numThreads = (argc > 5)? atoi(argv[5]) : 1;
+
+  EPDRunner runner(numThreads);
+  if (!runner.loadSuite(argv[1])) return 1;
+  runner.run(maxDepth, maxNodes, maxTimeMs);
+  runner.printReport();
+  if (argc > 6 && !runner.saveResults(argv[6])) return 1;
+  if (argc > 7 && !runner.compareWithBaseline(argv[7])) return 1;
+  return 0;
+}
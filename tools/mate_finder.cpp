@@ -0,0 +1,64 @@
+/******************************************************//**
+ * Batch mate finder.
+ * Usage: mate_finder <positions.epd> [max moves] [max nodes] [memory MB]
+ * Each line has the 4 first FEN fields, optionally followed by EPD operations.
+ * A "dm" (direct mate) operation sets the move limit of its position,
+ * otherwise max moves is used (0 for no limit).
+ * Prints "mate in N" with one of the shortest mating lines, or "mate found (N-move line)"
+ * when the node limit stopped the search for a shorter mate.
+ **********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include "../EPDRunner.h"
+#include "../MateSolver.h"
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    printf("Usage: %s <positions.epd> [max moves] [max nodes] [memory MB]\n", argv[0]);
+    return 1;
+  }
+  int maxMoves = (argc > 2)? atoi(argv[2]) : 0;
+  long long maxNodes = (argc > 3)? atoll(argv[3]) : 10000000;
+  int memoryMB = (argc > 4)? atoi(argv[4]) : 64;
+
+  FILE* file = fopen(argv[1], "r");
+  if (file == NULL) {
+    printf("Unable to open position file %s\n", argv[1]);
+    return 1;
+  }
+  MateSolver solver(memoryMB);
+  Board b;
+  char buffer[1024];
+  int numPositions = 0, numMates = 0;
+  while (fgets(buffer, sizeof(buffer), file) != NULL) {
+    std::string fen;
+    std::map<std::string, std::vector<std::string> > operations;
+    if (!EPDRunner::parseLine(buffer, fen, operations) || !b.loadFEN(fen)) continue;
+    std::string id = operations["id"].empty()? fen : operations["id"][0];
+    int moves = operations["dm"].empty()? maxMoves : atoi(operations["dm"][0].c_str());
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    solver.clear();
+    int result = solver.solveShortest(&b, moves, maxNodes);
+    int timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    numPositions++;
+    if (result == MateSolver::MATE_FOUND) {
+      numMates++;
+      int length = (solver.getMateLine().size() + 1) / 2;
+      if (solver.isShortest()) printf("%s: mate in %i: %s", id.c_str(), length, solver.getMateLineSAN().c_str());
+      else printf("%s: mate found (%i-move line): %s", id.c_str(), length, solver.getMateLineSAN().c_str());
+    } else if (result == MateSolver::NO_MATE) {
+      printf("%s: no mate", id.c_str());
+    } else {
+      printf("%s: no mate found (node limit)", id.c_str());
+    }
+    printf(" (%lld nodes, %i ms)\n", solver.getNumNodes(), timeMs);
+  }
+  fclose(file);
+  printf("Mates found: %i / %i\n", numMates, numPositions);
+  return 0;
+}
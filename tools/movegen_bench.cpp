@@ -0,0 +1,168 @@
+/******************************************************//**
+ * Benchmark of move generation, making and undoing moves.
+ * Usage: movegen_bench [depth] [positions file]
+ * The positions file has one FEN per line (a few standard positions are used by default).
+ * Runs perft on every position and reports nodes per second.
+ * On Linux, also reads the hardware counters (branches, branch misses, instructions)
+ * around the run, when the kernel allows it (perf_event_paranoid).
+ * Only uses the public Board API, so that it can be built against older versions of Board
+ * to compare them.
+ **********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "../Board.h"
+
+static const char* DEFAULT_POSITIONS[] = {
+  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+  "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+  "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+  "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"
+};
+
+//////////////////////////////////////////////////////////////////////////
+//  Hardware counters
+//////////////////////////////////////////////////////////////////////////
+
+/**
+ * A group of hardware counters, read together.
+ * All counts are -1 when the counters are not available.
+ */
+class Counters {
+  public:
+    static const int NUM_COUNTERS = 3;
+    long long counts[NUM_COUNTERS]; /**< branches, branch misses, instructions */
+
+    Counters() {
+      for (int i = 0; i < NUM_COUNTERS; i++) {
+        fds[i] = -1;
+        counts[i] = -1;
+      }
+#ifdef __linux__
+      const unsigned long long configs[NUM_COUNTERS] = {
+        PERF_COUNT_HW_BRANCH_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_INSTRUCTIONS
+      };
+      for (int i = 0; i < NUM_COUNTERS; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = configs[i];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fds[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+      }
+#endif
+    }
+
+    ~Counters() {
+#ifdef __linux__
+      for (int i = 0; i < NUM_COUNTERS; i++) {
+        if (fds[i] != -1) close(fds[i]);
+      }
+#endif
+    }
+
+    void start() {
+#ifdef __linux__
+      for (int i = 0; i < NUM_COUNTERS; i++) {
+        if (fds[i] == -1) continue;
+        ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+      }
+#endif
+    }
+
+    void stop() {
+#ifdef __linux__
+      for (int i = 0; i < NUM_COUNTERS; i++) {
+        if (fds[i] == -1) continue;
+        ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        long long value;
+        if (read(fds[i], &value, sizeof(value)) == sizeof(value)) counts[i] = value;
+      }
+#endif
+    }
+
+  private:
+    int fds[NUM_COUNTERS];
+};
+
+//////////////////////////////////////////////////////////////////////////
+//  Perft
+//////////////////////////////////////////////////////////////////////////
+
+static long long perft(Board& b, int depth) {
+  int numMoves = b.getNumMoves();
+  if (depth == 1) return numMoves;
+  long long nodes = 0;
+  for (int m = 0; m < numMoves; m++) {
+    b.makeMove(m);
+    nodes += perft(b, depth - 1);
+    b.undoMove();
+  }
+  return nodes;
+}
+
+int main(int argc, char* argv[]) {
+  int depth = (argc > 1)? atoi(argv[1]) : 4;
+  if (depth < 1) depth = 1;
+
+  std::vector<std::string> fens;
+  if (argc > 2) {
+    FILE* file = fopen(argv[2], "r");
+    if (file == NULL) {
+      printf("Unable to open position file %s\n", argv[2]);
+      return 1;
+    }
+    char buffer[512];
+    while (fgets(buffer, sizeof(buffer), file) != NULL) {
+      fens.push_back(buffer);
+    }
+    fclose(file);
+  } else {
+    for (int i = 0; i < sizeof(DEFAULT_POSITIONS) / sizeof(DEFAULT_POSITIONS[0]); i++) {
+      fens.push_back(DEFAULT_POSITIONS[i]);
+    }
+  }
+
+  Counters counters;
+  long long totalNodes = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  counters.start();
+  for (int i = 0; i < fens.size(); i++) {
+    Board b;
+    if (!b.loadFEN(fens[i])) continue;
+    totalNodes += perft(b, depth);
+  }
+  counters.stop();
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  printf("depth %i: %lld nodes in %.0f ms, %.0f nodes/s\n", depth, totalNodes, ms, totalNodes / ms * 1000);
+  if (counters.counts[0] < 0 || counters.counts[1] < 0) {
+    printf("hardware counters unavailable\n");
+    return 0;
+  }
+  printf("branches:      %14lld (%.1f per node)\n", counters.counts[0], (double) counters.counts[0] / totalNodes);
+  printf("branch misses: %14lld (%.2f per node, %.2f%% of branches)\n", counters.counts[1],
+         (double) counters.counts[1] / totalNodes, 100.0 * counters.counts[1] / counters.counts[0]);
+  if (counters.counts[2] >= 0) {
+    printf("instructions:  %14lld (%.1f per node)\n", counters.counts[2], (double) counters.counts[2] / totalNodes);
+  }
+  return 0;
+}
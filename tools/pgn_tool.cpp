@@ -0,0 +1,84 @@
+/******************************************************//**
+ * Reads a PGN file, checks that all moves are legal, and reports the speed.
+ * Usage: pgn_tool <games.pgn> [threads] [output.pgn]
+ * With an output file, the valid games are written again in PGN export format
+ * (in the order of the file only with 1 thread).
+ **********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "../PGN.h"
+
+/**
+ * Counts the results, and writes the valid games to the output file.
+ */
+class GameCounter : public PGNListener {
+  public:
+    GameCounter(int numThreads, FILE* output) : results(numThreads, std::vector<long long>(4, 0)), writers(numThreads) {
+      this->output = output;
+      texts.resize(numThreads);
+    }
+
+    void onGame(const PGNGame& game, int thread) {
+      if (!game.valid) return;
+      results[thread][game.result + 1]++;
+      if (output == NULL) return;
+      writers[thread].format(game, texts[thread]);
+      std::lock_guard<std::mutex> lock(outputMutex);
+      fwrite(texts[thread].data(), 1, texts[thread].size(), output);
+    }
+
+    /**
+     * @param result: -1 (unknown), Board::WHITE, Board::BLACK or Board::BOTH_COLOR
+     */
+    long long getNumResults(int result) {
+      long long count = 0;
+      for (int t = 0; t < results.size(); t++) count += results[t][result + 1];
+      return count;
+    }
+
+  private:
+    std::vector<std::vector<long long> > results; /**< Per thread, by result + 1 */
+    std::vector<PGNWriter> writers;
+    std::vector<std::string> texts;
+    FILE* output;
+    std::mutex outputMutex;
+};
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    printf("Usage: %s <games.pgn> [threads] [output.pgn]\n", argv[0]);
+    return 1;
+  }
+  int numThreads = (argc > 2)? atoi(argv[2]) : 0;
+  FILE* output = NULL;
+  if (argc > 3) {
+    output = fopen(argv[3], "wb");
+    if (output == NULL) {
+      printf("Unable to create %s\n", argv[3]);
+      return 1;
+    }
+  }
+
+  PGNReader reader(numThreads);
+  GameCounter counter(reader.getNumThreads(), output);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  bool success = reader.read(argv[1], &counter);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if (output != NULL) fclose(output);
+  if (!success) return 1;
+
+  printf("%lld games (%lld invalid), %lld moves, in %.2f s with %i threads\n", reader.getNumGames(),
+         reader.getNumInvalidGames(), reader.getNumMoves(), seconds, reader.getNumThreads());
+  printf("White wins %lld, black wins %lld, draws %lld, unknown %lld\n", counter.getNumResults(Board::WHITE),
+         counter.getNumResults(Board::BLACK), counter.getNumResults(Board::BOTH_COLOR), counter.getNumResults(-1));
+  if (seconds > 0) {
+    printf("%.0f games/s, %.0f moves/s, %.1f MB/s\n", reader.getNumGames() / seconds,
+           reader.getNumMoves() / seconds, reader.getNumBytes() / seconds / (1 << 20));
+  }
+  return 0;
+}
@@ -0,0 +1,92 @@
+/******************************************************//**
+ * Builds and queries opening books in the Polyglot format (PolyglotBook).
+ * Usage:
+ *   polyglot_book build <book.bin> <games.pgn>... [--ply N] [--min-games N] [--threads N] [--memory MB]
+ *   polyglot_book query <book.bin> [FEN | moves in SAN from the starting position]
+ * Both refuse to run if the keys don't match the test positions of Polyglot's specification.
+ * query prints the book moves of the position with their weights.
+ **********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../PolyglotBook.h"
+
+static int build(int argc, char* argv[]) {
+  std::vector<std::string> pgnPaths;
+  int maxPly = PolyglotBookBuilder::DEFAULT_MAX_PLY;
+  int minGames = PolyglotBookBuilder::DEFAULT_MIN_GAMES;
+  int numThreads = 0;
+  int memoryMB = PolyglotBookBuilder::DEFAULT_MEMORY_MB;
+  for (int i = 3; i < argc; i++) {
+    if (strcmp(argv[i], "--ply") == 0 && i + 1 < argc) maxPly = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--min-games") == 0 && i + 1 < argc) minGames = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) numThreads = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc) memoryMB = atoi(argv[++i]);
+    else pgnPaths.push_back(argv[i]);
+  }
+  PolyglotBookBuilder builder(maxPly, minGames, numThreads, memoryMB);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  if (!builder.build(pgnPaths, argv[2])) return 1;
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("%lld games, %lld positions, %lld moves (%i run files), in %.1f s\n", builder.getNumGames(),
+         builder.getNumPositions(), builder.getNumEntries(), builder.getNumRuns(), seconds);
+  return 0;
+}
+
+static int query(int argc, char* argv[]) {
+  PolyglotBook book;
+  if (!book.open(argv[2])) return 1;
+  printf("%llu moves\n", (unsigned long long) book.getNumEntries());
+
+  Board b;
+  b.initBoard();
+  if (argc > 3 && strchr(argv[3], '/') != NULL) {
+    if (!b.loadFEN(argv[3])) {
+      printf("Invalid FEN: %s\n", argv[3]);
+      return 1;
+    }
+  } else {
+    for (int i = 3; i < argc; i++) {
+      int move = b.findMoveSAN(argv[i]);
+      if (move == -1) {
+        printf("Illegal move: %s\n", argv[i]);
+        return 1;
+      }
+      b.makeMove(move);
+    }
+  }
+
+  uint64_t key = PolyglotBook::getKey(b);
+  std::vector<PolyglotBook::Entry> moves;
+  if (book.find(key, moves) == 0) {
+    printf("Position %016llx not found\n", (unsigned long long) key);
+    return 0;
+  }
+  int totalWeight = 0;
+  for (int i = 0; i < moves.size(); i++) totalWeight += moves[i].weight;
+  printf("Position %016llx\n", (unsigned long long) key);
+  for (int i = 0; i < moves.size(); i++) {
+    int move = PolyglotBook::decodeMove(b, moves[i].move);
+    printf("%-8s weight %5i  %5.1f%%\n", (move == -1)? "?" : b.getMoveSAN(move).c_str(), moves[i].weight,
+           100.0 * moves[i].weight / totalWeight);
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 3 || (strcmp(argv[1], "build") == 0 && argc < 4)) {
+    printf("Usage: %s build <book.bin> <games.pgn>... [--ply N] [--min-games N] [--threads N] [--memory MB]\n", argv[0]);
+    printf("       %s query <book.bin> [FEN | moves in SAN]\n", argv[0]);
+    return 1;
+  }
+  if (!PolyglotBook::checkKeys()) return 1;
+  if (strcmp(argv[1], "build") == 0) return build(argc, argv);
+  if (strcmp(argv[1], "query") == 0) return query(argc, argv);
+  printf("Unknown command %s\n", argv[1]);
+  return 1;
+}
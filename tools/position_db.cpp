@@ -0,0 +1,136 @@
+/******************************************************//**
+ * Builds and queries a position database (PositionDB).
+ * Usage:
+ *   position_db build <db file> <games.pgn>... [--ply N] [--threads N] [--memory MB]
+ *   position_db query <db file> [FEN | moves in SAN from the starting position]
+ *   position_db bench <db file> [lookups]
+ * query prints the moves played from the position with their results,
+ * bench measures the time of a lookup of random positions of the database.
+ **********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../PositionDB.h"
+
+static void printResults(const char* name, const PositionDB::Entry& entry) {
+  double games = (double) entry.whiteWins + entry.draws + entry.blackWins;
+  printf("%-8s %10.0f games  white %5.1f%%  draw %5.1f%%  black %5.1f%%\n", name, games,
+         100 * entry.whiteWins / games, 100 * entry.draws / games, 100 * entry.blackWins / games);
+}
+
+static bool gamesMore(const PositionDB::Entry& a, const PositionDB::Entry& b) {
+  return (long long) a.whiteWins + a.draws + a.blackWins > (long long) b.whiteWins + b.draws + b.blackWins;
+}
+
+static int build(int argc, char* argv[]) {
+  std::vector<std::string> pgnPaths;
+  int maxPly = PositionDBBuilder::DEFAULT_MAX_PLY;
+  int numThreads = 0;
+  int memoryMB = PositionDBBuilder::DEFAULT_MEMORY_MB;
+  for (int i = 3; i < argc; i++) {
+    if (strcmp(argv[i], "--ply") == 0 && i + 1 < argc) maxPly = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) numThreads = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc) memoryMB = atoi(argv[++i]);
+    else pgnPaths.push_back(argv[i]);
+  }
+  PositionDBBuilder builder(maxPly, numThreads, memoryMB);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  if (!builder.build(pgnPaths, argv[2])) return 1;
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("%lld games, %lld entries, in %.1f s\n", builder.getNumGames(), builder.getNumEntries(), seconds);
+  return 0;
+}
+
+static int query(PositionDB& db, int argc, char* argv[]) {
+  Board b;
+  b.initBoard();
+  if (argc > 3 && strchr(argv[3], '/') != NULL) {
+    if (!b.loadFEN(argv[3])) {
+      printf("Invalid FEN: %s\n", argv[3]);
+      return 1;
+    }
+  } else {
+    for (int i = 3; i < argc; i++) {
+      int move = b.findMoveSAN(argv[i]);
+      if (move == -1) {
+        printf("Illegal move: %s\n", argv[i]);
+        return 1;
+      }
+      b.makeMove(move);
+    }
+  }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  const PositionDB::Entry* first;
+  int numEntries = db.find(b.getHashKey(), first);
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  if (numEntries == 0) {
+    printf("Position not found (%.1f us)\n", us);
+    return 0;
+  }
+
+  PositionDB::Entry total;
+  db.getTotal(b.getHashKey(), total);
+  printResults("Total", total);
+  std::vector<PositionDB::Entry> moves(first, first + numEntries);
+  std::stable_sort(moves.begin(), moves.end(), gamesMore);
+  for (int i = 0; i < moves.size(); i++) {
+    if (moves[i].move == PositionDB::NO_MOVE) {
+      printResults("(end)", moves[i]);
+      continue;
+    }
+    int move = PositionDB::decodeMove(b, moves[i].move);
+    printResults((move == -1)? "?" : b.getMoveSAN(move).c_str(), moves[i]);
+  }
+  printf("Lookup: %.1f us\n", us);
+  return 0;
+}
+
+static int bench(PositionDB& db, int argc, char* argv[]) {
+  int numLookups = (argc > 3)? atoi(argv[3]) : 1000000;
+  if (db.getNumEntries() == 0 || numLookups <= 0) return 0;
+  // pick the keys first, so that only the lookups are timed: half positions of the database, half random keys
+  const PositionDB::Entry* entries = db.getEntries();
+  std::mt19937_64 random(1);
+  std::vector<uint64_t> keys(numLookups);
+  for (int i = 0; i < numLookups; i++) {
+    keys[i] = (i % 2 == 0)? entries[random() % db.getNumEntries()].key : random();
+  }
+
+  long long numFound = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < numLookups; i++) {
+    const PositionDB::Entry* found;
+    numFound += db.find(keys[i], found) > 0;
+  }
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  printf("%i lookups (%lld found) in %llu entries: %.2f us per lookup\n", numLookups, numFound,
+         (unsigned long long) db.getNumEntries(), us / numLookups);
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 3 || (strcmp(argv[1], "build") == 0 && argc < 4)) {
+    printf("Usage: %s build <db file> <games.pgn>... [--ply N] [--threads N] [--memory MB]\n", argv[0]);
+    printf("       %s query <db file> [FEN | moves in SAN]\n", argv[0]);
+    printf("       %s bench <db file> [lookups]\n", argv[0]);
+    return 1;
+  }
+  if (strcmp(argv[1], "build") == 0) return build(argc, argv);
+
+  PositionDB db;
+  if (!db.open(argv[2])) return 1;
+  printf("%llu games, %llu entries, up to ply %i\n", (unsigned long long) db.getNumGames(),
+         (unsigned long long) db.getNumEntries(), db.getMaxPly());
+  if (strcmp(argv[1], "query") == 0) return query(db, argc, argv);
+  if (strcmp(argv[1], "bench") == 0) return bench(db, argc, argv);
+  printf("Unknown command %s\n", argv[1]);
+  return 1;
+}
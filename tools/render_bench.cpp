@@ -0,0 +1,158 @@
+/******************************************************//**
+ * Benchmark of BoardGUI::draw, without a display.
+ * Usage: render_bench [frames per position] [positions file]
+ * Must be run from the game's directory (it loads img/ like the game).
+ * Draws offscreen with SDL's software renderer (OffscreenRenderer).
+ * Replays a recorded game (the Opera game by default, or one FEN per line from the file).
+ * For every position, draws one frame right after the position changed (the cached board
+ * is drawn again), then frames with a piece chosen (the move pointers are animating).
+ * Reports the percentiles of the frame times of both kinds of frames.
+ **********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../Board.h"
+#include "../BoardGUI.h"
+#include "../OffscreenRenderer.h"
+#include "../ResourceManager.h"
+
+static const int SCREEN_WIDTH = 800;
+static const int SCREEN_HEIGHT = 600;
+
+/**
+ * Morphy - Duke of Brunswick and Count Isouard, Paris 1858.
+ */
+static const char* DEFAULT_GAME[] = {
+  "e4", "e5", "Nf3", "d6", "d4", "Bg4", "dxe5", "Bxf3", "Qxf3", "dxe5", "Bc4", "Nf6",
+  "Qb3", "Qe7", "Nc3", "c6", "Bg5", "b5", "Nxb5", "cxb5", "Bxb5", "Nbd7", "O-O-O", "Rd8",
+  "Rxd7", "Rxd7", "Rd1", "Qe6", "Bxd7", "Nxd7", "Qb8", "Nxb8", "Rd8"
+};
+
+/**
+ * @return the SAN of a move without its check or mate sign.
+ */
+static std::string stripCheck(std::string san) {
+  while (!san.empty() && (san[san.size() - 1] == '+' || san[san.size() - 1] == '#')) san.erase(san.size() - 1);
+  return san;
+}
+
+/**
+ * Replay the default game, and save its positions.
+ */
+static void loadDefaultGame(std::vector<Board>& positions) {
+  Board b;
+  b.initBoard();
+  positions.push_back(b);
+  for (int i = 0; i < sizeof(DEFAULT_GAME) / sizeof(DEFAULT_GAME[0]); i++) {
+    int move = -1;
+    for (int m = 0; m < b.getNumMoves(); m++) {
+      if (stripCheck(b.getMoveSAN(m)) == DEFAULT_GAME[i]) move = m;
+    }
+    if (move == -1) {
+      printf("Illegal move in the default game: %s\n", DEFAULT_GAME[i]);
+      return;
+    }
+    b.makeMove(move);
+    positions.push_back(b);
+  }
+}
+
+/**
+ * Print the percentiles of frame times.
+ * @param times: in microseconds, sorted by this function.
+ */
+static void printPercentiles(const char* name, std::vector<double>& times) {
+  if (times.empty()) return;
+  std::sort(times.begin(), times.end());
+  double sum = 0;
+  for (int i = 0; i < times.size(); i++) sum += times[i];
+  int n = times.size();
+  printf("%-10s %6i frames  mean %8.1f  p50 %8.1f  p90 %8.1f  p99 %8.1f  max %8.1f us\n", name, n, sum / n,
+         times[n / 2], times[n * 9 / 10], times[std::min(n - 1, n * 99 / 100)], times[n - 1]);
+}
+
+/**
+ * @return the time taken by one BoardGUI::draw, in microseconds.
+ */
+static double timeFrame(BoardGUI& bgui, SDL_Renderer* renderer) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  bgui.draw(renderer);
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+  int framesPerPosition = (argc > 1)? atoi(argv[1]) : 100;
+  if (framesPerPosition < 1) framesPerPosition = 1;
+
+  std::vector<Board> positions;
+  if (argc > 2) {
+    FILE* file = fopen(argv[2], "r");
+    if (file == NULL) {
+      printf("Unable to open position file %s\n", argv[2]);
+      return 1;
+    }
+    char buffer[512];
+    while (fgets(buffer, sizeof(buffer), file) != NULL) {
+      Board position;
+      if (position.loadFEN(buffer)) positions.push_back(position);
+    }
+    fclose(file);
+  } else {
+    loadDefaultGame(positions);
+  }
+
+  OffscreenRenderer offscreen;
+  if (!offscreen.init(SCREEN_WIDTH, SCREEN_HEIGHT)) return 1;
+  SDL_Renderer* renderer = offscreen.getRenderer();
+
+  Board b;
+  ResourceManager resources(renderer);
+  BoardGUI bgui(&b, renderer, resources);
+  resources.build();
+  bgui.setPlayer(Board::BOTH_COLOR);
+
+  std::vector<double> changedTimes, animatingTimes;
+  for (int i = 0; i < positions.size(); i++) {
+    b = positions[i];
+    bgui.updateMovePointers();
+    changedTimes.push_back(timeFrame(bgui, renderer));
+
+    // choose the first piece that can move, and let its move pointers animate
+    for (int square = 0; square < Board::NUM_SQUARES && b.getChosenSquare() == -1; square++) {
+      std::vector<int> moves;
+      b.getMovesFromSquare(moves, square);
+      if (!moves.empty()) b.chooseSquare(square);
+    }
+    bgui.updateMovePointers();
+    for (int f = 1; f < framesPerPosition; f++) {
+      animatingTimes.push_back(timeFrame(bgui, renderer));
+    }
+  }
+
+  printf("%i positions, %ix%i software renderer\n", (int) positions.size(), SCREEN_WIDTH, SCREEN_HEIGHT);
+  std::vector<double> allTimes(changedTimes);
+  allTimes.insert(allTimes.end(), animatingTimes.begin(), animatingTimes.end());
+  printPercentiles("changed", changedTimes);
+  printPercentiles("animating", animatingTimes);
+  printPercentiles("all", allTimes);
+
+  // a checksum of the last frame, to check that something was drawn (and compare builds)
+  SDL_Surface* surface = offscreen.getSurface();
+  if (surface->pixels != NULL) {
+    unsigned long long checksum = 0;
+    const Uint8* pixels = (const Uint8*) surface->pixels;
+    for (int y = 0; y < surface->h; y++) {
+      for (int x = 0; x < surface->w * 4; x++) checksum = checksum * 31 + pixels[y * surface->pitch + x];
+    }
+    printf("last frame checksum %016llx\n", checksum);
+  }
+
+  bgui.destroyMedia();
+  resources.destroyMedia();
+  return 0;
+}
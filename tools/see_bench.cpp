@@ -0,0 +1,102 @@
+/******************************************************//**
+ * Microbenchmark of Board::see.
+ * Usage: see_bench [positions file] [iterations]
+ * The positions file has one FEN per line (a few standard positions are used by default).
+ * Measures static exchange evaluations per second over all captures of the positions,
+ * next to making and undoing the same captures (what move ordering used to cost).
+ **********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../Board.h"
+
+static const char* DEFAULT_POSITIONS[] = {
+  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+  "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+  "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1",
+  "rnbqkb1r/pp1p1ppp/4pn2/2p5/2PP4/2N5/PP2PPPP/R1BQKBNR w KQkq - 0 4",
+  "r1bq1rk1/pp2nppp/2n1p3/3pP3/1b1P4/2NB1N2/PP3PPP/R1BQK2R w KQ - 0 9",
+  "2r2rk1/1bqnbppp/p2ppn2/1p6/3NPP2/1BN1B3/PPP1Q1PP/2KR3R w - - 0 14"
+};
+
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+  std::vector<std::string> fens;
+  if (argc > 1) {
+    FILE* file = fopen(argv[1], "r");
+    if (file == NULL) {
+      printf("Unable to open position file %s\n", argv[1]);
+      return 1;
+    }
+    char buffer[512];
+    while (fgets(buffer, sizeof(buffer), file) != NULL) {
+      fens.push_back(buffer);
+    }
+    fclose(file);
+  } else {
+    for (int i = 0; i < sizeof(DEFAULT_POSITIONS) / sizeof(DEFAULT_POSITIONS[0]); i++) {
+      fens.push_back(DEFAULT_POSITIONS[i]);
+    }
+  }
+  int iterations = (argc > 2)? atoi(argv[2]) : 20000;
+
+  // keep the positions with at least one capture
+  std::vector<Board> boards;
+  long long numCaptures = 0;
+  for (int i = 0; i < fens.size(); i++) {
+    Board b;
+    if (!b.loadFEN(fens[i])) continue;
+    int captures = 0;
+    for (int m = 0; m < b.getNumMoves(); m++) {
+      if (b.isCapture(m)) captures++;
+    }
+    if (captures == 0) continue;
+    numCaptures += captures;
+    boards.push_back(b);
+  }
+  if (boards.empty()) {
+    printf("No position with captures\n");
+    return 1;
+  }
+  printf("%i positions, %lld captures, %i iterations\n", (int) boards.size(), numCaptures, iterations);
+
+  long long checksum = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int it = 0; it < iterations; it++) {
+    for (int i = 0; i < boards.size(); i++) {
+      Board& b = boards[i];
+      for (int m = 0; m < b.getNumMoves(); m++) {
+        if (b.isCapture(m)) checksum += b.see(m);
+      }
+    }
+  }
+  double seeMs = elapsedMs(start);
+
+  start = std::chrono::steady_clock::now();
+  for (int it = 0; it < iterations / 10 + 1; it++) {
+    for (int i = 0; i < boards.size(); i++) {
+      Board& b = boards[i];
+      for (int m = 0; m < b.getNumMoves(); m++) {
+        if (!b.isCapture(m)) continue;
+        b.makeMove(m);
+        checksum += b.getNumMoves();
+        b.undoMove();
+      }
+    }
+  }
+  double makeMs = elapsedMs(start);
+
+  double seePerSecond = numCaptures * iterations / seeMs * 1000;
+  double makePerSecond = numCaptures * (iterations / 10 + 1) / makeMs * 1000;
+  printf("see:         %12.0f calls/s (%.1f ns/call)\n", seePerSecond, 1e9 / seePerSecond);
+  printf("make + undo: %12.0f moves/s (%.1f ns/move)\n", makePerSecond, 1e9 / makePerSecond);
+  printf("checksum %lld\n", checksum);
+  return 0;
+}
@@ -0,0 +1,78 @@
+/******************************************************//**
+ * Generates and reads training data (SelfPlay, TrainingData).
+ * Usage:
+ *   selfplay generate <output file> <games> [depth] [nodes] [threads] [random plies] [seed]
+ *   selfplay read <data file> [positions to print]
+ * generate plays AIPlayer against itself (a limit of 0 means no limit),
+ * read streams a file back, prints its first positions as FEN with their score
+ * and result, and reports the number of positions read per second.
+ **********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "../SelfPlay.h"
+#include "../TrainingData.h"
+
+static int generate(int argc, char* argv[]) {
+  int numGames = atoi(argv[3]);
+  int maxDepth = (argc > 4)? atoi(argv[4]) : 6;
+  long long maxNodes = (argc > 5)? atoll(argv[5]) : 0;
+  int numThreads = (argc > 6)? atoi(argv[6]) : 0;
+  int randomPlies = (argc > 7)? atoi(argv[7]) : SelfPlay::DEFAULT_RANDOM_PLIES;
+  uint64_t seed = (argc > 8)? strtoull(argv[8], NULL, 10) : 1;
+  if (maxDepth <= 0) maxDepth = 64;
+
+  SelfPlay selfPlay(numThreads);
+  selfPlay.setLimits(maxDepth, maxNodes);
+  selfPlay.setOpenings(randomPlies, seed);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  bool success = selfPlay.run(numGames, argv[2]);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("%lld games (white %lld, black %lld, draws %lld), %lld positions, in %.1f s\n", selfPlay.getNumGames(),
+         selfPlay.getNumWins(Board::WHITE), selfPlay.getNumWins(Board::BLACK), selfPlay.getNumWins(Board::BOTH_COLOR),
+         selfPlay.getNumPositions(), seconds);
+  return success? 0 : 1;
+}
+
+static int readData(int argc, char* argv[]) {
+  TrainingDataReader reader;
+  if (!reader.open(argv[2])) return 1;
+  int numPrinted = (argc > 3)? atoi(argv[3]) : 10;
+  const PackedPosition* positions = reader.getPositions();
+  uint64_t numPositions = reader.getNumPositions();
+  for (uint64_t i = 0; i < numPositions && i < numPrinted; i++) {
+    printf("%s  score %i  result %i\n", positions[i].toFEN().c_str(), positions[i].score, positions[i].result);
+  }
+
+  // unpack every position, as a trainer would
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  long long numResults[3] = {0, 0, 0};
+  long long numPieces = 0;
+  int squares[Board::NUM_SQUARES];
+  for (uint64_t i = 0; i < numPositions; i++) {
+    positions[i].getPieces(squares);
+    for (int s = 0; s < Board::NUM_SQUARES; s++) numPieces += squares[s] != Board::EMPTY;
+    numResults[positions[i].result + 1]++;
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("%llu positions (%lld wins, %lld draws, %lld losses for the player to move), %.1f pieces per position\n",
+         (unsigned long long) numPositions, numResults[2], numResults[1], numResults[0],
+         (numPositions > 0)? (double) numPieces / numPositions : 0.0);
+  printf("Read in %.3f s: %.1f million positions per second\n", seconds, numPositions / seconds / 1e6);
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 3 || (strcmp(argv[1], "generate") == 0 && argc < 4)) {
+    printf("Usage: %s generate <output file> <games> [depth] [nodes] [threads] [random plies] [seed]\n", argv[0]);
+    printf("       %s read <data file> [positions to print]\n", argv[0]);
+    return 1;
+  }
+  if (strcmp(argv[1], "generate") == 0) return generate(argc, argv);
+  if (strcmp(argv[1], "read") == 0) return readData(argc, argv);
+  printf("Unknown command %s\n", argv[1]);
+  return 1;
+}
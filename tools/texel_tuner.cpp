@@ -0,0 +1,27 @@
+/******************************************************//**
+ * Texel tuner for AIPlayer's evaluation tables.
+ * Usage: texel_tuner <positions file> [epochs] [output file] [threads]
+ * The positions file has one "FEN result" per line.
+ **********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../TexelTuner.h"
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    printf("Usage: %s <positions file> [epochs] [output file] [threads]\n", argv[0]);
+    return 1;
+  }
+  int numEpochs = (argc > 2)? atoi(argv[2]) : 1000;
+  const char* output = (argc > 3)? argv[3] : "tuned_values.txt";
+  int numThreads = (argc > 4)? atoi(argv[4]) : 0;
+
+  TexelTuner tuner(numThreads);
+  if (!tuner.loadPositions(argv[1])) return 1;
+  tuner.tune(numEpochs);
+  if (!tuner.writeParameters(output)) return 1;
+  printf("Parameters written to %s\n", output);
+  return 0;
+}